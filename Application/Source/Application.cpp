@@ -9,6 +9,7 @@
 //Include the standard C++ headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "Scene1.h"
 #include "Scene2.h"
@@ -22,6 +23,10 @@
 #include "MouseController.h"
 #include "SceneGUI.h"
 #include "SceneText.h"
+#include "AssetStreamer.h"
+#include "AssetCache.h"
+#include "LoadTGA.h"
+#include "UniformBlocks.h"
 
 // WIU includes
 #include "Scene01.h"
@@ -32,6 +37,9 @@
 GLFWwindow* m_window;
 const unsigned char FPS = 144; // FPS of this game
 const unsigned int frameTime = 1000 / FPS; // time for each frame
+const double uploadBudget = 0.004; // seconds per frame for streamed asset uploads
+const double physicsStep = 1.0 / 120.0; // seconds per scene FixedUpdate
+const unsigned maxPhysicsSubsteps = 5; // FixedUpdates a frame may run to catch up
 
 //Define an error callback
 static void error_callback(int error, const char* description)
@@ -71,15 +79,40 @@ void resize_callback(GLFWwindow* window, int w, int h)
 	glViewport(0, 0, w, h); //update opengl the new window size
 }
 
+// Exit one scene and Init the next, reporting how long the switch blocked for
+static void SwitchScene(Scene* from, Scene* to)
+{
+	StopWatch switchTimer;
+	AssetCache::GetInstance()->ResetStats();
+	switchTimer.startTimer();
+
+	from->Exit();
+	to->Init();
+
+	std::cout << "Scene switch took " << switchTimer.getElapsedTime() * 1000.0 << " ms (asset cache: "
+		<< AssetCache::GetInstance()->GetHitCount() << " hits, "
+		<< AssetCache::GetInstance()->GetMissCount() << " misses, "
+		<< AssetCache::GetInstance()->GetTextureBytes() / (1024.0 * 1024.0) << " MB of textures)\n";
+}
+
 bool Application::IsKeyPressed(unsigned short key)
 {
     return ((GetAsyncKeyState(key) & 0x8001) != 0);
 }
 
 Application::Application()
+	: fixedStep(physicsStep)
+	, maxSubsteps(maxPhysicsSubsteps)
+	, accumulator(0.0)
 {
 }
 
+void Application::SetFixedStep(double step, unsigned maxSubsteps)
+{
+	fixedStep = step;
+	this->maxSubsteps = maxSubsteps;
+}
+
 Application::~Application()
 {
 }
@@ -166,17 +199,37 @@ void Application::Run()
 	bool isEnterUp = false;
 
 	m_timer.startTimer();    // Start timer to calculate how long it takes to render this frame
+	accumulator = 0.0;
 
 	while (!glfwWindowShouldClose(m_window) && !IsKeyPressed(VK_ESCAPE))
 	{
-		scene->Update(m_timer.getElapsedTime());
+		// Finish GL uploads for assets loaded in the background
+		AssetStreamer::GetInstance()->Update(uploadBudget);
+
+		double dt = m_timer.getElapsedTime();
+		scene->Update(dt);
+
+		// Physics always advances by fixedStep, however long the frame took. After
+		// a spike the steps stop at maxSubsteps and the rest of the time is dropped,
+		// rather than spending the next frames catching up.
+		accumulator += dt;
+		unsigned substeps = 0;
+		while (accumulator >= fixedStep && substeps < maxSubsteps)
+		{
+			scene->FixedUpdate(fixedStep);
+			accumulator -= fixedStep;
+			++substeps;
+		}
+		if (accumulator >= fixedStep)
+			accumulator = fmod(accumulator, fixedStep);
+		scene->SetInterpolation(static_cast<float>(accumulator / fixedStep));
 		scene->Render();
+		Scene* frameScene = scene;
 
 		// === FROM MAIN MENU TO SCENE01 ===
 		if (!isEnterUp && KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_1)) {
 			if (sceneNum == SCENE_GUI) {
-				scene1->Exit();
-				scene2->Init();
+				SwitchScene(scene1, scene2);
 				PlaySound(NULL, 0, 0);
 				scene = scene2;
 				sceneNum = SCENE_01;
@@ -190,8 +243,7 @@ void Application::Run()
 		// === FROM MAIN MENU TO SCENE02 ===
 		if (!isEnterUp && KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_2)) {
 			if (sceneNum == SCENE_GUI) {
-				scene1->Exit();
-				scene3->Init();
+				SwitchScene(scene1, scene3);
 				PlaySound(NULL, 0, 0);
 				scene = scene3;
 				sceneNum = SCENE_02;
@@ -205,8 +257,7 @@ void Application::Run()
 		// === FROM MAIN MENU TO SCENE03 ===
 		if (!isEnterUp && KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_3)) {
 			if (sceneNum == SCENE_GUI) {
-				scene1->Exit();
-				scene4->Init();
+				SwitchScene(scene1, scene4);
 				PlaySound(NULL, 0, 0);
 				scene = scene4;
 				sceneNum = SCENE_03;
@@ -220,8 +271,7 @@ void Application::Run()
 		// === FROM MAIN MENU TO SCENE04 ===
 		if (!isEnterUp && KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_4)) {
 			if (sceneNum == SCENE_GUI) {
-				scene1->Exit();
-				scene5->Init();
+				SwitchScene(scene1, scene5);
 				PlaySound(NULL, 0, 0);
 				scene = scene5;
 				sceneNum = SCENE_04;
@@ -235,8 +285,7 @@ void Application::Run()
 		// === FROM SCENE01 to MAIN MENU ===
 		if (!isEnterUp && KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_BACKSPACE)) {
 			if (sceneNum == SCENE_01) {
-				scene2->Exit();
-				scene1->Init();
+				SwitchScene(scene2, scene1);
 				PlaySound(NULL, 0, 0);
 				scene = scene1;
 				sceneNum = SCENE_04;
@@ -267,6 +316,13 @@ void Application::Run()
 			glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 		}
 
+		// Leave the time the new scene's Init took out of its first step
+		if (scene != frameScene)
+		{
+			m_timer.getElapsedTime();
+			accumulator = 0.0;
+		}
+
 		//Swap buffers
 		glfwSwapBuffers(m_window);
 		KeyboardController::GetInstance()->PostUpdate();
@@ -297,6 +353,10 @@ void Application::Run()
 void Application::Exit()
 {
 	KeyboardController::DestroyInstance();
+	AssetCache::DestroyInstance();
+	AssetStreamer::DestroyInstance();
+	UniformBlocks::DestroyInstance();
+	ReleaseTGAUploadBuffers();
 
 	//Close OpenGL window and terminate GLFW
 	glfwDestroyWindow(m_window);
@@ -23,12 +23,19 @@ public:
 	void Run();
 	void Exit();
 	static bool IsKeyPressed(unsigned short key);
+	// Step scene physics every step seconds, at most maxSubsteps times a frame
+	void SetFixedStep(double step, unsigned maxSubsteps);
 
 private:
 
 	//Declare a window object
 	StopWatch m_timer;
 
+	// Frame time not yet simulated, consumed fixedStep at a time
+	double fixedStep;
+	unsigned maxSubsteps;
+	double accumulator;
+
 	bool enablePointer = true;
 	bool showPointer = true;
 
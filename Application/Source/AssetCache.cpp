@@ -0,0 +1,350 @@
+#include "AssetCache.h"
+#include "AssetStreamer.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+#include "LoadTGA.h"
+
+AssetCache* AssetCache::m_instance = nullptr;
+
+AssetCache::AssetCache(void)
+	: budget(256 * 1024 * 1024)
+	, unusedBytes(0)
+	, hits(0)
+	, misses(0)
+{
+}
+
+AssetCache::~AssetCache(void)
+{
+	// Destroying a mesh releases its textures, which could evict and erase
+	// entries mid-loop; so walk a detached copy with eviction off, meshes
+	// first so every texture is freed exactly once afterwards
+	std::map<std::string, Entry*> remaining;
+	remaining.swap(entries);
+	budget = static_cast<size_t>(-1);
+	for (std::map<std::string, Entry*>::iterator it = remaining.begin(); it != remaining.end(); ++it)
+	{
+		if (it->second->mesh != nullptr)
+			Destroy(it->second);
+	}
+	for (std::map<std::string, Entry*>::iterator it = remaining.begin(); it != remaining.end(); ++it)
+	{
+		if (it->second->mesh == nullptr)
+			Destroy(it->second);
+	}
+	textureEntries.clear();
+	meshEntries.clear();
+	unused.clear();
+}
+
+AssetCache* AssetCache::GetInstance(void)
+{
+	if (m_instance == nullptr) {
+		m_instance = new AssetCache();
+	}
+
+	return m_instance;
+}
+
+void AssetCache::DestroyInstance(void)
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get a shared texture for a TGA file, loading it only if it is not cached
+
+\param file_path - TGA file
+\param streamed - load through AssetStreamer instead of blocking
+
+\return Texture name, or 0 if a blocking load failed
+*/
+/******************************************************************************/
+GLuint AssetCache::AcquireTexture(const std::string& file_path, bool streamed)
+{
+	std::string key = "tga:" + file_path;
+	std::map<std::string, Entry*>::iterator it = entries.find(key);
+	if (it != entries.end())
+	{
+		++hits;
+		Retain(it->second);
+		return it->second->texture;
+	}
+
+	++misses;
+	GLuint texture = streamed ? LoadTGAAsync(file_path.c_str()) : LoadTGA(file_path.c_str());
+	if (texture == 0)
+		return 0;
+
+	Entry* entry = new Entry();
+	entry->key = key;
+	entry->mesh = nullptr;
+	entry->texture = texture;
+	entry->refCount = 1;
+	entry->bytes = 0;
+	entries[key] = entry;
+	textureEntries[texture] = entry;
+	return texture;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Give back a texture. Textures the cache does not know are deleted straight
+away, which is what Mesh's destructor relies on.
+*/
+/******************************************************************************/
+void AssetCache::ReleaseTexture(GLuint texture)
+{
+	if (texture == 0)
+		return;
+
+	std::map<GLuint, Entry*>::iterator it = textureEntries.find(texture);
+	if (it == textureEntries.end())
+	{
+		AssetStreamer::GetInstance()->Cancel(texture);
+		glDeleteTextures(1, &texture);
+		return;
+	}
+	Release(it->second);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get a shared mesh for an OBJ/MTL pair drawn with a texture, loading it only
+if it is not cached. The texture is part of the key, so holders that texture
+the same model differently get separate meshes, and textureID must not be
+changed by a holder. It stays with the mesh until the mesh is freed.
+
+\param meshName - name of mesh, used when it has to be loaded
+\param file_path - OBJ file
+\param mtl_path - MTL file
+\param texture_path - TGA for textureID, or empty for none
+\param streamed - load through AssetStreamer instead of blocking
+
+\return Pointer to the mesh, or NULL if a blocking load failed
+*/
+/******************************************************************************/
+Mesh* AssetCache::AcquireOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path,
+	const std::string& texture_path, bool streamed)
+{
+	std::string key = "obj:" + file_path + "|" + mtl_path + "|" + texture_path;
+	std::map<std::string, Entry*>::iterator it = entries.find(key);
+	if (it != entries.end())
+	{
+		++hits;
+		Retain(it->second);
+		return it->second->mesh;
+	}
+
+	++misses;
+	Mesh* mesh = streamed ? MeshBuilder::GenerateOBJMTLAsync(meshName, file_path, mtl_path)
+		: MeshBuilder::GenerateOBJMTL(meshName, file_path, mtl_path);
+	if (mesh == nullptr)
+		return nullptr;
+	if (!texture_path.empty())
+		mesh->textureID = AcquireTexture(texture_path, streamed);
+
+	Entry* entry = new Entry();
+	entry->key = key;
+	entry->mesh = mesh;
+	entry->texture = 0;
+	entry->refCount = 1;
+	entry->bytes = 0;
+	entries[key] = entry;
+	meshEntries[mesh] = entry;
+	return mesh;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get a shared primitive, building it only if it is not cached
+
+\param key - shape and every parameter that changes its vertices
+\param build - makes the mesh on a miss
+
+\return Pointer to the mesh, or NULL if build failed
+*/
+/******************************************************************************/
+Mesh* AssetCache::AcquirePrimitive(const std::string& key, const std::function<Mesh*()>& build)
+{
+	std::string primitiveKey = "prim:" + key;
+	std::map<std::string, Entry*>::iterator it = entries.find(primitiveKey);
+	if (it != entries.end())
+	{
+		++hits;
+		Retain(it->second);
+		return it->second->mesh;
+	}
+
+	++misses;
+	Mesh* mesh = build();
+	if (mesh == nullptr)
+		return nullptr;
+
+	Entry* entry = new Entry();
+	entry->key = primitiveKey;
+	entry->mesh = mesh;
+	entry->texture = 0;
+	entry->refCount = 1;
+	entry->bytes = 0;
+	entries[primitiveKey] = entry;
+	meshEntries[mesh] = entry;
+	return mesh;
+}
+
+void AssetCache::ReleaseMesh(Mesh* mesh)
+{
+	if (mesh == nullptr)
+		return;
+
+	std::map<Mesh*, Entry*>::iterator it = meshEntries.find(mesh);
+	if (it == meshEntries.end())
+	{
+		AssetStreamer::GetInstance()->Cancel(mesh);
+		delete mesh;
+		return;
+	}
+	Release(it->second);
+}
+
+void AssetCache::SetBudget(size_t bytes)
+{
+	budget = bytes;
+	Evict();
+}
+
+void AssetCache::ResetStats(void)
+{
+	hits = 0;
+	misses = 0;
+}
+
+void AssetCache::Retain(Entry* entry)
+{
+	if (entry->refCount++ == 0)
+	{
+		unused.erase(entry->unusedIt);
+		unusedBytes -= entry->bytes;
+	}
+}
+
+void AssetCache::Release(Entry* entry)
+{
+	if (entry->refCount == 0 || --entry->refCount > 0)
+		return;
+
+	entry->bytes = GetResidentBytes(entry);
+	unusedBytes += entry->bytes;
+	unused.push_front(entry);
+	entry->unusedIt = unused.begin();
+	Evict();
+}
+
+// Free the least recently released assets until the unused ones fit the budget
+void AssetCache::Evict(void)
+{
+	while (unusedBytes > budget && !unused.empty())
+	{
+		Entry* entry = unused.back();
+		unused.pop_back();
+		unusedBytes -= entry->bytes;
+
+		entries.erase(entry->key);
+		if (entry->mesh != nullptr)
+			meshEntries.erase(entry->mesh);
+		else
+			textureEntries.erase(entry->texture);
+		Destroy(entry);
+	}
+}
+
+void AssetCache::Destroy(Entry* entry)
+{
+	if (entry->mesh != nullptr)
+	{
+		AssetStreamer::GetInstance()->Cancel(entry->mesh);
+		if (entry->mesh->textureID > 0)
+		{
+			GLuint texture = entry->mesh->textureID;
+			entry->mesh->textureID = 0;
+			ReleaseTexture(texture);
+		}
+		delete entry->mesh;
+	}
+	else
+	{
+		AssetStreamer::GetInstance()->Cancel(entry->texture);
+		glDeleteTextures(1, &entry->texture);
+	}
+	delete entry;
+}
+
+// GPU memory of a texture, every mip level summed; uncompressed texels are
+// assumed padded to 4 bytes
+static size_t GetTextureResidentBytes(GLuint texture)
+{
+	size_t bytes = 0;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	for (GLint level = 0; ; ++level)
+	{
+		GLint width = 0, height = 0, compressed = GL_FALSE;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if (width == 0 || height == 0)
+			break;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+		if (compressed == GL_TRUE)
+		{
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			bytes += static_cast<size_t>(size);
+		}
+		else
+		{
+			bytes += static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+		}
+		if (width == 1 && height == 1)
+			break;
+	}
+	return bytes;
+}
+
+// GPU memory held by an asset, read back from GL. A mesh counts its own
+// texture, which lives as long as the mesh does
+size_t AssetCache::GetResidentBytes(const Entry* entry)
+{
+	if (entry->mesh != nullptr)
+	{
+		GLint vertexBytes = 0, indexBytes = 0;
+		glBindBuffer(GL_ARRAY_BUFFER, entry->mesh->vertexBuffer);
+		glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+		// Query through GL_ARRAY_BUFFER so the bound VAO's element buffer is left alone
+		glBindBuffer(GL_ARRAY_BUFFER, entry->mesh->indexBuffer);
+		glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexBytes);
+		size_t bytes = static_cast<size_t>(vertexBytes) + static_cast<size_t>(indexBytes);
+		if (entry->mesh->textureID > 0)
+			bytes += GetTextureResidentBytes(entry->mesh->textureID);
+		return bytes;
+	}
+	return GetTextureResidentBytes(entry->texture);
+}
+
+// GPU memory of every texture currently held by a scene
+size_t AssetCache::GetTextureBytes(void)
+{
+	size_t bytes = 0;
+	for (std::map<GLuint, Entry*>::iterator it = textureEntries.begin(); it != textureEntries.end(); ++it)
+	{
+		if (it->second->refCount > 0)
+			bytes += GetResidentBytes(it->second);
+	}
+	return bytes;
+}
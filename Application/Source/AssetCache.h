@@ -0,0 +1,85 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <string>
+#include <map>
+#include <list>
+#include <functional>
+#include <GL\glew.h>
+
+class Mesh;
+
+/******************************************************************************/
+/*!
+		Class AssetCache:
+\brief	Process-wide cache of OBJ meshes and TGA textures keyed by file path,
+		and of MeshBuilder primitives keyed by shape and tessellation.
+		Scenes acquire shared handles instead of loading their own copies,
+		and release them in Exit(). Assets nobody holds stay resident for
+		the next scene until their total size exceeds the budget, then the
+		least recently released ones are freed first.
+*/
+/******************************************************************************/
+class AssetCache
+{
+public:
+	static AssetCache* GetInstance(void);
+	static void DestroyInstance(void);
+
+	// Textures; streamed loads return a white placeholder until uploaded
+	GLuint AcquireTexture(const std::string& file_path, bool streamed = false);
+	void ReleaseTexture(GLuint texture);
+
+	// OBJ/MTL meshes, one per texture they are drawn with. ReleaseMesh also deletes
+	// meshes the cache does not own, so scenes can release every entry of their meshList the same way
+	Mesh* AcquireOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path,
+		const std::string& texture_path, bool streamed = false);
+	void ReleaseMesh(Mesh* mesh);
+
+	// Procedural geometry; build runs only when key is not cached. Callers
+	// draw it through Mesh's sharing constructor rather than directly
+	Mesh* AcquirePrimitive(const std::string& key, const std::function<Mesh*()>& build);
+
+	// Bytes of GPU memory that unused assets may keep resident
+	void SetBudget(size_t bytes);
+	size_t GetUnusedBytes(void) const { return unusedBytes; }
+	size_t GetTextureBytes(void);
+
+	unsigned GetHitCount(void) const { return hits; }
+	unsigned GetMissCount(void) const { return misses; }
+	void ResetStats(void);
+
+private:
+	AssetCache(void);
+	~AssetCache(void);
+
+	struct Entry
+	{
+		std::string key;
+		Mesh* mesh;
+		GLuint texture;
+		unsigned refCount;
+		size_t bytes;
+		std::list<Entry*>::iterator unusedIt;
+	};
+
+	void Retain(Entry* entry);
+	void Release(Entry* entry);
+	void Evict(void);
+	void Destroy(Entry* entry);
+	static size_t GetResidentBytes(const Entry* entry);
+
+	static AssetCache* m_instance;
+
+	std::map<std::string, Entry*> entries;
+	std::map<GLuint, Entry*> textureEntries;
+	std::map<Mesh*, Entry*> meshEntries;
+	std::list<Entry*> unused; // refCount == 0, most recently released first
+
+	size_t budget;
+	size_t unusedBytes;
+	unsigned hits;
+	unsigned misses;
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <algorithm>
+
+#include "AssetStreamer.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+
+AssetStreamer* AssetStreamer::m_instance = nullptr;
+
+AssetStreamer::AssetStreamer(void)
+	: generation(0)
+	, quit(false)
+{
+	// Leave a core for the render thread
+	unsigned threads = std::thread::hardware_concurrency();
+	threads = threads > 2 ? threads - 1 : 1;
+	for (unsigned i = 0; i < threads; ++i)
+		workers.push_back(std::thread(&AssetStreamer::WorkerLoop, this));
+}
+
+AssetStreamer::~AssetStreamer(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+
+	CancelAll();
+}
+
+AssetStreamer* AssetStreamer::GetInstance(void)
+{
+	if (m_instance == nullptr) {
+		m_instance = new AssetStreamer();
+	}
+
+	return m_instance;
+}
+
+void AssetStreamer::DestroyInstance(void)
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Streamed version of MeshBuilder::GenerateOBJMTL. The returned mesh owns its
+buffers already but has no indices, so it draws nothing until its data has
+been uploaded.
+
+\param meshName - name of mesh
+\param file_path - OBJ file
+\param mtl_path - MTL file, or empty for an OBJ without one
+
+\return Placeholder mesh, filled in by a later Update()
+*/
+/******************************************************************************/
+Mesh* AssetStreamer::QueueOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path)
+{
+	Job* job = new Job();
+	job->type = Job::JOB_MESH;
+	job->file_path = file_path;
+	job->mtl_path = mtl_path;
+	job->mesh = new Mesh(meshName);
+	job->texture = 0;
+	job->success = false;
+	QueueJob(job);
+	return job->mesh;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Streamed version of LoadTGA
+
+\param file_path - TGA file
+
+\return Texture name holding a 1x1 white texel until the image is uploaded
+*/
+/******************************************************************************/
+GLuint AssetStreamer::QueueTGA(const std::string& file_path)
+{
+	static const GLubyte white[4] = { 255, 255, 255, 255 };
+
+	Job* job = new Job();
+	job->type = Job::JOB_TEXTURE;
+	job->file_path = file_path;
+	job->mesh = nullptr;
+	job->success = false;
+
+	glGenTextures(1, &job->texture);
+	glBindTexture(GL_TEXTURE_2D, job->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	GLuint texture = job->texture;
+	QueueJob(job);
+	return texture;
+}
+
+void AssetStreamer::QueueJob(Job* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job->generation = generation;
+		job->cancelled = false;
+		pendingJobs.push_back(job);
+	}
+	jobAvailable.notify_one();
+}
+
+void AssetStreamer::WorkerLoop(void)
+{
+	while (true)
+	{
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!quit && pendingJobs.empty())
+				jobAvailable.wait(lock);
+			if (quit)
+				return;
+			job = pendingJobs.front();
+			pendingJobs.pop_front();
+			runningJobs.push_back(job);
+		}
+
+		// CPU side only: no GL calls on worker threads
+		if (job->type == Job::JOB_MESH)
+			job->success = LoadMeshData(job->file_path.c_str(), job->mtl_path.empty() ? nullptr : job->mtl_path.c_str(), job->vertices, job->indices, job->materials, job->ranges, job->lods);
+		else
+			job->success = DecodeTGA(job->file_path.c_str(), job->image);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			runningJobs.erase(std::find(runningJobs.begin(), runningJobs.end(), job));
+			if (!job->cancelled && job->generation == generation)
+				finishedJobs.push_back(job);
+			else
+				delete job; // cancelled while it was loading
+		}
+	}
+}
+
+void AssetStreamer::UploadJob(Job& job)
+{
+	if (!job.success)
+	{
+		std::cout << "Failed to stream " << job.file_path << "\n";
+		return;
+	}
+
+	if (job.type == Job::JOB_MESH)
+	{
+		Mesh* mesh = job.mesh;
+		if (job.vertices.empty() || job.indices.empty())
+			return;
+
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, job.vertices.size() * sizeof(Vertex), &job.vertices[0], GL_STATIC_DRAW);
+		glBindVertexArray(mesh->vertexArray); // the element buffer binding belongs to the VAO
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, job.indices.size() * sizeof(GLuint), &job.indices[0], GL_STATIC_DRAW);
+		mesh->materials = job.materials;
+		mesh->materialRanges = job.ranges;
+		mesh->lods = job.lods;
+		mesh->AcquireMaterialTextures(true);
+		mesh->mode = Mesh::DRAW_TRIANGLES;
+		mesh->indexSize = BaseIndexCount(job.lods, job.indices.size());
+		mesh->ComputeBounds(&job.vertices[0], &job.indices[0], mesh->indexSize);
+	}
+	else
+	{
+		UploadTGA(job.texture, job.image);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload finished assets to GL. Call once per frame on the main thread. At
+least one asset is uploaded per call so loading always makes progress.
+
+\param budget - time in seconds that uploads may take this frame
+*/
+/******************************************************************************/
+void AssetStreamer::Update(double budget)
+{
+	double elapsed = 0.0;
+	uploadTimer.startTimer();
+	while (true)
+	{
+		Job* job = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (finishedJobs.empty())
+				return;
+			job = finishedJobs.front();
+			finishedJobs.pop_front();
+		}
+
+		UploadJob(*job);
+		delete job;
+
+		elapsed += uploadTimer.getElapsedTime();
+		if (elapsed >= budget)
+			return;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Forget every queued and finished job. Jobs a worker is still loading are
+discarded when they finish. Placeholder meshes and textures stay owned by
+whoever queued them.
+*/
+/******************************************************************************/
+void AssetStreamer::CancelAll(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++generation;
+	for (Job* job : pendingJobs)
+		delete job;
+	for (Job* job : finishedJobs)
+		delete job;
+	pendingJobs.clear();
+	finishedJobs.clear();
+}
+
+void AssetStreamer::Cancel(Mesh* mesh)
+{
+	CancelJobs(mesh, 0);
+}
+
+void AssetStreamer::Cancel(GLuint texture)
+{
+	CancelJobs(nullptr, texture);
+}
+
+void AssetStreamer::CancelJobs(Mesh* mesh, GLuint texture)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::deque<Job*>* queues[] = { &pendingJobs, &finishedJobs };
+	for (std::deque<Job*>* queue : queues)
+	{
+		for (std::deque<Job*>::iterator it = queue->begin(); it != queue->end();)
+		{
+			if ((mesh != nullptr && (*it)->mesh == mesh) || (texture != 0 && (*it)->texture == texture))
+			{
+				delete *it;
+				it = queue->erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+	for (Job* job : runningJobs)
+	{
+		if ((mesh != nullptr && job->mesh == mesh) || (texture != 0 && job->texture == texture))
+			job->cancelled = true; // the worker drops it when done
+	}
+}
+
+unsigned AssetStreamer::GetPendingCount(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<unsigned>(pendingJobs.size() + finishedJobs.size() + runningJobs.size());
+}
@@ -0,0 +1,99 @@
+#ifndef ASSET_STREAMER_H
+#define ASSET_STREAMER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <GL\glew.h>
+#include "Vertex.h"
+#include "Material.h"
+#include "MeshLod.h"
+#include "LoadTGA.h"
+#include "timer.h"
+
+class Mesh;
+
+/******************************************************************************/
+/*!
+		Class AssetStreamer:
+\brief	Loads meshes and textures in the background. File I/O and parsing
+		run on worker threads; the finished CPU buffers are uploaded to GL by
+		Update() on the main thread, a few per frame, so the scene keeps
+		rendering while it loads.
+*/
+/******************************************************************************/
+class AssetStreamer
+{
+public:
+	static AssetStreamer* GetInstance(void);
+	static void DestroyInstance(void);
+
+	Mesh* QueueOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path);
+	GLuint QueueTGA(const std::string& file_path);
+
+	// Upload finished assets until budget (in seconds) is used up
+	void Update(double budget);
+
+	// Drop every queued and finished job, e.g. before a scene deletes its meshes
+	void CancelAll(void);
+	// Drop the job streaming into one mesh or texture before it is deleted
+	void Cancel(Mesh* mesh);
+	void Cancel(GLuint texture);
+
+	unsigned GetPendingCount(void);
+
+private:
+	AssetStreamer(void);
+	~AssetStreamer(void);
+
+	struct Job
+	{
+		enum JOB_TYPE
+		{
+			JOB_MESH,
+			JOB_TEXTURE,
+		};
+
+		JOB_TYPE type;
+		unsigned generation;
+		bool cancelled;
+		std::string file_path;
+		std::string mtl_path;
+
+		// Upload targets, created on the main thread when the job is queued
+		Mesh* mesh;
+		GLuint texture;
+
+		// Filled in by the worker
+		bool success;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned> indices;
+		std::vector<Material> materials;
+		std::vector<MaterialRange> ranges;
+		std::vector<MeshLod> lods;
+		TGAImage image;
+	};
+
+	void QueueJob(Job* job);
+	void CancelJobs(Mesh* mesh, GLuint texture);
+	void WorkerLoop(void);
+	void UploadJob(Job& job);
+
+	static AssetStreamer* m_instance;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::deque<Job*> pendingJobs;
+	std::deque<Job*> finishedJobs;
+	std::vector<Job*> runningJobs;
+	unsigned generation;
+	bool quit;
+
+	StopWatch uploadTimer;
+};
+
+#endif
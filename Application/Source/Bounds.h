@@ -0,0 +1,22 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+// GLM Headers
+#include <glm\glm.hpp>
+
+#include <cfloat>
+
+// Bounding volumes of a mesh or material range, in model space
+struct Bounds
+{
+	glm::vec3 min;		// axis-aligned box
+	glm::vec3 max;
+	glm::vec3 center;	// sphere around the box centre
+	float radius;		// negative while nothing has been added
+
+	Bounds() : min(FLT_MAX), max(-FLT_MAX), center(0.f), radius(-1.f) {}
+
+	bool IsEmpty() const { return radius < 0.f; }
+};
+
+#endif
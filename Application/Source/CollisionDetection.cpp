@@ -1,6 +1,8 @@
 #include "CollisionDetection.h"
 #include <cmath>
 #include <algorithm>
+#include <cfloat>
+#include <iostream>
 
 // Positional circle-vs-circle (already present)
 bool OverlapCircle2Circle(const glm::vec3& pos1, float r1, const glm::vec3& pos2, float r2)
@@ -439,3 +441,442 @@ bool OverlapCircle2AABB(PhysicsObject& circle, float radius, PhysicsObject& box,
 	return false;
 
 }
+
+// Point start + t * move against a sphere, t in [0, 1]
+static bool SweepPoint2Sphere(const glm::vec3& start, const glm::vec3& move, const glm::vec3& centre, float radius, float& t)
+{
+	glm::vec3 m = start - centre;
+	float c = glm::dot(m, m) - radius * radius;
+	if (c <= 0.f)
+	{
+		t = 0.f;
+		return true;
+	}
+	float a = glm::dot(move, move);
+	float b = glm::dot(m, move);
+	if (a <= 1e-12f || b >= 0.f)
+		return false;
+	float disc = b * b - a * c;
+	if (disc < 0.f)
+		return false;
+	t = (-b - std::sqrt(disc)) / a;
+	return t <= 1.f;
+}
+
+// Point against the side of the cylinder around segment a-b; the end caps are left to the spheres
+static bool SweepPoint2Cylinder(const glm::vec3& start, const glm::vec3& move, const glm::vec3& a, const glm::vec3& b, float radius, float& t)
+{
+	glm::vec3 d = b - a;
+	glm::vec3 m = start - a;
+	float dd = glm::dot(d, d);
+	float md = glm::dot(m, d);
+	float nd = glm::dot(move, d);
+	float c = dd * (glm::dot(m, m) - radius * radius) - md * md;
+	if (c <= 0.f && md >= 0.f && md <= dd)
+	{
+		t = 0.f;
+		return true;
+	}
+
+	// Moving along the axis never reaches the side
+	float qa = dd * glm::dot(move, move) - nd * nd;
+	if (qa <= 1e-12f * dd)
+		return false;
+	float qb = dd * glm::dot(m, move) - nd * md;
+	float disc = qb * qb - qa * c;
+	if (disc < 0.f)
+		return false;
+	t = (-qb - std::sqrt(disc)) / qa;
+	if (t < 0.f || t > 1.f)
+		return false;
+	float s = md + t * nd;
+	return s >= 0.f && s <= dd;
+}
+
+// Point against the capsule of segment a-b, earliest of its side and end spheres
+static bool SweepPoint2Capsule(const glm::vec3& start, const glm::vec3& move, const glm::vec3& a, const glm::vec3& b, float radius, float& t)
+{
+	float best = FLT_MAX;
+	float hit;
+	if (SweepPoint2Cylinder(start, move, a, b, radius, hit))
+		best = std::min(best, hit);
+	if (SweepPoint2Sphere(start, move, a, radius, hit))
+		best = std::min(best, hit);
+	if (SweepPoint2Sphere(start, move, b, radius, hit))
+		best = std::min(best, hit);
+	if (best == FLT_MAX)
+		return false;
+	t = best;
+	return true;
+}
+
+// Box corner n: bit i set takes the max on axis i
+static glm::vec3 Corner(const glm::vec3& boxMin, const glm::vec3& boxMax, int n)
+{
+	return glm::vec3((n & 1) ? boxMax.x : boxMin.x, (n & 2) ? boxMax.y : boxMin.y, (n & 4) ? boxMax.z : boxMin.z);
+}
+
+// Direction to push point p out of the box, and how far p is outside it (negative inside)
+static glm::vec3 AABBPushOut(const glm::vec3& p, const glm::vec3& boxMin, const glm::vec3& boxMax, float& distance)
+{
+	glm::vec3 diff = p - glm::clamp(p, boxMin, boxMax);
+	distance = glm::length(diff);
+	if (distance > 1e-6f)
+		return diff / distance;
+
+	// Inside: out through the nearest face
+	glm::vec3 normal(1.f, 0.f, 0.f);
+	distance = -FLT_MAX;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (boxMin[i] - p[i] > distance)
+		{
+			distance = boxMin[i] - p[i];
+			normal = glm::vec3(0.f);
+			normal[i] = -1.f;
+		}
+		if (p[i] - boxMax[i] > distance)
+		{
+			distance = p[i] - boxMax[i];
+			normal = glm::vec3(0.f);
+			normal[i] = 1.f;
+		}
+	}
+	return normal;
+}
+
+bool SweepSphere2Plane(const glm::vec3& from, const glm::vec3& to, float radius,
+	const glm::vec3& planePoint, const glm::vec3& planeNormal, float& toi, glm::vec3& normal)
+{
+	float start = glm::dot(from - planePoint, planeNormal);
+	float end = glm::dot(to - planePoint, planeNormal);
+	normal = planeNormal;
+
+	if (start <= radius)
+	{
+		// Touching at the start counts while it moves deeper; fully behind does not
+		if (start < -radius || end >= start)
+			return false;
+		toi = 0.f;
+		return true;
+	}
+	if (end >= radius)
+		return false;
+	toi = (start - radius) / (start - end);
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Sweep a sphere against a box by sweeping its centre against the box grown
+by the radius, with rounded edges and corners. A slab test against the
+grown box gives the entry time; if the centre enters beside a face that is
+the answer, otherwise it is in an edge or corner region and the rounded
+part decides, as the capsules of the edge or of the three edges meeting at
+the corner.
+
+\param from - sphere centre at the start of the move
+\param to - sphere centre at the end
+\param radius - sphere radius
+\param boxMin - box minimum corner
+\param boxMax - box maximum corner
+\param toi - fraction of the move at first contact
+\param normal - box to sphere at contact
+
+\return
+true if the sphere touches the box during the move
+*/
+/******************************************************************************/
+bool SweepSphere2AABB(const glm::vec3& from, const glm::vec3& to, float radius,
+	const glm::vec3& boxMin, const glm::vec3& boxMax, float& toi, glm::vec3& normal)
+{
+	glm::vec3 move = to - from;
+	glm::vec3 grownMin = boxMin - glm::vec3(radius);
+	glm::vec3 grownMax = boxMax + glm::vec3(radius);
+
+	float tmin = 0.f;
+	float tmax = 1.f;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (std::fabs(move[i]) < 1e-12f)
+		{
+			if (from[i] < grownMin[i] || from[i] > grownMax[i])
+				return false;
+			continue;
+		}
+		float inverse = 1.f / move[i];
+		float t1 = (grownMin[i] - from[i]) * inverse;
+		float t2 = (grownMax[i] - from[i]) * inverse;
+		if (t1 > t2)
+			std::swap(t1, t2);
+		tmin = std::max(tmin, t1);
+		tmax = std::min(tmax, t2);
+		if (tmin > tmax)
+			return false;
+	}
+
+	glm::vec3 p = from + move * tmin;
+	int below = 0, above = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (p[i] < boxMin[i]) below |= 1 << i;
+		if (p[i] > boxMax[i]) above |= 1 << i;
+	}
+	int region = below | above;
+
+	float t = tmin;
+	if (region == 7)
+	{
+		glm::vec3 corner = Corner(boxMin, boxMax, above);
+		float best = FLT_MAX;
+		float hit;
+		for (int axis = 1; axis <= 4; axis <<= 1)
+			if (SweepPoint2Capsule(from, move, corner, Corner(boxMin, boxMax, above ^ axis), radius, hit))
+				best = std::min(best, hit);
+		if (best == FLT_MAX)
+			return false;
+		t = best;
+	}
+	else if (region & (region - 1))
+	{
+		if (!SweepPoint2Capsule(from, move, Corner(boxMin, boxMax, below ^ 7), Corner(boxMin, boxMax, above), radius, t))
+			return false;
+	}
+
+	float distance;
+	toi = t;
+	normal = AABBPushOut(from + move * t, boxMin, boxMax, distance);
+	return true;
+}
+
+bool SweepSphere2Segment(const glm::vec3& from, const glm::vec3& to, float radius,
+	const glm::vec3& segStart, const glm::vec3& segEnd, float& toi, glm::vec3& normal)
+{
+	glm::vec3 move = to - from;
+	if (!SweepPoint2Capsule(from, move, segStart, segEnd, radius, toi))
+		return false;
+
+	glm::vec3 centre = from + move * toi;
+	glm::vec3 segment = segEnd - segStart;
+	float lengthSq = glm::dot(segment, segment);
+	float s = lengthSq > 0.f ? glm::clamp(glm::dot(centre - segStart, segment) / lengthSq, 0.f, 1.f) : 0.f;
+	glm::vec3 diff = centre - (segStart + segment * s);
+	float distance = glm::length(diff);
+	if (distance > 1e-6f)
+		normal = diff / distance;
+	else if (glm::length(move) > 0.f)
+		normal = -glm::normalize(move);
+	else
+		normal = glm::vec3(0.f, 1.f, 0.f);
+	return true;
+}
+
+bool SweepSphere2AABB(PhysicsObject& sphereObj, const glm::vec3& from, PhysicsObject& boxObj, CollisionData& cd, float& toi)
+{
+	float radius = sphereObj.sizeX * 0.5f;
+	glm::vec3 halfSize(boxObj.sizeX * 0.5f, boxObj.sizeY * 0.5f, boxObj.sizeZ * 0.5f);
+	glm::vec3 boxMin = boxObj.pos - halfSize;
+	glm::vec3 boxMax = boxObj.pos + halfSize;
+
+	glm::vec3 normal;
+	if (!SweepSphere2AABB(from, sphereObj.pos, radius, boxMin, boxMax, toi, normal))
+		return false;
+
+	glm::vec3 centre = from + (sphereObj.pos - from) * toi;
+	float distance;
+	AABBPushOut(centre, boxMin, boxMax, distance);
+
+	cd.pObj1 = &sphereObj;
+	cd.pObj2 = &boxObj;
+	cd.collisionNormal = normal;
+	cd.contactPoint = centre - normal * (distance > 0.f ? distance : 0.f);
+	cd.penetration = std::max(radius - distance + SWEEP_SKIN, 0.f);
+	return true;
+}
+
+glm::vec3 ResolveSweptCollision(CollisionData& cd, const glm::vec3& from, float toi, float& remaining)
+{
+	PhysicsObject& obj = *cd.pObj1;
+	obj.pos = from + (obj.pos - from) * toi;
+	ResolveCollision(cd);
+
+	glm::vec3 start = obj.pos;
+	remaining *= 1.f - toi;
+	obj.pos += obj.vel * remaining;
+
+	// This move covered the rest of the step from the last impact, or from its start
+	obj.impactAlpha += (1.f - obj.impactAlpha) * toi;
+	obj.impactPos = start;
+	return start;
+}
+
+static int CheckSwept(const char* name, bool passed)
+{
+	std::cout << (passed ? "PASS  " : "FAIL  ") << name << "\n";
+	return passed ? 0 : 1;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Regression cases for the swept tests, each at a speed that carries the
+sphere well past the obstacle in one 1/120 s step, so the overlap tests
+at the step's end would miss every one. Covers face, edge and corner hits
+and near misses on boxes, a thin backboard, planes, segments, starting in
+contact, and a projectile stepped through ResolveSweptCollision.
+
+\return
+number of failed cases
+*/
+/******************************************************************************/
+int RunSweptCollisionChecks()
+{
+	const float dt = 1.f / 120.f;
+	const float eps = 1e-4f;
+	float toi;
+	glm::vec3 normal;
+	int failures = 0;
+
+	// Blaster ball at 2000 m/s against a 0.2 thick wall 5 m ahead: 16.7 m per step
+	{
+		glm::vec3 from(0.f, 0.f, 0.f), to = from + glm::vec3(0.f, 0.f, -2000.f) * dt;
+		glm::vec3 wallMin(-5.f, -5.f, -5.2f), wallMax(5.f, 5.f, -5.f);
+		bool hit = SweepSphere2AABB(from, to, 0.15f, wallMin, wallMax, toi, normal);
+		failures += CheckSwept("box face at 2000 m/s",
+			hit && std::fabs(toi - (5.f - 0.15f) / glm::length(to - from)) < eps && normal == glm::vec3(0.f, 0.f, 1.f));
+		failures += CheckSwept("step ends past the wall", to.z + 0.15f < wallMin.z);
+	}
+
+	// Past a box edge at 0.9 and 1.1 radii: the rounded edge decides
+	{
+		glm::vec3 boxMin(-1.f), boxMax(1.f);
+		float r = 0.5f;
+		float offset = 1.f + r * 0.9f / std::sqrt(2.f);
+		glm::vec3 from(offset, offset, -50.f), to(offset, offset, 50.f);
+		bool hit = SweepSphere2AABB(from, to, r, boxMin, boxMax, toi, normal);
+		float expected = (50.f - 1.f - r * std::sqrt(1.f - 0.81f)) / 100.f;
+		failures += CheckSwept("box edge grazed at 0.9 r",
+			hit && std::fabs(toi - expected) < eps && std::fabs(normal.z + std::sqrt(0.19f)) < 1e-3f);
+
+		offset = 1.f + r * 1.1f / std::sqrt(2.f);
+		failures += CheckSwept("box edge missed at 1.1 r",
+			!SweepSphere2AABB(glm::vec3(offset, offset, -50.f), glm::vec3(offset, offset, 50.f), r, boxMin, boxMax, toi, normal));
+	}
+
+	// Diagonally into a corner, and just past it
+	{
+		glm::vec3 boxMin(-1.f), boxMax(1.f);
+		glm::vec3 dir = glm::normalize(glm::vec3(-1.f));
+		glm::vec3 from = glm::vec3(1.f) - dir * 100.f;
+		bool hit = SweepSphere2AABB(from, glm::vec3(0.f), 0.5f, boxMin, boxMax, toi, normal);
+		failures += CheckSwept("box corner head on",
+			hit && std::fabs(toi * glm::length(from) - (100.f - 0.5f)) < 1e-2f && glm::length(normal + dir) < 1e-3f);
+
+		// Seen along the diagonal the box's outline is a hexagon whose points are the
+		// other corners, sqrt(8 / 3) from the centre
+		glm::vec3 side = glm::normalize(glm::vec3(1.f, 1.f, -2.f));
+		float outline = std::sqrt(8.f / 3.f);
+		glm::vec3 graze = from + side * (outline + 0.45f);
+		glm::vec3 pass = from + side * (outline + 0.55f);
+		failures += CheckSwept("outline corner grazed by 0.05",
+			SweepSphere2AABB(graze, graze + dir * 200.f, 0.5f, boxMin, boxMax, toi, normal));
+		failures += CheckSwept("outline corner missed by 0.05",
+			!SweepSphere2AABB(pass, pass + dir * 200.f, 0.5f, boxMin, boxMax, toi, normal));
+	}
+
+	// Basketball at 240 m/s, 2 m per step, through Scene03's zero-thickness backboard
+	{
+		glm::vec3 boardMin(-2.2f, 5.5f, 2.3f), boardMax(2.2f, 8.5f, 2.3f);
+		glm::vec3 from(0.f, 7.f, 1.f), to = from + glm::vec3(0.f, 0.f, 240.f) * dt;
+		bool hit = SweepSphere2AABB(from, to, 0.4f, boardMin, boardMax, toi, normal);
+		failures += CheckSwept("backboard at 240 m/s",
+			hit && std::fabs(toi - 0.9f / 2.f) < eps && normal == glm::vec3(0.f, 0.f, -1.f));
+		failures += CheckSwept("discrete backboard test misses it",
+			std::fabs(from.z - boardMin.z) > 0.4f && std::fabs(to.z - boardMin.z) > 0.4f);
+
+		from = glm::vec3(0.f, 7.f, 2.f);
+		hit = SweepSphere2AABB(from, from + glm::vec3(0.f, 0.f, 60.f) * dt, 0.4f, boardMin, boardMax, toi, normal);
+		failures += CheckSwept("backboard touched at the start", hit && toi == 0.f && normal == glm::vec3(0.f, 0.f, -1.f));
+	}
+
+	// Planes
+	{
+		bool hit = SweepSphere2Plane(glm::vec3(0.f, 0.f, 10.f), glm::vec3(0.f, 0.f, -10.f), 0.5f,
+			glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), toi, normal);
+		failures += CheckSwept("plane crossed head on", hit && std::fabs(toi - 0.475f) < eps);
+		failures += CheckSwept("plane left behind",
+			!SweepSphere2Plane(glm::vec3(0.f, 0.4f, 0.f), glm::vec3(0.f, 30.f, 0.f), 0.4f,
+				glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f), toi, normal));
+		hit = SweepSphere2Plane(glm::vec3(0.f, 0.4f, 0.f), glm::vec3(0.f, -30.f, 0.f), 0.4f,
+			glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f), toi, normal);
+		failures += CheckSwept("plane touched at the start", hit && toi == 0.f);
+	}
+
+	// Segments: across the middle of a thin rod, and past its end
+	{
+		glm::vec3 a(-1.f, 0.f, 0.f), b(1.f, 0.f, 0.f);
+		bool hit = SweepSphere2Segment(glm::vec3(0.f, 0.f, -20.f), glm::vec3(0.f, 0.f, 20.f), 0.1f, a, b, toi, normal);
+		failures += CheckSwept("segment side at 40 m per step",
+			hit && std::fabs(toi - 19.9f / 40.f) < eps && glm::length(normal - glm::vec3(0.f, 0.f, -1.f)) < 1e-3f);
+		hit = SweepSphere2Segment(glm::vec3(1.05f, 0.f, -20.f), glm::vec3(1.05f, 0.f, 20.f), 0.1f, a, b, toi, normal);
+		failures += CheckSwept("segment end cap", hit && normal.x > 0.f && normal.z < 0.f);
+		failures += CheckSwept("segment missed",
+			!SweepSphere2Segment(glm::vec3(1.15f, 0.f, -20.f), glm::vec3(1.15f, 0.f, 20.f), 0.1f, a, b, toi, normal));
+		hit = SweepSphere2Segment(glm::vec3(-5.f, 0.f, 0.f), glm::vec3(5.f, 0.f, 0.f), 0.1f, a, b, toi, normal);
+		failures += CheckSwept("segment end along its axis", hit && std::fabs(toi - 3.9f / 10.f) < eps);
+	}
+
+	// A projectile stepped into a wall keeps to its side, with and without the sweep
+	{
+		PhysicsObject wall(4.f, 4.f, 0.1f, glm::vec3(0.f, 0.f, -3.f), 0.f, 1.f);
+		for (int swept = 0; swept < 2; ++swept)
+		{
+			PhysicsObject ball(0.3f, 0.3f, 0.3f, glm::vec3(0.f), 1.f, 1.f);
+			ball.vel = glm::vec3(0.f, 0.f, -1500.f);
+			for (int step = 0; step < 4; ++step)
+			{
+				ball.UpdatePhysics(dt);
+				CollisionData cd;
+				if (!swept)
+				{
+					if (OverlapSphere2AABB(ball, wall, cd))
+						ResolveCollision(cd);
+					continue;
+				}
+				glm::vec3 from = ball.prevPos;
+				float remaining = dt;
+				for (int impact = 0; impact < 4 && SweepSphere2AABB(ball, from, wall, cd, toi); ++impact)
+					from = ResolveSweptCollision(cd, from, toi, remaining);
+			}
+			if (swept)
+				failures += CheckSwept("stepped projectile bounces off the wall", ball.pos.z > -2.95f && ball.vel.z > 0.f);
+			else
+				failures += CheckSwept("stepped projectile passes through without the sweep", ball.pos.z < -3.05f);
+		}
+
+		// Drawn between steps, the bounced ball starts where the step did and turns at the wall
+		PhysicsObject ball(0.3f, 0.3f, 0.3f, glm::vec3(0.f), 1.f, 1.f);
+		ball.vel = glm::vec3(0.f, 0.f, -1500.f);
+		ball.UpdatePhysics(dt);
+		CollisionData cd;
+		glm::vec3 from = ball.prevPos;
+		float remaining = dt;
+		bool hit = SweepSphere2AABB(ball, from, wall, cd, toi);
+		if (hit)
+			from = ResolveSweptCollision(cd, from, toi, remaining);
+		bool inFront = true;
+		for (int i = 0; i <= 20; ++i)
+			inFront = inFront && ball.GetInterpolatedPos(i / 20.f).z > -2.95f;
+		failures += CheckSwept("interpolated bounce starts at the step's start",
+			hit && glm::length(ball.GetInterpolatedPos(0.f)) < eps);
+		failures += CheckSwept("interpolated bounce reaches the wall at the impact",
+			hit && std::fabs(ball.impactAlpha - toi) < eps && glm::length(ball.GetInterpolatedPos(ball.impactAlpha) - from) < eps);
+		failures += CheckSwept("interpolated bounce stays in front of the wall", hit && inFront);
+		failures += CheckSwept("interpolated bounce ends at the step's end",
+			hit && glm::length(ball.GetInterpolatedPos(1.f) - ball.pos) < eps);
+	}
+
+	std::cout << failures << " failed\n";
+	return failures;
+}
@@ -31,6 +31,31 @@ bool OverlapCircle2OBB(PhysicsObject& circle, float radius, PhysicsObject& box,
 // 3D collision detection functions
 bool OverlapSphere2AABB(PhysicsObject& sphereObj, PhysicsObject& boxObj, CollisionData& cd);
 
+// Swept (continuous) tests: a sphere moving in a straight line from 'from' to 'to'.
+// On a hit, toi is the fraction of the move at first contact, 0 if it starts
+// overlapping, and normal points from the surface to the sphere at that moment.
+bool SweepSphere2Plane(const glm::vec3& from, const glm::vec3& to, float radius,
+					   const glm::vec3& planePoint, const glm::vec3& planeNormal, float& toi, glm::vec3& normal);
+bool SweepSphere2AABB(const glm::vec3& from, const glm::vec3& to, float radius,
+					  const glm::vec3& boxMin, const glm::vec3& boxMax, float& toi, glm::vec3& normal);
+bool SweepSphere2Segment(const glm::vec3& from, const glm::vec3& to, float radius,
+						 const glm::vec3& segStart, const glm::vec3& segEnd, float& toi, glm::vec3& normal);
+// sphereObj moving from 'from' to its pos against boxObj, sized as in OverlapSphere2AABB.
+// Fills cd for the sphere at its impact position, with the penetration that
+// sets it SWEEP_SKIN clear of the box.
+bool SweepSphere2AABB(PhysicsObject& sphereObj, const glm::vec3& from, PhysicsObject& boxObj, CollisionData& cd, float& toi);
+
+// gap left between a swept sphere and the surface it stopped at, so the next sweep starts clear
+const float SWEEP_SKIN = 1e-3f;
+
 // collision resolution function
 void ResolveCollision(CollisionData& cd);
-void ResolveCircle2StaticLine(PhysicsObject& ball, float radius, const glm::vec3& lineStart, const glm::vec3& lineEnd);
\ No newline at end of file
+// Move cd.pObj1 back to the impact a sweep from 'from' found at toi, resolve it and
+// carry it on with its new velocity for the rest of the step. remaining is the
+// time the move covered and becomes the time left; returns the next sweep's start,
+// which is also recorded as the object's impactPos for GetInterpolatedPos.
+glm::vec3 ResolveSweptCollision(CollisionData& cd, const glm::vec3& from, float toi, float& remaining);
+void ResolveCircle2StaticLine(PhysicsObject& ball, float radius, const glm::vec3& lineStart, const glm::vec3& lineEnd);
+
+// High-velocity cases for the swept tests; prints each result and returns the failures
+int RunSweptCollisionChecks();
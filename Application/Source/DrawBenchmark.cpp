@@ -0,0 +1,58 @@
+#include <iostream>
+#include "DrawBenchmark.h"
+#include "UniformBlocks.h"
+#include "shader.hpp"
+#include "timer.h"
+
+DrawBenchmark::DrawBenchmark(unsigned frames)
+	: frames(frames)
+{
+	programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	glUseProgram(programID);
+	UniformBlocks::GetInstance()->BindProgram(programID);
+}
+
+DrawBenchmark::~DrawBenchmark()
+{
+	glUseProgram(0);
+	glDeleteProgram(programID);
+}
+
+GLint DrawBenchmark::GetUniform(const char* name) const
+{
+	return glGetUniformLocation(programID, name);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Clear and draw the given number of frames and print one line:
+"<name><count> <unit>, <total> ms per frame (<submit> ms submitting)", where
+count is the average drawFrame returned. glFinish before and after keeps
+earlier work out of the total and waits for the GPU at the end.
+
+\param name - printed first, e.g. "Instanced: "
+\param unit - what drawFrame counts, e.g. "draw calls"
+\param drawFrame - draws one frame, returns its count of unit
+*/
+/******************************************************************************/
+void DrawBenchmark::Run(const char* name, const char* unit, const std::function<unsigned(void)>& drawFrame)
+{
+	StopWatch timer;
+	double submitTime = 0.0;
+	unsigned long long count = 0;
+	glFinish();
+	timer.startTimer();
+	for (unsigned frame = 0; frame < frames; ++frame)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		count += drawFrame();
+		submitTime += timer.getElapsedTime(); // time since the last call
+	}
+	glFinish();
+	double time = submitTime + timer.getElapsedTime();
+
+	std::cout << name << count / frames << " " << unit << ", "
+		<< time * 1000.0 / frames << " ms per frame ("
+		<< submitTime * 1000.0 / frames << " ms submitting)\n";
+}
@@ -0,0 +1,36 @@
+#ifndef DRAW_BENCHMARK_H
+#define DRAW_BENCHMARK_H
+
+#include <functional>
+#include <GL\glew.h>
+
+/******************************************************************************/
+/*!
+		Class DrawBenchmark:
+\brief	What the command-line draw benchmarks share: a Texture/Text program
+		bound to the uniform blocks for the benchmark's lifetime, and a timed
+		loop that reports CPU submit time apart from the total once the GPU
+		has finished.
+*/
+/******************************************************************************/
+class DrawBenchmark
+{
+public:
+	DrawBenchmark(unsigned frames = 100);
+	~DrawBenchmark();
+
+	GLuint GetProgram(void) const { return programID; }
+	GLint GetUniform(const char* name) const;
+
+	// drawFrame draws one frame and returns how many of unit it drew
+	void Run(const char* name, const char* unit, const std::function<unsigned(void)>& drawFrame);
+
+private:
+	DrawBenchmark(const DrawBenchmark&);
+	DrawBenchmark& operator=(const DrawBenchmark&);
+
+	unsigned frames;
+	GLuint programID;
+};
+
+#endif
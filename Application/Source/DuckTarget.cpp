@@ -4,6 +4,7 @@ DuckTarget::DuckTarget(glm::vec3 start, glm::vec3 end, glm::vec3 size, float spe
 {
     hitImpulseStrength = 2.f;
     pos = start;
+    prevPos = start;
 	startPos = start;
 	endPos = end;
 	moveSpeed = speed;
@@ -22,6 +23,8 @@ void DuckTarget::Update(float dt)
 {
     if (!active) return;
 
+    // UpdatePhysics only sees the glide's end, so the step starts from here
+    glm::vec3 stepStart = pos;
     glm::vec3 targetPos = movingToEnd ? endPos : startPos;
     glm::vec3 dir = targetPos - pos;
     float dist = glm::length(dir);
@@ -47,6 +50,7 @@ void DuckTarget::Update(float dt)
     }
 
 	UpdatePhysics(dt);
+	prevPos = stepStart;
 }
 
 bool DuckTarget::OnHit()
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <glm\gtc\matrix_transform.hpp>
+#include "Frustum.h"
+#include "FPCamera.h"
+
+Frustum::Frustum()
+{
+	// Until extracted, everything is inside
+	for (unsigned i = 0; i < NUM_PLANES; ++i)
+		planes[i] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read the planes off a combined projection * view matrix: each one is the
+fourth row of the matrix plus or minus one of the other rows.
+
+\param viewProjection - projection * view
+*/
+/******************************************************************************/
+void Frustum::Extract(const glm::mat4& viewProjection)
+{
+	// glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	planes[PLANE_LEFT] = rows[3] + rows[0];
+	planes[PLANE_RIGHT] = rows[3] - rows[0];
+	planes[PLANE_BOTTOM] = rows[3] + rows[1];
+	planes[PLANE_TOP] = rows[3] - rows[1];
+	planes[PLANE_NEAR] = rows[3] + rows[2];
+	planes[PLANE_FAR] = rows[3] - rows[2];
+
+	for (unsigned i = 0; i < NUM_PLANES; ++i)
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+void Frustum::Extract(const FPCamera& camera, const glm::mat4& projection)
+{
+	Extract(projection * glm::lookAt(camera.position, camera.target, camera.up));
+}
+
+/******************************************************************************/
+/*!
+\brief
+Test a model-space bounding volume placed by model against the frustum.
+The sphere is tried first as it is cheapest; volumes it cannot reject are
+tested again with the box, which fits long and flat meshes much better.
+
+\param bounds - bounds of the mesh or material range
+\param model - model matrix it is drawn with
+
+\return false when the volume is entirely outside one plane
+*/
+/******************************************************************************/
+bool Frustum::Intersects(const Bounds& bounds, const glm::mat4& model) const
+{
+	if (bounds.IsEmpty())
+		return true;
+
+	// Sphere: the largest axis scale bounds the radius under any rotation
+	glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.f));
+	float scale = std::sqrt(glm::max(glm::max(
+		glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+		glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))),
+		glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+	float radius = bounds.radius * scale;
+
+	bool inside = true;
+	for (unsigned i = 0; i < NUM_PLANES; ++i)
+	{
+		float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+		if (distance < -radius)
+			return false;
+		if (distance < radius)
+			inside = false;
+	}
+	if (inside)
+		return true;
+
+	// Box: the world-space extent of the rotated box along each axis
+	glm::vec3 boxCenter = glm::vec3(model * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.f));
+	glm::vec3 halfSize = (bounds.max - bounds.min) * 0.5f;
+	glm::vec3 extent;
+	for (int row = 0; row < 3; ++row)
+	{
+		extent[row] = std::fabs(model[0][row]) * halfSize.x
+			+ std::fabs(model[1][row]) * halfSize.y
+			+ std::fabs(model[2][row]) * halfSize.z;
+	}
+
+	for (unsigned i = 0; i < NUM_PLANES; ++i)
+	{
+		glm::vec3 normal = glm::vec3(planes[i]);
+		float distance = glm::dot(normal, boxCenter) + planes[i].w;
+		float reach = glm::dot(extent, glm::abs(normal));
+		if (distance < -reach)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,44 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm\glm.hpp>
+#include "Bounds.h"
+
+class FPCamera;
+
+/******************************************************************************/
+/*!
+		Class Frustum:
+\brief	The six clip planes of a view, in world space, for testing bounding
+		volumes before they are drawn. Planes point inwards and are
+		normalised, so a plane's w is a distance.
+*/
+/******************************************************************************/
+class Frustum
+{
+public:
+	enum PLANE
+	{
+		PLANE_LEFT = 0,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		NUM_PLANES,
+	};
+
+	Frustum();
+
+	void Extract(const glm::mat4& viewProjection);
+	// Same view the scenes build with viewStack.LookAt
+	void Extract(const FPCamera& camera, const glm::mat4& projection);
+
+	// Conservative: may keep a volume just outside a corner, never drops a visible one
+	bool Intersects(const Bounds& bounds, const glm::mat4& model) const;
+
+private:
+	glm::vec4 planes[NUM_PLANES];
+};
+
+#endif
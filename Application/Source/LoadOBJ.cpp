@@ -1,158 +1,516 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <functional>
 
 #include "LoadOBJ.h"
+#include "MappedFile.h"
+#include "timer.h"
 
-bool LoadOBJ(
-	const char* file_path,
-	std::vector<glm::vec3>& out_vertices,
-	std::vector<glm::vec2>& out_uvs,
-	std::vector<glm::vec3>& out_normals
-)
+// ---------------------------------------------------------------
+// In-place tokenizer for memory-mapped OBJ/MTL text.
+// Every helper works on a [p, end) range and never reads past end,
+// since a mapped file is not null-terminated.
+// ---------------------------------------------------------------
+
+static inline bool IsBlank(char c)
 {
-	//Fill up code from OBJ lecture notes
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if (!fileStream.is_open())
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipBlanks(const char* p, const char* end)
+{
+	while (p < end && IsBlank(*p))
+		++p;
+	return p;
+}
+
+// Checks for keyword at p followed by a blank, and returns the position after it
+static inline bool MatchKeyword(const char* p, const char* lineEnd, const char* keyword, const char*& after)
+{
+	size_t len = strlen(keyword);
+	if (static_cast<size_t>(lineEnd - p) <= len || memcmp(p, keyword, len) != 0 || !IsBlank(p[len]))
+		return false;
+	after = p + len;
+	return true;
+}
+
+// Rest of the line with surrounding blanks trimmed (used for material names)
+static std::string RestOfLine(const char* p, const char* lineEnd)
+{
+	p = SkipBlanks(p, lineEnd);
+	while (lineEnd > p && IsBlank(lineEnd[-1]))
+		--lineEnd;
+	return std::string(p, lineEnd);
+}
+
+// Slow path: hand the token to strtof through a null-terminated copy
+static bool ParseFloatSlow(const char*& p, const char* end, float& out)
+{
+	char token[64];
+	size_t len = 0;
+	while (p + len < end && !IsBlank(p[len]) && p[len] != '\n' && p[len] != '/' && len < sizeof(token) - 1)
 	{
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		token[len] = p[len];
+		++len;
+	}
+	token[len] = '\0';
+
+	char* tokenEnd = nullptr;
+	out = strtof(token, &tokenEnd);
+	if (tokenEnd == token)
 		return false;
+	p += tokenEnd - token;
+	return true;
+}
+
+// Parses a decimal float. Short mantissas are converted exactly with a
+// single multiply/divide by a power of ten; anything else falls back to
+// strtof, so the result always matches the old sscanf_s("%f") output.
+static bool ParseFloat(const char*& p, const char* end, float& out)
+{
+	static const float floatPow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+	static const double doublePow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	p = SkipBlanks(p, end);
+	const char* s = p;
+
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		negative = (*s == '-');
+		++s;
 	}
-	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices;
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-	while (!fileStream.eof()) {
-		char buf[256];
-		fileStream.getline(buf, 256);
-		if (strncmp("v ", buf, 2) == 0) { 
-			// process vertex glm::vec3
 
-			glm::vec3 vertex;
-			sscanf_s((buf + 2), "%f%f%f", & vertex.x, & vertex.y, & vertex.z);
-			temp_vertices.push_back(vertex);
+	unsigned long long mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	bool truncated = false;
 
+	for (; s < end && *s >= '0' && *s <= '9'; ++s)
+	{
+		anyDigits = true;
+		if (significantDigits < 19)
+		{
+			mantissa = mantissa * 10 + (*s - '0');
+			if (mantissa != 0)
+				++significantDigits;
 		}
-		else if (strncmp("vt ", buf, 3) == 0) { 
-			// process texcoord
+		else
+		{
+			++exponent;
+			truncated = true;
+		}
+	}
+	if (s < end && *s == '.')
+	{
+		for (++s; s < end && *s >= '0' && *s <= '9'; ++s)
+		{
+			anyDigits = true;
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				--exponent;
+				if (mantissa != 0)
+					++significantDigits;
+			}
+			else
+			{
+				truncated = true;
+			}
+		}
+	}
+	if (!anyDigits)
+		return ParseFloatSlow(p, end, out);
 
-			glm::vec2 texCoord;
-			sscanf_s((buf + 2), "%f%f", &texCoord.s, &texCoord.t);
-			temp_uvs.push_back(texCoord);
+	if (s < end && (*s == 'e' || *s == 'E'))
+	{
+		const char* e = s + 1;
+		bool negativeExp = false;
+		if (e < end && (*e == '-' || *e == '+'))
+		{
+			negativeExp = (*e == '-');
+			++e;
+		}
+		if (e < end && *e >= '0' && *e <= '9')
+		{
+			int value = 0;
+			for (; e < end && *e >= '0' && *e <= '9'; ++e)
+			{
+				if (value < 10000)
+					value = value * 10 + (*e - '0');
+			}
+			exponent += negativeExp ? -value : value;
+			s = e;
+		}
+	}
 
+	if (!truncated && mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10)
+	{
+		// Both operands are exact floats, so one IEEE operation rounds correctly
+		float value = static_cast<float>(mantissa);
+		value = exponent < 0 ? value / floatPow10[-exponent] : value * floatPow10[exponent];
+		out = negative ? -value : value;
+		p = s;
+		return true;
+	}
+	if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double value = static_cast<double>(mantissa);
+		value = exponent < 0 ? value / doublePow10[-exponent] : value * doublePow10[exponent];
+
+		// Rounding the double to float is only ambiguous when it sits exactly
+		// halfway between two floats; leave that rare case to strtof
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		if ((bits & 0x1FFFFFFFull) != 0x10000000ull)
+		{
+			out = static_cast<float>(negative ? -value : value);
+			p = s;
+			return true;
 		}
-		else if (strncmp("vn ", buf, 3) == 0) { 
-			// process normal
+	}
+	return ParseFloatSlow(p, end, out);
+}
 
-			glm::vec3 normal;
-			sscanf_s((buf + 2), "%f%f%f", &normal.x, &normal.y, &normal.z);
-			temp_normals.push_back(normal);
-				
+static bool ParseUnsigned(const char*& p, const char* end, unsigned& out)
+{
+	const char* s = p;
+	unsigned value = 0;
+	while (s < end && *s >= '0' && *s <= '9')
+	{
+		value = value * 10 + (*s - '0');
+		++s;
+	}
+	if (s == p)
+		return false;
+	out = value;
+	p = s;
+	return true;
+}
+
+// Parses one "v/vt/vn" corner of a face
+static bool ParseFaceCorner(const char*& p, const char* end, unsigned& vertexIndex, unsigned& uvIndex, unsigned& normalIndex)
+{
+	return ParseUnsigned(p, end, vertexIndex) &&
+		p < end && *p++ == '/' &&
+		ParseUnsigned(p, end, uvIndex) &&
+		p < end && *p++ == '/' &&
+		ParseUnsigned(p, end, normalIndex);
+}
+
+// Everything parsed from one newline-aligned slice of an OBJ file
+struct OBJChunk
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
+
+	// Indices emitted before the chunk's first resolved usemtl; they extend
+	// whichever material run the previous chunks ended on
+	unsigned leadingIndexCount;
+	std::vector<MaterialRange> ranges;	// offsets relative to the chunk
+
+	bool failed;
+	std::string errorLine;
+
+	OBJChunk() : leadingIndexCount(0), failed(false) {}
+};
+
+// Below this many bytes per chunk, thread start-up costs more than it saves
+static const size_t MIN_OBJ_CHUNK_BYTES = 256 * 1024;
+static unsigned objParseThreads = 0;
+
+void SetOBJParseThreads(unsigned threads)
+{
+	objParseThreads = threads;
+}
+
+// Add a run that starts where the last one ends. A run with no indices yet is
+// replaced, and a run of the same material as the last one extends it
+static void AppendMaterialRange(std::vector<MaterialRange>& ranges, const MaterialRange& range)
+{
+	if (ranges.size() > 0 && ranges.back().count == 0)
+		ranges.pop_back();
+	if (ranges.size() > 0 && ranges.back().material == range.material)
+		ranges.back().count += range.count;
+	else
+		ranges.push_back(range);
+}
+
+static void ParseOBJChunk(
+	const char* p,
+	const char* end,
+	const std::map<std::string, unsigned>* materials_map,
+	OBJChunk& chunk
+)
+{
+	while (p < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		const char* line = SkipBlanks(p, lineEnd);
+		const char* args = nullptr;
+
+		if (MatchKeyword(line, lineEnd, "v", args))
+		{
+			// process vertex glm::vec3
+			glm::vec3 vertex(0.f);
+			ParseFloat(args, lineEnd, vertex.x) && ParseFloat(args, lineEnd, vertex.y) && ParseFloat(args, lineEnd, vertex.z);
+			chunk.vertices.push_back(vertex);
+		}
+		else if (MatchKeyword(line, lineEnd, "vt", args))
+		{
+			// process texcoord
+			glm::vec2 texCoord(0.f);
+			ParseFloat(args, lineEnd, texCoord.s) && ParseFloat(args, lineEnd, texCoord.t);
+			chunk.uvs.push_back(texCoord);
 		}
-		else if (strncmp("f ", buf, 2) == 0) { 
+		else if (MatchKeyword(line, lineEnd, "vn", args))
+		{
+			// process normal
+			glm::vec3 normal(0.f);
+			ParseFloat(args, lineEnd, normal.x) && ParseFloat(args, lineEnd, normal.y) && ParseFloat(args, lineEnd, normal.z);
+			chunk.normals.push_back(normal);
+		}
+		else if (materials_map != nullptr && MatchKeyword(line, lineEnd, "usemtl", args))
+		{
+			// process usemtl: start a new run unless the material does not change
+			std::map<std::string, unsigned>::const_iterator it = materials_map->find(RestOfLine(args, lineEnd));
+			if (it != materials_map->end())
+			{
+				MaterialRange range = { it->second, static_cast<unsigned>(chunk.vertexIndices.size()), 0 };
+				AppendMaterialRange(chunk.ranges, range);
+			}
+		}
+		else if (MatchKeyword(line, lineEnd, "f", args))
+		{
 			// process face
+			unsigned vertexIndex[3], uvIndex[3], normalIndex[3];
+			unsigned corners = 0;
+			unsigned indexCount = 0;
 
-			unsigned int vertexIndex[4], uvIndex[4], normalIndex[4];
-			int matches = sscanf_s((buf + 2), "%d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
-				&vertexIndex[0], &uvIndex[0], &normalIndex[0],
-				&vertexIndex[1], &uvIndex[1], &normalIndex[1],
-				&vertexIndex[2], &uvIndex[2], &normalIndex[2],
-				&vertexIndex[3], &uvIndex[3], &normalIndex[3]);
-
-			// Process faces
-			if (matches == 9) //triangle
+			for (args = SkipBlanks(args, lineEnd); args < lineEnd; args = SkipBlanks(args, lineEnd))
 			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
+				unsigned slot = corners < 3 ? corners : 2;
+				if (!ParseFaceCorner(args, lineEnd, vertexIndex[slot], uvIndex[slot], normalIndex[slot]) ||
+					(args < lineEnd && !IsBlank(*args)))
+				{
+					corners = 0;
+					break;
+				}
+				++corners;
+				if (corners >= 3)
+				{
+					// fan triangle (0, n-1, n)
+					chunk.vertexIndices.push_back(vertexIndex[0]);
+					chunk.vertexIndices.push_back(vertexIndex[1]);
+					chunk.vertexIndices.push_back(vertexIndex[2]);
+					chunk.uvIndices.push_back(uvIndex[0]);
+					chunk.uvIndices.push_back(uvIndex[1]);
+					chunk.uvIndices.push_back(uvIndex[2]);
+					chunk.normalIndices.push_back(normalIndex[0]);
+					chunk.normalIndices.push_back(normalIndex[1]);
+					chunk.normalIndices.push_back(normalIndex[2]);
+					indexCount += 3;
+
+					vertexIndex[1] = vertexIndex[2];
+					uvIndex[1] = uvIndex[2];
+					normalIndex[1] = normalIndex[2];
+				}
 			}
-			else if (matches == 12) // Do the same for quad
+
+			if (corners < 3)
 			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[2]);
-				vertexIndices.push_back(vertexIndex[3]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[2]);
-				uvIndices.push_back(uvIndex[3]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[2]);
-				normalIndices.push_back(normalIndex[3]);
+				chunk.failed = true;
+				chunk.errorLine.assign(line, lineEnd);
+				return;
 			}
+			if (chunk.ranges.size() > 0)
+				chunk.ranges.back().count += indexCount;
 			else
+				chunk.leadingIndexCount += indexCount;
+		}
+
+		p = lineEnd < end ? lineEnd + 1 : end;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Shared OBJ reader behind LoadOBJ and LoadOBJMTL. The file is memory-mapped
+and parsed in place. Faces must be v/vt/vn; polygons with more than three
+corners are fanned into triangles (0,1,2 & 0,2,3 & ... as for quads).
+
+Large files are split into newline-aligned chunks parsed on worker threads.
+OBJ face indices are global, so the chunks are simply concatenated in file
+order and the output is identical to a single-threaded parse.
+
+\param materials_map - material table index by name, or nullptr to ignore usemtl
+\param out_ranges - runs of indices per material; consecutive runs of the
+	same material are merged
+*/
+/******************************************************************************/
+static bool ParseOBJ(
+	const char* file_path,
+	const std::map<std::string, unsigned>* materials_map,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	std::vector<MaterialRange>* out_ranges
+)
+{
+	MappedFile file;
+	if (!file.Open(file_path))
+	{
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return false;
+	}
+
+	const char* begin = file.Data();
+	const char* end = begin + file.Size();
+
+	unsigned threads = objParseThreads > 0 ? objParseThreads : std::thread::hardware_concurrency();
+	size_t chunkCount = file.Size() / MIN_OBJ_CHUNK_BYTES;
+	if (chunkCount > threads)
+		chunkCount = threads;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	// Cut at the first newline after each even split point
+	std::vector<const char*> bounds(1, begin);
+	for (size_t i = 1; i < chunkCount; ++i)
+	{
+		const char* cut = begin + file.Size() * i / chunkCount;
+		if (cut < bounds.back())
+			cut = bounds.back();
+		const char* nl = static_cast<const char*>(memchr(cut, '\n', end - cut));
+		bounds.push_back(nl ? nl + 1 : end);
+	}
+	bounds.push_back(end);
+
+	std::vector<OBJChunk> chunks(chunkCount);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; ++i)
+		workers.push_back(std::thread(ParseOBJChunk, bounds[i], bounds[i + 1], materials_map, std::ref(chunks[i])));
+	ParseOBJChunk(bounds[0], bounds[1], materials_map, chunks[0]);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// Stitch the chunks back together in file order
+	std::vector<glm::vec3> temp_vertices;
+	std::vector<glm::vec2> temp_uvs;
+	std::vector<glm::vec3> temp_normals;
+	size_t indexTotal = 0;
+	for (OBJChunk& chunk : chunks)
+	{
+		if (chunk.failed)
+		{
+			std::cout << "Error line: " << chunk.errorLine << std::endl;
+			std::cout << "File can't be read by parser\n";
+			return false;
+		}
+		temp_vertices.insert(temp_vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+		temp_uvs.insert(temp_uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+		temp_normals.insert(temp_normals.end(), chunk.normals.begin(), chunk.normals.end());
+
+		if (out_ranges != nullptr)
+		{
+			if (out_ranges->size() > 0)
+				out_ranges->back().count += chunk.leadingIndexCount;
+			for (MaterialRange range : chunk.ranges)
 			{
-				std::cout << "Error line: " << buf << std::endl;
-				std::cout << "File can't be read by parser\n";
-				return false;
+				range.offset += static_cast<unsigned>(indexTotal);
+				AppendMaterialRange(*out_ranges, range);
 			}
 		}
+		indexTotal += chunk.vertexIndices.size();
 	}
-	fileStream.close(); // close file
+	if (out_ranges != nullptr && out_ranges->size() > 0 && out_ranges->back().count == 0)
+		out_ranges->pop_back();
 
-	// For each vertex of each triangle, after fileStream.close()
-	for (unsigned i = 0; i < vertexIndices.size(); ++i)
+	// For each vertex of each triangle
+	out_vertices.reserve(out_vertices.size() + indexTotal);
+	out_uvs.reserve(out_uvs.size() + indexTotal);
+	out_normals.reserve(out_normals.size() + indexTotal);
+	for (const OBJChunk& chunk : chunks)
 	{
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
+		for (unsigned i = 0; i < chunk.vertexIndices.size(); ++i)
+		{
+			// Get the indices of its attributes
+			unsigned int vertexIndex = chunk.vertexIndices[i];
+			unsigned int uvIndex = chunk.uvIndices[i];
+			unsigned int normalIndex = chunk.normalIndices[i];
 
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-		glm::vec2 uv = temp_uvs[uvIndex - 1];
-		glm::vec3 normal = temp_normals[normalIndex - 1];
+			if (vertexIndex - 1 >= temp_vertices.size() || uvIndex - 1 >= temp_uvs.size() || normalIndex - 1 >= temp_normals.size())
+			{
+				std::cout << "Face index out of range in " << file_path << std::endl;
+				return false;
+			}
 
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs.push_back(uv);
-		out_normals.push_back(normal);
+			// Put the attributes in buffers
+			out_vertices.push_back(temp_vertices[vertexIndex - 1]);
+			out_uvs.push_back(temp_uvs[uvIndex - 1]);
+			out_normals.push_back(temp_normals[normalIndex - 1]);
+		}
 	}
 
-
 	return true;
 }
 
+bool LoadOBJ(
+	const char* file_path,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals
+)
+{
+	return ParseOBJ(file_path, nullptr, out_vertices, out_uvs, out_normals, nullptr);
+}
+
 struct PackedVertex {
 	glm::vec3 position;
 	glm::vec2 uv;
 	glm::vec3 normal;
-	bool operator<(const PackedVertex that) const {
-		return memcmp((void*)this, (void*)&that, sizeof(PackedVertex)) > 0;
-	};
 };
 
-bool getSimilarVertexIndex_fast(
-	PackedVertex& packed,
-	std::map<PackedVertex, unsigned short>& VertexToOutIndex,
-	unsigned short& result
-) {
-	std::map<PackedVertex, unsigned short>::iterator it = VertexToOutIndex.find(packed);
-	if (it == VertexToOutIndex.end())
-	{
-		return false;
-	}
-	else
+// Vertices are deduplicated on their exact bit pattern, same as the old memcmp ordering
+static inline unsigned HashPackedVertex(const PackedVertex& packed)
+{
+	unsigned words[sizeof(PackedVertex) / sizeof(unsigned)];
+	memcpy(words, &packed, sizeof(words));
+
+	unsigned hash = 2166136261u;
+	for (unsigned i = 0; i < sizeof(words) / sizeof(words[0]); ++i)
 	{
-		result = it->second;
-		return true;
+		hash = (hash ^ words[i]) * 16777619u;
+		hash ^= hash >> 15;
 	}
+	return hash;
 }
 
+/******************************************************************************/
+/*!
+\brief
+Build an indexed vertex buffer from the flat per-corner arrays produced by
+LoadOBJ/LoadOBJMTL. Identical corners share one output vertex; output
+vertices keep the order in which they are first seen.
+
+Lookup goes through an open-addressing (linear probing) table of output
+indices, sized once from the corner count so it never rehashes. Indices
+are 32-bit, so meshes with more than 65535 unique vertices index correctly.
+*/
+/******************************************************************************/
 void IndexVBO(
 	std::vector<glm::vec3>& in_vertices,
 	std::vector<glm::vec2>& in_uvs,
@@ -162,22 +520,39 @@ void IndexVBO(
 	std::vector<Vertex>& out_vertices
 )
 {
-	std::map<PackedVertex, unsigned short> VertexToOutIndex;
+	const unsigned EMPTY_SLOT = 0xFFFFFFFFu;
+	unsigned cornerCount = (unsigned)in_vertices.size();
+
+	// Power of two with at most 50% load, even if every corner is unique
+	unsigned capacity = 16;
+	while (capacity < cornerCount * 2)
+		capacity <<= 1;
+	const unsigned mask = capacity - 1;
+
+	std::vector<unsigned> slots(capacity, EMPTY_SLOT);
+	std::vector<PackedVertex> packedVertices;
+	packedVertices.reserve(cornerCount);
+
+	size_t firstVertex = out_vertices.size();
+	out_indices.reserve(out_indices.size() + cornerCount);
 
 	// For each input vertex
-	for (unsigned int i = 0; i < in_vertices.size(); ++i)
+	for (unsigned int i = 0; i < cornerCount; ++i)
 	{
-
 		PackedVertex packed = { in_vertices[i], in_uvs[i], in_normals[i] };
 
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex_fast(packed, VertexToOutIndex, index);
+		unsigned slot = HashPackedVertex(packed) & mask;
+		while (slots[slot] != EMPTY_SLOT &&
+			memcmp(&packedVertices[slots[slot]], &packed, sizeof(PackedVertex)) != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
 
-		if (found)
+		if (slots[slot] != EMPTY_SLOT)
 		{
 			// A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back(index);
+			out_indices.push_back((unsigned)firstVertex + slots[slot]);
 		}
 		else
 		{
@@ -188,214 +563,577 @@ void IndexVBO(
 			v.normal = glm::vec3(in_normals[i].x, in_normals[i].y, in_normals[i].z);
 			v.color = glm::vec3(1, 1, 1);
 			out_vertices.push_back(v);
-			unsigned newindex = (unsigned)out_vertices.size() - 1;
-			out_indices.push_back(newindex);
-			VertexToOutIndex[packed] = newindex;
+
+			slots[slot] = (unsigned)packedVertices.size();
+			packedVertices.push_back(packed);
+			out_indices.push_back((unsigned)out_vertices.size() - 1);
 		}
 	}
 }
 
-bool LoadMTL(const char* file_path, std::map<std::string, Material*>& materials_map)
+// Folder part of a path, including the trailing separator
+static std::string GetDirectory(const std::string& file_path)
 {
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if (!fileStream.is_open())
+	size_t slash = file_path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string() : file_path.substr(0, slash + 1);
+}
+
+// Add a material to the table unless an identical one is already there
+static unsigned AddMaterial(std::vector<Material>& materials, const Material& material)
+{
+	for (unsigned i = 0; i < materials.size(); ++i)
+	{
+		if (materials[i] == material)
+			return i;
+	}
+	materials.push_back(material);
+	return static_cast<unsigned>(materials.size() - 1);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read an MTL file in one pass into a flat material table. Materials that
+only differ by name share one entry.
+
+\param file_path - MTL file
+\param out_materials - material table, appended to
+\param out_indices - table index of each material name
+*/
+/******************************************************************************/
+bool LoadMTL(const char* file_path, std::vector<Material>& out_materials, std::map<std::string, unsigned>& out_indices)
+{
+	MappedFile file;
+	if (!file.Open(file_path))
 	{
 		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
 		return false;
 	}
-	Material* mtl = nullptr;
-	while (!fileStream.eof()) {
-		char buf[256];
-		fileStream.getline(buf, 256);
-		if (strncmp("newmtl ", buf, 7) == 0) { //process newmtl
-			char mtl_name[256];
-			strcpy_s(mtl_name, buf + 7);
-			if (mtl_name[strlen(mtl_name) - 1] == '\r')
-				mtl_name[strlen(mtl_name) - 1] = '\0';
-			mtl = nullptr;
-			if (materials_map.find(mtl_name) == materials_map.end())
-			{
-				mtl = new Material();
-				materials_map.insert(std::pair<std::string, Material*>(mtl_name, mtl));
-			}
+	const std::string directory = GetDirectory(file_path);
+
+	// Material being read, added to the table at the next newmtl or at the end
+	Material mtl;
+	std::string mtl_name;
+	bool reading = false;
+
+	const char* p = file.Data();
+	const char* end = p + file.Size();
+	while (p < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		const char* line = SkipBlanks(p, lineEnd);
+		const char* args = nullptr;
+
+		if (MatchKeyword(line, lineEnd, "newmtl", args)) { //process newmtl
+			// the first definition of a name wins
+			if (reading && out_indices.find(mtl_name) == out_indices.end())
+				out_indices[mtl_name] = AddMaterial(out_materials, mtl);
+			mtl = Material();
+			mtl_name = RestOfLine(args, lineEnd);
+			reading = true;
 		}
-		else if (strncmp("Ka ", buf, 3) == 0) { //process Ka
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kAmbient.r, &mtl->kAmbient.g, &mtl->kAmbient.b);
-			}
+		else if (reading && MatchKeyword(line, lineEnd, "Ka", args)) { //process Ka
+			ParseFloat(args, lineEnd, mtl.kAmbient.r) && ParseFloat(args, lineEnd, mtl.kAmbient.g) && ParseFloat(args, lineEnd, mtl.kAmbient.b);
 		}
-		else if (strncmp("Kd ", buf, 3) == 0) { //process Kd
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kDiffuse.r, &mtl->kDiffuse.g, &mtl->kDiffuse.b);
-			}
+		else if (reading && MatchKeyword(line, lineEnd, "Kd", args)) { //process Kd
+			ParseFloat(args, lineEnd, mtl.kDiffuse.r) && ParseFloat(args, lineEnd, mtl.kDiffuse.g) && ParseFloat(args, lineEnd, mtl.kDiffuse.b);
 		}
-		else if (strncmp("Ks ", buf, 3) == 0) { //process Ks
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f%f%f", &mtl->kSpecular.r, &mtl->kSpecular.g, &mtl->kSpecular.b);
-			}
+		else if (reading && MatchKeyword(line, lineEnd, "Ks", args)) { //process Ks
+			ParseFloat(args, lineEnd, mtl.kSpecular.r) && ParseFloat(args, lineEnd, mtl.kSpecular.g) && ParseFloat(args, lineEnd, mtl.kSpecular.b);
 		}
-		else if (strncmp("Ns ", buf, 3) == 0) { //process Ns
-			if (mtl != nullptr)
-			{
-				sscanf_s((buf + 2), "%f", &mtl->kShininess);
-			}
+		else if (reading && MatchKeyword(line, lineEnd, "Ns", args)) { //process Ns
+			ParseFloat(args, lineEnd, mtl.kShininess);
+		}
+		else if (reading && MatchKeyword(line, lineEnd, "d", args)) { //process d
+			ParseFloat(args, lineEnd, mtl.dissolve);
+		}
+		else if (reading && MatchKeyword(line, lineEnd, "illum", args)) { //process illum
+			args = SkipBlanks(args, lineEnd);
+			ParseUnsigned(args, lineEnd, mtl.illum);
+		}
+		else if (reading && MatchKeyword(line, lineEnd, "map_Kd", args)) { //process map_Kd
+			std::string texture_path = RestOfLine(args, lineEnd);
+			bool absolute = texture_path.find(':') != std::string::npos ||
+				(!texture_path.empty() && (texture_path[0] == '/' || texture_path[0] == '\\'));
+			mtl.texturePath = absolute ? texture_path : directory + texture_path;
 		}
+
+		p = lineEnd < end ? lineEnd + 1 : end;
 	}
-	fileStream.close(); // close file
+	if (reading && out_indices.find(mtl_name) == out_indices.end())
+		out_indices[mtl_name] = AddMaterial(out_materials, mtl);
 
 	return true;
 }
 
-bool LoadOBJMTL(const char* file_path, const char* mtl_path, std::vector<glm::vec3>& out_vertices, std::vector<glm::vec2>& out_uvs, std::vector<glm::vec3>& out_normals, std::vector<Material>& out_materials)
+/******************************************************************************/
+/*!
+\brief
+Load an OBJ with its MTL
+
+\param out_materials - material table, only the materials the OBJ uses
+\param out_ranges - index runs per material, in draw order
+*/
+/******************************************************************************/
+bool LoadOBJMTL(
+	const char* file_path,
+	const char* mtl_path,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	std::vector<Material>& out_materials,
+	std::vector<MaterialRange>& out_ranges
+)
+{
+	std::vector<Material> materials;
+	std::map<std::string, unsigned> material_indices;
+	if (mtl_path != nullptr && !LoadMTL(mtl_path, materials, material_indices))
+		return false;
+
+	std::vector<MaterialRange> ranges;
+	if (!ParseOBJ(file_path, &material_indices, out_vertices, out_uvs, out_normals, &ranges))
+		return false;
+
+	// Faces before the first usemtl get a default material
+	if (ranges.size() > 0 && ranges[0].offset > 0)
+	{
+		MaterialRange range = { AddMaterial(materials, Material()), 0, ranges[0].offset };
+		ranges.insert(ranges.begin(), range);
+	}
+
+	// Keep only the materials that are drawn, in first-use order
+	std::vector<unsigned> remap(materials.size(), ~0u);
+	for (MaterialRange range : ranges)
+	{
+		if (remap[range.material] == ~0u)
+		{
+			remap[range.material] = static_cast<unsigned>(out_materials.size());
+			out_materials.push_back(materials[range.material]);
+		}
+		range.material = remap[range.material];
+		out_ranges.push_back(range);
+	}
+	return true;
+}
+
+// Append every .obj under directory, searching subfolders too
+static void CollectOBJFiles(const std::string& directory, std::vector<std::string>& out_files)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string name = findData.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		std::string path = directory + "\\" + name;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			CollectOBJFiles(path, out_files);
+		else if (name.size() > 4 && _stricmp(name.c_str() + name.size() - 4, ".obj") == 0)
+			out_files.push_back(path);
+	} while (FindNextFileA(find, &findData));
+	FindClose(find);
+}
+
+// Everything LoadOBJ/LoadOBJMTL hands back, to check both parse paths agree
+struct OBJLoadResult
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<Material> materials;
+	std::vector<MaterialRange> ranges;
+
+	bool operator==(const OBJLoadResult& rhs) const
+	{
+		if (vertices.size() != rhs.vertices.size() || uvs.size() != rhs.uvs.size() || normals.size() != rhs.normals.size() ||
+			materials.size() != rhs.materials.size() || ranges.size() != rhs.ranges.size())
+			return false;
+		for (unsigned i = 0; i < materials.size(); ++i)
+		{
+			if (!(materials[i] == rhs.materials[i]))
+				return false;
+		}
+		for (unsigned i = 0; i < ranges.size(); ++i)
+		{
+			if (ranges[i].material != rhs.ranges[i].material || ranges[i].offset != rhs.ranges[i].offset || ranges[i].count != rhs.ranges[i].count)
+				return false;
+		}
+		return (vertices.empty() || memcmp(&vertices[0], &rhs.vertices[0], vertices.size() * sizeof(glm::vec3)) == 0) &&
+			(uvs.empty() || memcmp(&uvs[0], &rhs.uvs[0], uvs.size() * sizeof(glm::vec2)) == 0) &&
+			(normals.empty() || memcmp(&normals[0], &rhs.normals[0], normals.size() * sizeof(glm::vec3)) == 0);
+	}
+};
+
+// The getline/sscanf_s LoadOBJ this file used to have, kept as the baseline
+// for RunOBJLoadBenchmark. Lines are limited to 255 characters and faces to
+// triangles and quads, as they were.
+static bool LoadOBJBaseline(
+	const char* file_path,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals
+)
 {
 	std::ifstream fileStream(file_path, std::ios::binary);
 	if (!fileStream.is_open())
-	{
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
 		return false;
-	}
 	std::vector<unsigned> vertexIndices, uvIndices, normalIndices;
 	std::vector<glm::vec3> temp_vertices;
 	std::vector<glm::vec2> temp_uvs;
 	std::vector<glm::vec3> temp_normals;
-	std::map<std::string, Material*> materials_map;
-	if(mtl_path != nullptr && !LoadMTL(mtl_path, materials_map))
-		return false;
-
 	while (!fileStream.eof()) {
 		char buf[256];
 		fileStream.getline(buf, 256);
-		if (strncmp("v ", buf, 2) == 0) { 
-			// process vertex glm::vec3
-			// refer to lecture on how to do it
-
+		if (strncmp("v ", buf, 2) == 0) {
 			glm::vec3 vertex;
 			sscanf_s((buf + 2), "%f%f%f", &vertex.x, &vertex.y, &vertex.z);
 			temp_vertices.push_back(vertex);
 		}
-		else if (strncmp("vt ", buf, 3) == 0) { 
-			// process texcoord
-			// refer to lecture on how to do it
-
+		else if (strncmp("vt ", buf, 3) == 0) {
 			glm::vec2 texCoord;
 			sscanf_s((buf + 2), "%f%f", &texCoord.s, &texCoord.t);
 			temp_uvs.push_back(texCoord);
 		}
-		else if (strncmp("vn ", buf, 3) == 0) { 
-			// process normal
-			// refer to lecture on how to do it
-
+		else if (strncmp("vn ", buf, 3) == 0) {
 			glm::vec3 normal;
 			sscanf_s((buf + 2), "%f%f%f", &normal.x, &normal.y, &normal.z);
 			temp_normals.push_back(normal);
 		}
-		//else if (strncmp("mtllib ", buf, 7) == 0) { //process mtllib
-		//	char mtl_path[256];
-		//	strcpy_s(mtl_path, buf + 7);
-		//	LoadMTL(mtl_path, materials_map);
-		//}
-		else if (strncmp("usemtl ", buf, 7) == 0) { 
-			// process usemtl
-			char mtl_name[256];
-			strcpy_s(mtl_name, buf + 7);
-			if (materials_map.find(mtl_name) != materials_map.end())
-			{
-				Material* mtl = materials_map.find(mtl_name)->second;
-				Material material = *mtl;
-				out_materials.push_back(material);
-			}
-		}
-		else if (strncmp("f ", buf, 2) == 0) { 
-			// process face
-			// refer to lecture on how to do it
+		else if (strncmp("f ", buf, 2) == 0) {
 			unsigned int vertexIndex[4], uvIndex[4], normalIndex[4];
 			int matches = sscanf_s((buf + 2), "%d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
 				&vertexIndex[0], &uvIndex[0], &normalIndex[0],
 				&vertexIndex[1], &uvIndex[1], &normalIndex[1],
 				&vertexIndex[2], &uvIndex[2], &normalIndex[2],
 				&vertexIndex[3], &uvIndex[3], &normalIndex[3]);
-
-			if (matches == 9) //triangle (hint: index 0,1,2)
-			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-
-				if (out_materials.size() > 0)
-				{
-					out_materials.back().size += 3;
-				}
-			}
-			else if (matches == 12) //quad (hint: index 0,1,2 & 0,2,3)
+			if (matches != 9 && matches != 12)
+				return false;
+			// It silently dropped any corners past the fourth; treat such faces as unreadable
+			int cornerCount = 0;
+			for (const char* c = buf + 2; *c != '\0';)
 			{
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[1]);
-				vertexIndices.push_back(vertexIndex[2]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[1]);
-				uvIndices.push_back(uvIndex[2]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[1]);
-				normalIndices.push_back(normalIndex[2]);
-
-				vertexIndices.push_back(vertexIndex[0]);
-				vertexIndices.push_back(vertexIndex[2]);
-				vertexIndices.push_back(vertexIndex[3]);
-				uvIndices.push_back(uvIndex[0]);
-				uvIndices.push_back(uvIndex[2]);
-				uvIndices.push_back(uvIndex[3]);
-				normalIndices.push_back(normalIndex[0]);
-				normalIndices.push_back(normalIndex[2]);
-				normalIndices.push_back(normalIndex[3]);
-
-				if (out_materials.size() > 0)
-				{
-					out_materials.back().size += 6;
-				}
+				while (*c == ' ' || *c == '\t' || *c == '\r')
+					++c;
+				if (*c == '\0')
+					break;
+				++cornerCount;
+				while (*c != '\0' && *c != ' ' && *c != '\t' && *c != '\r')
+					++c;
 			}
-			else
-			{
-				std::cout << "Error line: " << buf << std::endl;
-				std::cout << "File can't be read by parser\n";
+			if (cornerCount > 4)
 				return false;
+
+			// A quad is split 0,1,2 & 0,2,3
+			const unsigned corners[] = { 0, 1, 2, 0, 2, 3 };
+			for (int i = 0; i < (matches == 9 ? 3 : 6); ++i)
+			{
+				vertexIndices.push_back(vertexIndex[corners[i]]);
+				uvIndices.push_back(uvIndex[corners[i]]);
+				normalIndices.push_back(normalIndex[corners[i]]);
 			}
 		}
 	}
-	fileStream.close(); // close file
 
-	// For each vertex of each triangle, after fileStream.close()
 	for (unsigned i = 0; i < vertexIndices.size(); ++i)
 	{
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
+		if (vertexIndices[i] - 1 >= temp_vertices.size() || uvIndices[i] - 1 >= temp_uvs.size() || normalIndices[i] - 1 >= temp_normals.size())
+			return false;
+		out_vertices.push_back(temp_vertices[vertexIndices[i] - 1]);
+		out_uvs.push_back(temp_uvs[uvIndices[i] - 1]);
+		out_normals.push_back(temp_normals[normalIndices[i] - 1]);
+	}
+	return true;
+}
+
+// Best of a few loads, so the file is in the OS cache; negative if load fails
+static double TimeOBJLoad(const std::function<bool(OBJLoadResult&)>& load, OBJLoadResult& out_result)
+{
+	const unsigned RUNS = 3;
+
+	StopWatch timer;
+	double best = -1.0;
+	for (unsigned run = 0; run < RUNS; ++run)
+	{
+		OBJLoadResult result;
+		timer.startTimer();
+		bool loaded = load(result);
+		double time = timer.getElapsedTime();
+		if (!loaded)
+			return -1.0;
+		if (best < 0.0 || time < best)
+			best = time;
+		out_result = result;
+	}
+	return best;
+}
+
+// LoadOBJMTL when there is an MTL, LoadOBJ otherwise, with the given parse thread count
+static double TimeOBJLoad(const std::string& obj_path, const char* mtl_path, unsigned threads, OBJLoadResult& out_result)
+{
+	return TimeOBJLoad([&](OBJLoadResult& result) {
+		SetOBJParseThreads(threads);
+		return mtl_path != nullptr ?
+			LoadOBJMTL(obj_path.c_str(), mtl_path, result.vertices, result.uvs, result.normals, result.materials, result.ranges) :
+			LoadOBJ(obj_path.c_str(), result.vertices, result.uvs, result.normals);
+	}, out_result);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load every OBJ under a directory and report, per file and in total:
+- the old getline/sscanf_s loader against the memory-mapped parser, both
+  single-threaded and without the MTL, which must give identical output
+  (files the old loader cannot read are timed with the new one only)
+- the memory-mapped parser with 1, 2, 4... parse threads up to the number of
+  hardware threads, through LoadOBJMTL when there is a .mtl of the same name,
+  which must give the same output with every thread count
+Files the new parser rejects are reported and skipped. Needs no GL context.
+
+\param directory - folder to scan recursively, e.g. "Models"
+
+\return number of files where two loads gave different output
+*/
+/******************************************************************************/
+int RunOBJLoadBenchmark(const char* directory)
+{
+	std::vector<std::string> files;
+	CollectOBJFiles(directory, files);
+
+	std::vector<unsigned> threadCounts;
+	unsigned hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned threads = 1; threads < hardwareThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(hardwareThreads);
+
+	int failures = 0;
+	unsigned loaded = 0, compared = 0;
+	double totalBaseline = 0.0, totalMapped = 0.0;
+	std::vector<double> totalThreads(threadCounts.size(), 0.0);
+	for (const std::string& obj_path : files)
+	{
+		std::string mtl_path = obj_path.substr(0, obj_path.find_last_of('.')) + ".mtl";
+		const char* mtl = GetFileWriteTime(mtl_path.c_str()) != 0 ? mtl_path.c_str() : nullptr;
 
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-		glm::vec2 uv = temp_uvs[uvIndex - 1];
-		glm::vec3 normal = temp_normals[normalIndex - 1];
+		OBJLoadResult baseline, mapped;
+		double baselineTime = TimeOBJLoad([&](OBJLoadResult& result) {
+			return LoadOBJBaseline(obj_path.c_str(), result.vertices, result.uvs, result.normals);
+		}, baseline);
+		double mappedTime = TimeOBJLoad(obj_path, nullptr, 1, mapped);
 
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs.push_back(uv);
-		out_normals.push_back(normal);
+		std::vector<OBJLoadResult> results(threadCounts.size());
+		std::vector<double> times(threadCounts.size());
+		bool failed = mappedTime < 0.0;
+		for (size_t i = 0; i < threadCounts.size() && !failed; ++i)
+		{
+			times[i] = TimeOBJLoad(obj_path, mtl, threadCounts[i], results[i]);
+			failed = times[i] < 0.0;
+		}
+		if (failed)
+		{
+			std::cout << obj_path << ": failed to load, skipped\n";
+			continue;
+		}
+		if (baselineTime >= 0.0 && !(baseline == mapped))
+		{
+			std::cout << obj_path << ": memory-mapped parse differs from the getline/sscanf_s one\n";
+			++failures;
+			continue;
+		}
+		size_t mismatch = 1;
+		while (mismatch < results.size() && results[mismatch] == results[0])
+			++mismatch;
+		if (mismatch < results.size())
+		{
+			std::cout << obj_path << ": parse with " << threadCounts[mismatch] << " threads differs from the single-threaded one\n";
+			++failures;
+			continue;
+		}
+
+		++loaded;
+		std::cout << obj_path << ": " << mapped.vertices.size() / 3 << " triangles, ";
+		if (baselineTime >= 0.0)
+		{
+			++compared;
+			totalBaseline += baselineTime;
+			totalMapped += mappedTime;
+			std::cout << "getline/sscanf_s " << baselineTime * 1000.0 << " ms, mapped " << mappedTime * 1000.0
+				<< " ms, " << baselineTime / mappedTime << "x;";
+		}
+		else
+		{
+			std::cout << "old loader cannot read it, mapped " << mappedTime * 1000.0 << " ms;";
+		}
+		for (size_t i = 0; i < threadCounts.size(); ++i)
+		{
+			totalThreads[i] += times[i];
+			std::cout << (i == 0 ? " " : ", ") << threadCounts[i] << (threadCounts[i] == 1 ? " thread " : " threads ") << times[i] * 1000.0 << " ms";
+		}
+		std::cout << "\n";
 	}
+	SetOBJParseThreads(0);
 
-	for (std::map<std::string, Material*>::iterator it = materials_map.begin(); it != materials_map.end(); ++it)
+	if (totalMapped > 0.0)
 	{
-		delete it->second;
+		std::cout << compared << " files, getline/sscanf_s " << totalBaseline * 1000.0 << " ms, mapped "
+			<< totalMapped * 1000.0 << " ms, " << totalBaseline / totalMapped << "x\n";
 	}
-	materials_map.clear();
+	if (loaded > 0)
+	{
+		std::cout << loaded << " files, " << hardwareThreads << " hardware threads:\n";
+		for (size_t i = 0; i < threadCounts.size(); ++i)
+		{
+			std::cout << "  " << threadCounts[i] << (threadCounts[i] == 1 ? " thread " : " threads ")
+				<< totalThreads[i] * 1000.0 << " ms, " << totalThreads[0] / totalThreads[i] << "x\n";
+		}
+	}
+	return failures;
+}
 
-	return true;
+// Byte-wise ordering, the key order of the std::map that IndexVBO used to use
+struct PackedVertexLess
+{
+	bool operator()(const PackedVertex& lhs, const PackedVertex& rhs) const
+	{
+		return memcmp(&lhs, &rhs, sizeof(PackedVertex)) > 0;
+	}
+};
+
+// The std::map-based IndexVBO this file used to have, kept as the reference
+// for RunIndexVBOChecks. It stored unsigned short indices, which wrapped past
+// 65535 unique vertices; the map holds full indices here so large meshes can
+// be compared too.
+static void IndexVBOReference(
+	std::vector<glm::vec3>& in_vertices,
+	std::vector<glm::vec2>& in_uvs,
+	std::vector<glm::vec3>& in_normals,
+
+	std::vector<unsigned>& out_indices,
+	std::vector<Vertex>& out_vertices
+)
+{
+	std::map<PackedVertex, unsigned, PackedVertexLess> VertexToOutIndex;
+
+	// For each input vertex
+	for (unsigned int i = 0; i < in_vertices.size(); ++i)
+	{
+		PackedVertex packed = { in_vertices[i], in_uvs[i], in_normals[i] };
+
+		// Try to find a similar vertex in out_XXXX
+		std::map<PackedVertex, unsigned, PackedVertexLess>::iterator it = VertexToOutIndex.find(packed);
+		if (it != VertexToOutIndex.end())
+		{
+			// A similar vertex is already in the VBO, use it instead !
+			out_indices.push_back(it->second);
+		}
+		else
+		{
+			// If not, it needs to be added in the output data.
+			Vertex v;
+			v.pos = glm::vec3(in_vertices[i].x, in_vertices[i].y, in_vertices[i].z);
+			v.texCoord = glm::vec2(in_uvs[i].s, in_uvs[i].t);
+			v.normal = glm::vec3(in_normals[i].x, in_normals[i].y, in_normals[i].z);
+			v.color = glm::vec3(1, 1, 1);
+			out_vertices.push_back(v);
+			unsigned newindex = (unsigned)out_vertices.size() - 1;
+			out_indices.push_back(newindex);
+			VertexToOutIndex[packed] = newindex;
+		}
+	}
+}
+
+// Index the same corners with IndexVBO and the reference, appending to
+// out_vertices that already hold a few vertices, and compare both streams
+static int CheckIndexVBO(
+	const std::string& name,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs,
+	std::vector<glm::vec3>& normals
+)
+{
+	Vertex existing = { glm::vec3(1.f, 2.f, 3.f), glm::vec3(1.f), glm::vec3(0.f, 1.f, 0.f), glm::vec2(0.5f) };
+	std::vector<Vertex> hashedVertices(3, existing), mappedVertices(3, existing);
+	std::vector<unsigned> hashedIndices, mappedIndices;
+
+	IndexVBO(vertices, uvs, normals, hashedIndices, hashedVertices);
+	IndexVBOReference(vertices, uvs, normals, mappedIndices, mappedVertices);
+
+	bool passed = hashedIndices == mappedIndices && hashedVertices.size() == mappedVertices.size();
+	for (unsigned i = 0; passed && i < hashedVertices.size(); ++i)
+	{
+		const Vertex& a = hashedVertices[i];
+		const Vertex& b = mappedVertices[i];
+		passed = memcmp(&a.pos, &b.pos, sizeof(a.pos)) == 0 && memcmp(&a.color, &b.color, sizeof(a.color)) == 0 &&
+			memcmp(&a.normal, &b.normal, sizeof(a.normal)) == 0 && memcmp(&a.texCoord, &b.texCoord, sizeof(a.texCoord)) == 0;
+	}
+
+	std::cout << (passed ? "PASS  " : "FAIL  ") << name << ": " << vertices.size() << " corners, "
+		<< hashedVertices.size() - 3 << " unique vertices\n";
+	return passed ? 0 : 1;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Check that the hash-based IndexVBO produces exactly the vertex and index
+streams of the std::map-based version it replaced, on every OBJ under a
+directory and on a synthetic grid with well over 65535 unique vertices.
+The grid also repeats each corner with a -0 normal, which both versions
+must keep as a separate vertex since they compare bit patterns.
+
+\param directory - folder to scan recursively for OBJs, e.g. "Models"
+
+\return
+number of failed meshes
+*/
+/******************************************************************************/
+int RunIndexVBOChecks(const char* directory)
+{
+	int failures = 0;
+
+	std::vector<std::string> files;
+	CollectOBJFiles(directory, files);
+	for (const std::string& obj_path : files)
+	{
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		if (LoadOBJ(obj_path.c_str(), vertices, uvs, normals))
+			failures += CheckIndexVBO(obj_path, vertices, uvs, normals);
+	}
+
+	// 400 x 400 quads of two triangles each, every inner corner shared by six of them
+	const unsigned GRID = 400;
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	for (unsigned z = 0; z < GRID; ++z)
+	{
+		for (unsigned x = 0; x < GRID; ++x)
+		{
+			const unsigned corners[6][2] = { { x, z }, { x + 1, z }, { x + 1, z + 1 }, { x, z }, { x + 1, z + 1 }, { x, z + 1 } };
+			for (unsigned i = 0; i < 6; ++i)
+			{
+				vertices.push_back(glm::vec3((float)corners[i][0], 0.f, (float)corners[i][1]));
+				uvs.push_back(glm::vec2(corners[i][0] / (float)GRID, corners[i][1] / (float)GRID));
+				normals.push_back(glm::vec3(0.f, 1.f, 0.f));
+			}
+		}
+	}
+	size_t gridCorners = vertices.size();
+	for (size_t i = 0; i < gridCorners; i += 7)
+	{
+		vertices.push_back(vertices[i]);
+		uvs.push_back(uvs[i]);
+		normals.push_back(glm::vec3(-0.f, 1.f, 0.f));
+	}
+	failures += CheckIndexVBO("synthetic grid", vertices, uvs, normals);
+
+	std::cout << failures << " failed\n";
+	return failures;
 }
@@ -22,13 +22,20 @@ void IndexVBO(
 	std::vector<Vertex> & out_vertices
 );
 
+// Worker threads used to parse large OBJ files; 0 uses one per hardware thread
+void SetOBJParseThreads(unsigned threads);
+
 bool LoadOBJMTL(
 	const char* file_path, 
 	const char* mtl_path,
 	std::vector<glm::vec3>& out_vertices,
 	std::vector<glm::vec2>& out_uvs,
 	std::vector<glm::vec3>& out_normals,
-	std::vector<Material>& out_materials
+	std::vector<Material>& out_materials,
+	std::vector<MaterialRange>& out_ranges
 );
 
+int RunOBJLoadBenchmark(const char* directory);
+int RunIndexVBOChecks(const char* directory);
+
 #endif
\ No newline at end of file
@@ -1,67 +1,485 @@
-
 #include <iostream>
-#include <fstream>
+#include <cstring>
+#include <string>
+#include <algorithm>
 #include <GL\glew.h>
+#include <GLFW/glfw3.h>
+#include <glm\glm.hpp>
+#include <glm\gtc\matrix_transform.hpp>
 
 #include "LoadTGA.h"
+#include "AssetStreamer.h"
+#include "MappedFile.h"
+#include "MeshBuilder.h"
+#include "shader.hpp"
+#include "TextureCache.h"
+#include "timer.h"
+#include "UniformBlocks.h"
 
-GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+// Header fields we use; only true-colour images are supported
+struct TGAInfo
 {
-	std::ifstream fileStream(file_path, std::ios::binary);
-	if(!fileStream.is_open()) {
-		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
-		return 0;
-	}
+	unsigned width;
+	unsigned height;
+	unsigned bytesPerPixel;
+	bool rle;
+	const GLubyte* pixels;	// start of pixel data in the file
+	const GLubyte* end;		// end of file
+};
+
+// Number of PBOs LoadTGA cycles through, so filling one never waits on the
+// transfer of the texture loaded just before it
+static const unsigned TGA_UPLOAD_BUFFERS = 4;
+static GLuint uploadBuffers[TGA_UPLOAD_BUFFERS] = {};
+static unsigned nextUploadBuffer = 0;
+
+static bool ParseTGAHeader(const MappedFile& file, TGAInfo& info)
+{
+	const GLubyte* data = reinterpret_cast<const GLubyte*>(file.Data());
+	if (file.Size() < 18)
+		return false;
+
+	GLubyte idLength = data[0];
+	GLubyte colorMapType = data[1];
+	GLubyte imageType = data[2];
+	info.width = data[12] + data[13] * 256;
+	info.height = data[14] + data[15] * 256;
+	info.bytesPerPixel = data[16] / 8;
+	info.rle = (imageType == 10);
+	info.pixels = data + 18 + idLength;
+	info.end = data + file.Size();
 
-	GLubyte		header[ 18 ];									// first 6 useful header bytes
-	GLuint		bytesPerPixel;								    // number of bytes per pixel in TGA gile
-	GLuint		imageSize;									    // for setting memory
-	GLubyte *	data;
-	GLuint		texture = 0;
-	unsigned	width, height;
+	return	colorMapType == 0 &&
+		(imageType == 2 || imageType == 10) &&			// true-colour, raw or RLE
+		info.width > 0 && info.height > 0 &&
+		(data[16] == 24 || data[16] == 32) &&			// is TGA 24 or 32 Bit
+		info.pixels <= info.end;
+}
 
-	fileStream.read((char*)header, 18);
-	width = header[12] + header[13] * 256;
-	height = header[14] + header[15] * 256;
+// Decode the pixel data, raw or RLE, into dst (width * height * bytesPerPixel bytes)
+static bool DecodeTGAPixels(const TGAInfo& info, GLubyte* dst)
+{
+	size_t imageSize = static_cast<size_t>(info.width) * info.height * info.bytesPerPixel;
+	const GLubyte* src = info.pixels;
 
- 	if(	width <= 0 ||								// is width <= 0
-		height <= 0 ||								// is height <=0
-		(header[16] != 24 && header[16] != 32))		// is TGA 24 or 32 Bit
+	if (!info.rle)
 	{
-		fileStream.close();							// close file on failure
-		std::cout << "File header error.\n";
-		return 0;										
+		if (static_cast<size_t>(info.end - src) < imageSize)
+			return false;
+		memcpy(dst, src, imageSize);
+		return true;
 	}
 
-	bytesPerPixel	= header[16] / 8;						//divide by 8 to get bytes per pixel
-	imageSize		= width * height * bytesPerPixel;	// calculate memory required for TGA data
-	
-	data = new GLubyte[ imageSize ];
-	fileStream.seekg(18, std::ios::beg);
-	fileStream.read((char *)data, imageSize);
-	fileStream.close();	
+	// Each packet: header byte, then either one pixel repeated (high bit set)
+	// or a run of literal pixels; the count is the low 7 bits + 1
+	const unsigned bpp = info.bytesPerPixel;
+	GLubyte* dstEnd = dst + imageSize;
+	while (dst < dstEnd)
+	{
+		if (src >= info.end)
+			return false;
+		GLubyte packet = *src++;
+		size_t count = (packet & 0x7F) + 1;
+		size_t bytes = count * bpp;
+		if (bytes > static_cast<size_t>(dstEnd - dst))
+			return false;
 
-	glGenTextures(1, &texture);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	if(bytesPerPixel == 3)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
-	else //bytesPerPixel == 4
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, data);
+		if (packet & 0x80)
+		{
+			if (static_cast<size_t>(info.end - src) < bpp)
+				return false;
+			for (size_t i = 0; i < count; ++i, dst += bpp)
+				memcpy(dst, src, bpp);
+			src += bpp;
+		}
+		else
+		{
+			if (static_cast<size_t>(info.end - src) < bytes)
+				return false;
+			memcpy(dst, src, bytes);
+			src += bytes;
+			dst += bytes;
+		}
+	}
+	return true;
+}
 
+// Sample the bound texture trilinearly. Without a cooked mip chain one is
+// built from level 0
+static void SetTGATextureParameters(unsigned levelCount)
+{
 	//to do: modify the texture parameters code from here
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	if (levelCount > 1)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	else
+		glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	float maxAnisotropy = 1.f;
 	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT,
 		&maxAnisotropy);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
-		(GLint)maxAnisotropy);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+		maxAnisotropy);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	//end of modifiable code
+}
+
+// Cooked textures are only used when the driver can sample BC1/BC3
+static bool UseCookedTextures()
+{
+	return GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+// Define level 0 of the bound texture; pixels is a PBO offset when one is bound
+static void TexImageTGA(unsigned width, unsigned height, unsigned bytesPerPixel, const void* pixels)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (bytesPerPixel == 3)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, pixels);
+	else //bytesPerPixel == 4
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Read a TGA file into memory, or its cooked .dds when one is up to date.
+Touches no GL state, so it is safe to call from a worker thread.
+
+\param file_path - path of the TGA file
+\param image - receives the pixels
+\param useCooked - false to always decode the TGA itself
+
+\return true if the file is a 24 or 32 bit true-colour TGA, raw or RLE
+*/
+/******************************************************************************/
+bool DecodeTGA(const char* file_path, TGAImage& image, bool useCooked)
+{
+	if (useCooked && UseCookedTextures())
+	{
+		CookedTexture cooked;
+		if (cooked.Open(GetCookedTexturePath(file_path).c_str(), file_path))
+		{
+			cooked.GetImage(image);
+			return true;
+		}
+	}
+
+	MappedFile file;
+	if (!file.Open(file_path)) {
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return false;
+	}
+
+	TGAInfo info;
+	if (!ParseTGAHeader(file, info))
+	{
+		std::cout << "File header error.\n";
+		return false;
+	}
+
+	image.width = info.width;
+	image.height = info.height;
+	image.bytesPerPixel = info.bytesPerPixel;
+	image.compressedFormat = 0;
+	image.levelCount = 1;
+	image.data.resize(static_cast<size_t>(info.width) * info.height * info.bytesPerPixel);
+	if (!DecodeTGAPixels(info, &image.data[0]))
+	{
+		std::cout << "File data error in " << file_path << "\n";
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload decoded pixels into an existing texture name and set its sampling
+parameters. Must run on the thread that owns the GL context.
+*/
+/******************************************************************************/
+void UploadTGA(GLuint texture, const TGAImage& image)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	if (image.compressedFormat != 0)
+	{
+		const GLubyte* data = &image.data[0];
+		for (unsigned level = 0; level < image.levelCount; ++level)
+		{
+			unsigned width = std::max(image.width >> level, 1u);
+			unsigned height = std::max(image.height >> level, 1u);
+			unsigned size = GetCompressedLevelSize(image.compressedFormat, width, height);
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, image.compressedFormat, width, height, 0, size, data);
+			data += size;
+		}
+	}
+	else
+	{
+		TexImageTGA(image.width, image.height, image.bytesPerPixel, &image.data[0]);
+	}
+	SetTGATextureParameters(image.levelCount);
+}
+
+// Upload a cooked texture straight from its mapped file
+static GLuint LoadCookedTexture(const CookedTexture& cooked)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	for (unsigned level = 0; level < cooked.LevelCount(); ++level)
+	{
+		unsigned width, height, size;
+		const GLubyte* data = cooked.Level(level, width, height, size);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, cooked.Format(), width, height, 0, size, data);
+	}
+	SetTGATextureParameters(cooked.LevelCount());
+	return texture;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load a TGA file into a new texture. An up-to-date cooked .dds next to it is
+used instead when there is one. Otherwise the file is memory-mapped and its
+pixels are decoded straight into a pixel buffer object from a small ring, so
+there is no intermediate heap copy and the driver can transfer one texture
+while the next is being decoded.
+
+\param file_path - path of the TGA file
+
+\return Texture name, or 0 on failure
+*/
+/******************************************************************************/
+GLuint LoadTGA(const char *file_path)				// load TGA file to memory
+{
+	if (UseCookedTextures())
+	{
+		CookedTexture cooked;
+		if (cooked.Open(GetCookedTexturePath(file_path).c_str(), file_path))
+			return LoadCookedTexture(cooked);
+	}
+
+	MappedFile file;
+	if (!file.Open(file_path)) {
+		std::cout << "Impossible to open " << file_path << ". Are you in the right directory ?\n";
+		return 0;
+	}
+
+	TGAInfo info;
+	if (!ParseTGAHeader(file, info))
+	{
+		std::cout << "File header error.\n";
+		return 0;
+	}
+	GLsizeiptr imageSize = static_cast<GLsizeiptr>(info.width) * info.height * info.bytesPerPixel;
+
+	if (uploadBuffers[0] == 0)
+		glGenBuffers(TGA_UPLOAD_BUFFERS, uploadBuffers);
+	GLuint uploadBuffer = uploadBuffers[nextUploadBuffer];
+	nextUploadBuffer = (nextUploadBuffer + 1) % TGA_UPLOAD_BUFFERS;
+
+	// Orphan the buffer's previous storage rather than waiting for the GPU to finish reading it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, imageSize, NULL, GL_STREAM_DRAW);
+	GLubyte* pixels = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageSize,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	bool decoded = pixels != nullptr && DecodeTGAPixels(info, pixels);
+	if (pixels != nullptr)
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	if (!decoded)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		std::cout << "File data error in " << file_path << "\n";
+		return 0;
+	}
+
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	TexImageTGA(info.width, info.height, info.bytesPerPixel, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	SetTGATextureParameters(1);
+
+	return texture;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Streamed version of LoadTGA. Returns a texture name straight away, holding a
+1x1 white placeholder; the file is decoded on a worker thread and uploaded
+into the same name by AssetStreamer::Update.
+*/
+/******************************************************************************/
+GLuint LoadTGAAsync(const char* file_path)
+{
+	return AssetStreamer::GetInstance()->QueueTGA(file_path);
+}
+
+// Free the PBO ring; call before the GL context is destroyed
+void ReleaseTGAUploadBuffers()
+{
+	if (uploadBuffers[0] != 0)
+		glDeleteBuffers(TGA_UPLOAD_BUFFERS, uploadBuffers);
+	memset(uploadBuffers, 0, sizeof(uploadBuffers));
+	nextUploadBuffer = 0;
+}
+
+// Append every .tga under directory, searching subfolders too
+void CollectTGAFiles(const std::string& directory, std::vector<std::string>& out_files)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string name = findData.cFileName;
+		if (name == "." || name == "..")
+			continue;
+		std::string path = directory + "\\" + name;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			CollectTGAFiles(path, out_files);
+		else if (name.size() > 4 && _stricmp(name.c_str() + name.size() - 4, ".tga") == 0)
+			out_files.push_back(path);
+	} while (FindNextFileA(find, &findData));
+	FindClose(find);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load every TGA under a directory with LoadTGA and report, per file and in
+total, the time until the texture is resident (glFinish) and the throughput
+in MB/s of file size. Needs a current GL context.
+
+\param directory - folder to scan recursively, e.g. "Images"
+*/
+/******************************************************************************/
+void RunTGABenchmark(const char* directory)
+{
+	std::vector<std::string> files;
+	CollectTGAFiles(directory, files);
+
+	StopWatch timer;
+	double totalTime = 0.0;
+	double totalMB = 0.0;
+	unsigned loaded = 0;
+	for (const std::string& path : files)
+	{
+		MappedFile file;
+		double fileMB = file.Open(path.c_str()) ? file.Size() / (1024.0 * 1024.0) : 0.0;
+		file.Close();
 
-	delete []data;
+		glFinish();
+		timer.startTimer();
+		GLuint texture = LoadTGA(path.c_str());
+		glFinish();
+		double time = timer.getElapsedTime();
+		if (texture == 0)
+			continue;
+		glDeleteTextures(1, &texture);
+
+		++loaded;
+		totalTime += time;
+		totalMB += fileMB;
+		std::cout << path << ": " << time * 1000.0 << " ms, " << fileMB / time << " MB/s\n";
+	}
+	if (totalTime > 0.0)
+		std::cout << loaded << " files, " << totalMB << " MB in " << totalTime * 1000.0 << " ms, " << totalMB / totalTime << " MB/s\n";
+}
+
+// Draw an 11 x 11 grid of 50-unit ground tiles, the same layout as Scene01's
+// grass, seen from just above the ground so most tiles are at a grazing angle
+static double TimeGroundFrames(Mesh* tile, GLuint programID, unsigned frames)
+{
+	GLint width = 800, height = 600;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.f), (float)width / (float)height, 0.1f, 1000.f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.f, 3.f, 260.f), glm::vec3(0.f, 0.f, -250.f), glm::vec3(0.f, 1.f, 0.f));
+	GLint locationModel = glGetUniformLocation(programID, "model");
+	UniformBlocks::GetInstance()->SetCamera(view, projection);
+
+	StopWatch timer;
+	glFinish();
+	timer.startTimer();
+	for (unsigned frame = 0; frame < frames; ++frame)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		for (float x = -250.f; x <= 250.f; x += 50.f)
+		{
+			for (float z = -250.f; z <= 250.f; z += 50.f)
+			{
+				glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(x, 0.f, z));
+				model = glm::scale(model, glm::vec3(5.f, 1.f, 5.f));
+				model = glm::rotate(model, glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f));
+				glUniformMatrix4fv(locationModel, 1, GL_FALSE, &model[0][0]);
+				tile->Render();
+			}
+		}
+	}
+	glFinish();
+	return timer.getElapsedTime();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Render the tiled ground at a grazing angle with and without mipmaps and
+report the frame time of each, to show the texture bandwidth mipmapping
+saves. Needs a current GL context.
+
+\param file_path - ground texture, e.g. "Images//coast_sand_rocks_02 copy.tga"
+*/
+/******************************************************************************/
+void RunMipBenchmark(const char* file_path)
+{
+	const unsigned frames = 200;
+
+	GLuint texture = LoadTGA(file_path);
+	if (texture == 0)
+		return;
+
+	GLuint programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
+	glUseProgram(programID);
+	glUniform1i(glGetUniformLocation(programID, "lightEnabled"), 0);
+	glUniform1i(glGetUniformLocation(programID, "textEnabled"), 0);
+	glUniform1i(glGetUniformLocation(programID, "colorTextureEnabled"), 1);
+	glUniform1i(glGetUniformLocation(programID, "colorTexture"), 0);
+	UniformBlocks::GetInstance()->BindProgram(programID);
+
+	Mesh* tile = MeshBuilder::GenerateQuad("Ground", glm::vec3(1.f, 1.f, 1.f), 10.f);
+	tile->textureID = texture;
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	struct Mode
+	{
+		const char* name;
+		GLint minFilter;
+		float anisotropy;
+	};
+	float maxAnisotropy = 1.f;
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+	const Mode modes[] = {
+		{ "GL_LINEAR", GL_LINEAR, 1.f },
+		{ "GL_LINEAR_MIPMAP_LINEAR", GL_LINEAR_MIPMAP_LINEAR, 1.f },
+		{ "GL_LINEAR_MIPMAP_LINEAR + anisotropic", GL_LINEAR_MIPMAP_LINEAR, maxAnisotropy },
+	};
+
+	TimeGroundFrames(tile, programID, 10); // warm up
+	for (const Mode& mode : modes)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mode.minFilter);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, mode.anisotropy);
+		double time = TimeGroundFrames(tile, programID, frames);
+		std::cout << mode.name << ": " << time * 1000.0 / frames << " ms per frame\n";
+	}
 
-	return texture;						
-}
\ No newline at end of file
+	delete tile; // releases the texture too
+	glUseProgram(0);
+	glDeleteProgram(programID);
+}
@@ -1,6 +1,33 @@
 #ifndef LOAD_TGA_H
 #define LOAD_TGA_H
 
+#include <vector>
+#include <string>
+#include <GL\glew.h>
+
+// Decoded TGA pixels, kept in file order (BGR/BGRA). Cooked textures are
+// block-compressed instead, with every mip level back to back in data
+struct TGAImage
+{
+	unsigned width;
+	unsigned height;
+	unsigned bytesPerPixel;
+	GLenum compressedFormat;	// 0 for raw pixels
+	unsigned levelCount;
+	std::vector<GLubyte> data;
+
+	TGAImage() : width(0), height(0), bytesPerPixel(0), compressedFormat(0), levelCount(1) {}
+};
+
+bool DecodeTGA(const char* file_path, TGAImage& image, bool useCooked = true);
+void UploadTGA(GLuint texture, const TGAImage& image);
+
 GLuint LoadTGA(const char *file_path);
+GLuint LoadTGAAsync(const char* file_path);
+void ReleaseTGAUploadBuffers();
+
+void CollectTGAFiles(const std::string& directory, std::vector<std::string>& out_files);
+void RunTGABenchmark(const char* directory);
+void RunMipBenchmark(const char* file_path);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,97 @@
+#include "MappedFile.h"
+
+MappedFile::MappedFile()
+	: fileHandle(INVALID_HANDLE_VALUE)
+	, mappingHandle(NULL)
+	, data(nullptr)
+	, size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map the whole file read-only. An empty file opens successfully with Size() 0
+and Data() nullptr, since Windows cannot map a zero-length file.
+
+\param file_path - path of the file to map
+
+\return true if the file could be opened
+*/
+/******************************************************************************/
+bool MappedFile::Open(const char* file_path)
+{
+	Close();
+
+	fileHandle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	if (size == 0)
+		return true;
+
+	mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+	data = nullptr;
+	size = 0;
+}
+
+// Last write time of a file, or 0 if it does not exist
+unsigned long long GetFileWriteTime(const char* file_path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (file_path == nullptr || file_path[0] == '\0' ||
+		!GetFileAttributesExA(file_path, GetFileExInfoStandard, &attributes))
+	{
+		return 0;
+	}
+	return (static_cast<unsigned long long>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+bool ReplaceFileWith(const char* file_path, const char* new_path)
+{
+	if (MoveFileExA(new_path, file_path, MOVEFILE_REPLACE_EXISTING))
+		return true;
+	// e.g. file_path is mapped by a reader; leave it alone
+	DeleteFileA(new_path);
+	return false;
+}
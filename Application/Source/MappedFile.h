@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <windows.h>
+
+/******************************************************************************/
+/*!
+		Class MappedFile:
+\brief	Read-only memory mapping of a whole file, so loaders can parse the
+		bytes in place instead of copying them line by line
+*/
+/******************************************************************************/
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const char* file_path);
+	void Close();
+
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+	const char* data;
+	size_t size;
+};
+
+// Last write time of a file, or 0 if it does not exist
+unsigned long long GetFileWriteTime(const char* file_path);
+
+// Move a fully written file over another one in a single step, so readers
+// see either the old file or the new one, never a half written one
+bool ReplaceFileWith(const char* file_path, const char* new_path);
+
+#endif
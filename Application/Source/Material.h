@@ -6,6 +6,8 @@
 #include <glm\gtc\matrix_transform.hpp>
 #include <glm\gtc\type_ptr.hpp>
 
+#include <string>
+
 // Define the material in C++
 struct Material
 {
@@ -13,11 +15,16 @@ struct Material
 	glm::vec3 kDiffuse;
 	glm::vec3 kSpecular;
 	float kShininess;
-	unsigned size; // Add this member to track the number of faces using this material
+	float dissolve;				// d, 1 is opaque
+	unsigned illum;				// illumination model
+	std::string texturePath;	// map_Kd, joined to the MTL's folder
+	unsigned textureID;			// set once the map_Kd texture is acquired
 	Material() :
 		kAmbient(0.0f, 0.0f, 0.0f), kDiffuse(0.0f, 0.0f, 0.0f), kSpecular(0.0f, 0.0f, 0.0f),
 		kShininess(1.f),
-		size(0)
+		dissolve(1.f),
+		illum(2),
+		textureID(0)
 	{
 	}
 
@@ -27,9 +34,28 @@ struct Material
 		kDiffuse = rhs.kDiffuse;
 		kSpecular = rhs.kSpecular;
 		kShininess = rhs.kShininess;
-		size = rhs.size;
+		dissolve = rhs.dissolve;
+		illum = rhs.illum;
+		texturePath = rhs.texturePath;
+		textureID = rhs.textureID;
 		return *this;
 	}
+
+	// Same look, ignoring the name it was declared under
+	bool operator==(const Material& rhs) const
+	{
+		return kAmbient == rhs.kAmbient && kDiffuse == rhs.kDiffuse && kSpecular == rhs.kSpecular &&
+			kShininess == rhs.kShininess && dissolve == rhs.dissolve && illum == rhs.illum &&
+			texturePath == rhs.texturePath;
+	}
+};
+
+// A run of indices drawn with one entry of a mesh's material table
+struct MaterialRange
+{
+	unsigned material;	// index into the material table
+	unsigned offset;	// first index
+	unsigned count;		// number of indices
 };
 
 #endif
\ No newline at end of file
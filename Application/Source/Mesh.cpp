@@ -1,145 +1,574 @@
 
+#include <iostream>
+#include <cmath>
 #include "Mesh.h"
 #include "GL\glew.h"
+#include <GLFW/glfw3.h>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\matrix_inverse.hpp>
 #include "Vertex.h"
+#include "AssetCache.h"
+#include "UniformBlocks.h"
+#include "MappedFile.h"
+#include "MeshBuilder.h"
+#include "DrawBenchmark.h"
+#include "timer.h"
 
 /******************************************************************************/
 /*!
 \brief
-Default constructor - generate VBO/IBO here
+Default constructor - generate VAO/VBO/IBO here
 
 \param meshName - name of mesh
 */
 /******************************************************************************/
 Mesh::Mesh(const std::string& meshName)
-	: name(meshName)
+	: instanceBuffer(0)
+	, instanceCount(0)
+	, name(meshName)
 	, mode(DRAW_TRIANGLES)
+	, indexSize(0)
 	, textureID(0)
+	, primitive(nullptr)
+	, color(1.f, 1.f, 1.f)
 {
 	glGenBuffers(1, &vertexBuffer);
 	glGenBuffers(1, &indexBuffer);
+
+	// Every mesh shares the Vertex layout, so the VAO is set up once here
+	// and a draw only has to bind it. The index buffer is attached now, so
+	// the uploads that follow in MeshBuilder only fill the buffers, and the
+	// VAO is unbound at the end so later buffer binds cannot change it
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0); // 1st attribute buffer : positions
+	glEnableVertexAttribArray(1); // 2nd attribute buffer : colors
+	glEnableVertexAttribArray(2); // 3rd attribute buffer : normal
+	glEnableVertexAttribArray(3); // 4th attribute buffer : texture coordinate, read only when textured
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(glm::vec3));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBindVertexArray(0);
 }
 
 /******************************************************************************/
 /*!
 \brief
-Destructor - delete VBO/IBO here
+Share a cached primitive's vertex and index buffers. The VAO is this mesh's
+own and leaves the colour attribute array off, so the constant color set
+before each draw stands in for the primitive's vertex colours; everything
+else the scene sets, texture and material included, stays per mesh.
+
+\param meshName - name of mesh
+\param shared - mesh from AssetCache::AcquirePrimitive, released by the destructor
+\param vertexColor - colour of every vertex
+*/
+/******************************************************************************/
+Mesh::Mesh(const std::string& meshName, Mesh* shared, const glm::vec3& vertexColor)
+	: instanceBuffer(0)
+	, instanceCount(0)
+	, name(meshName)
+	, mode(shared->mode)
+	, vertexBuffer(shared->vertexBuffer)
+	, indexBuffer(shared->indexBuffer)
+	, indexSize(shared->indexSize)
+	, textureID(0)
+	, primitive(shared)
+	, color(vertexColor)
+	, lods(shared->lods)
+	, bounds(shared->bounds)
+	, rangeBounds(shared->rangeBounds)
+{
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBindVertexArray(0);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Destructor - delete VAO/VBO/IBO here
 */
 /******************************************************************************/
 Mesh::~Mesh()
 {
-	glDeleteBuffers(1, &vertexBuffer);
-	glDeleteBuffers(1, &indexBuffer);
+	if (primitive != nullptr)
+		AssetCache::GetInstance()->ReleaseMesh(primitive);
+	else
+	{
+		glDeleteBuffers(1, &vertexBuffer);
+		glDeleteBuffers(1, &indexBuffer);
+	}
+	glDeleteVertexArrays(1, &vertexArray);
+	if (instanceBuffer != 0)
+		glDeleteBuffers(1, &instanceBuffer);
+
+	// Textures may be shared through the asset cache
+	AssetCache::GetInstance()->ReleaseTexture(textureID);
+	for (Material& material : materials)
+		AssetCache::GetInstance()->ReleaseTexture(material.textureID);
+}
+
+// Box and sphere of the vertices indices[0..count) refer to
+static Bounds BoundIndices(const Vertex* vertices, const unsigned* indices, unsigned count)
+{
+	Bounds bounds;
+	if (count == 0)
+		return bounds;
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const glm::vec3& pos = vertices[indices[i]].pos;
+		bounds.min = glm::min(bounds.min, pos);
+		bounds.max = glm::max(bounds.max, pos);
+	}
 
-	if (textureID > 0)
-		glDeleteTextures(1, &textureID);
+	// Centred on the box; tighter than half its diagonal for round meshes
+	bounds.center = (bounds.min + bounds.max) * 0.5f;
+	float radiusSquared = 0.f;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		glm::vec3 offset = vertices[indices[i]].pos - bounds.center;
+		radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.radius = std::sqrt(radiusSquared);
+	return bounds;
 }
 
 /******************************************************************************/
 /*!
 \brief
-OpenGL render code
+Compute the model-space bounds used for frustum culling, once for the whole
+mesh and once per material range so parts of a large OBJ can be skipped.
+
+\param vertices - vertex data uploaded to vertexBuffer
+\param indices - index data uploaded to indexBuffer
+\param indexCount - number of indices
+*/
+/******************************************************************************/
+void Mesh::ComputeBounds(const Vertex* vertices, const unsigned* indices, unsigned indexCount)
+{
+	bounds = BoundIndices(vertices, indices, indexCount);
+
+	rangeBounds.clear();
+	for (const MaterialRange& range : materialRanges)
+	{
+		if (range.offset + range.count <= indexCount)
+			rangeBounds.push_back(BoundIndices(vertices, indices + range.offset, range.count));
+		else
+			rangeBounds.push_back(bounds);
+	}
+}
+
+// MTLs reference the artist's .png/.jpg; the game ships TGA copies either
+// next to the MTL, in the matching folder under Images, or in Images itself
+static std::string FindMaterialTexture(const std::string& texture_path)
+{
+	size_t slash = texture_path.find_last_of("/\\");
+	size_t dot = texture_path.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		dot = texture_path.size();
+	std::string stem = texture_path.substr(0, dot);
+	std::string file_name = stem.substr(slash == std::string::npos ? 0 : slash + 1) + ".tga";
+
+	std::string candidates[3] = { stem + ".tga", "", "Images//" + file_name };
+	if (texture_path.compare(0, 6, "Models") == 0)
+		candidates[1] = "Images" + stem.substr(6) + ".tga";
+	for (const std::string& candidate : candidates)
+	{
+		if (!candidate.empty() && GetFileWriteTime(candidate.c_str()) != 0)
+			return candidate;
+	}
+	return std::string();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Load the map_Kd texture of every material through the asset cache. Materials
+without one, or whose texture has no TGA copy, draw with textureID.
+
+\param streamed - load through AssetStreamer instead of blocking
 */
 /******************************************************************************/
-	void Mesh::Render()
+void Mesh::AcquireMaterialTextures(bool streamed)
+{
+	for (Material& material : materials)
 	{
-		glEnableVertexAttribArray(0); // 1st attribute buffer : positions
-		glEnableVertexAttribArray(1); // 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2); // 3rd attribute buffer : normal
-		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		if (material.textureID > 0 || material.texturePath.empty())
+			continue;
+		std::string tga_path = FindMaterialTexture(material.texturePath);
+		if (!tga_path.empty())
+			material.textureID = AssetCache::GetInstance()->AcquireTexture(tga_path, streamed);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+OpenGL render code
+*/
+/******************************************************************************/
+void Mesh::Render()
+{
+	Draw(0, 0);
+}
+
+void Mesh::RenderLod(unsigned level)
+{
+	Draw(0, level);
+}
 
-		if (textureID > 0)
-			glEnableVertexAttribArray(3);
+// Per-instance attributes, interleaved in instanceBuffer
+struct InstanceData
+{
+	glm::mat4 model;
+	glm::mat3 normal;	// inverse transpose of model's upper 3x3
+};
+
+/******************************************************************************/
+/*!
+\brief
+Draw count copies of the mesh in one call. Each copy is placed by its own
+model matrix, applied before the model uniform the caller has set, so
+that only holds the transform shared by every copy.
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(glm::vec3));
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3)));
+The matrices are streamed into instanceBuffer every call, each followed by
+its normal matrix so the shader does not invert one per vertex. Orphaning
+the old storage first lets the driver hand out fresh memory instead of
+waiting for the previous draw to finish reading it.
 
-		if (textureID > 0)
-			glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec3)));
+\param models - model matrix of every copy
+\param count - number of copies
+*/
+/******************************************************************************/
+void Mesh::RenderInstanced(const glm::mat4* models, unsigned count)
+{
+	if (count == 0)
+		return;
 
+	bool firstUse = instanceBuffer == 0;
+	if (firstUse)
+		glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-		if (materials.size() == 0)
+	// A mat4 attribute takes four locations and a mat3 three, one per column.
+	// They stay in the VAO; plain draws leave them unread as instanced is off then
+	if (firstUse)
+	{
+		glBindVertexArray(vertexArray);
+		for (unsigned column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(4 + column);
+			glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(column * sizeof(glm::vec4)));
+			glVertexAttribDivisor(4 + column, 1);
+		}
+		for (unsigned column = 0; column < 3; ++column)
 		{
-			if (mode == DRAW_TRIANGLE_STRIP)
-				glDrawElements(GL_TRIANGLE_STRIP, indexSize, GL_UNSIGNED_INT, 0);
-			else if (mode == DRAW_LINES)
-				glDrawElements(GL_LINES, indexSize, GL_UNSIGNED_INT, 0);
-			else
-				glDrawElements(GL_TRIANGLES, indexSize, GL_UNSIGNED_INT, 0);
+			glEnableVertexAttribArray(8 + column);
+			glVertexAttribPointer(8 + column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(sizeof(glm::mat4) + column * sizeof(glm::vec3)));
+			glVertexAttribDivisor(8 + column, 1);
 		}
+	}
+
+	InstanceData* instances = static_cast<InstanceData*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (instances == nullptr)
+		return;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		instances[i].model = models[i];
+		instances[i].normal = glm::inverseTranspose(glm::mat3(models[i]));
+	}
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	instanceCount = count;
+
+	glUniform1i(locationInstanced, 1);
+	Draw(count, 0);
+	glUniform1i(locationInstanced, 0);
+}
+
+static void DrawElements(Mesh::DRAW_MODE mode, unsigned count, unsigned offset, unsigned instances)
+{
+	GLenum primitive = GL_TRIANGLES;
+	if (mode == Mesh::DRAW_TRIANGLE_STRIP)
+		primitive = GL_TRIANGLE_STRIP;
+	else if (mode == Mesh::DRAW_LINES)
+		primitive = GL_LINES;
+
+	if (primitive == GL_TRIANGLES)
+		Mesh::trianglesDrawn += count / 3 * (instances == 0 ? 1 : instances);
+	else if (primitive == GL_TRIANGLE_STRIP && count > 2)
+		Mesh::trianglesDrawn += (count - 2) * (instances == 0 ? 1 : instances);
+
+	if (instances == 0)
+		glDrawElements(primitive, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
+	else
+		glDrawElementsInstanced(primitive, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)), instances);
+}
+
+// The colour attribute's constant value is not VAO state, so it is set per draw
+void Mesh::Bind()
+{
+	glBindVertexArray(vertexArray);
+	if (primitive != nullptr)
+		glVertexAttrib3fv(1, &color[0]);
+}
+
+// Shared by Render and RenderInstanced; instances is 0 for a plain draw
+void Mesh::Draw(unsigned instances, unsigned level)
+{
+	Bind();
+	// Levels are triangle lists whatever the full mesh is drawn as
+	const MeshLod* lod = level > 0 && level <= lods.size() ? &lods[level - 1] : nullptr;
+	DRAW_MODE drawMode = lod ? DRAW_TRIANGLES : mode;
+	if (materialRanges.size() == 0)
+	{
+		if (lod)
+			DrawElements(drawMode, lod->count, lod->offset, instances);
 		else
+			DrawElements(drawMode, indexSize, 0, instances);
+	}
+	else
+	{
+		const std::vector<MaterialRange>& ranges = lod ? lod->ranges : materialRanges;
+		// A material's own texture replaces textureID for its ranges
+		GLuint boundTexture = textureID;
+		for (unsigned i = 0; i < ranges.size(); ++i)
 		{
-			for (unsigned i = 0, offset = 0; i < materials.size(); ++i)
+			const MaterialRange& range = ranges[i];
+			Material& material = materials[range.material];
+			UniformBlocks::GetInstance()->SetMaterial(material);
+
+			GLuint texture = material.textureID > 0 ? material.textureID : textureID;
+			if (texture != boundTexture)
 			{
-				Material& material = materials[i];
-				glUniform3fv(locationKa, 1, &material.kAmbient.r);
-				glUniform3fv(locationKd, 1, &material.kDiffuse.r);
-				glUniform3fv(locationKs, 1, &material.kSpecular.r);
-				glUniform1f(locationNs, material.kShininess);
-				if (mode == DRAW_TRIANGLE_STRIP)
-					glDrawElements(GL_TRIANGLE_STRIP, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
-				else if (mode == DRAW_LINES)
-					glDrawElements(GL_LINES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
-				else
-					glDrawElements(GL_TRIANGLES, material.size, GL_UNSIGNED_INT, (void*)(offset * sizeof(unsigned)));
-				offset += material.size;
+				glUniform1i(locationTextureEnabled, texture > 0 ? 1 : 0);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, texture);
+				boundTexture = texture;
 			}
-		}
 
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(2);
+			DrawElements(drawMode, range.count, range.offset, instances);
+		}
 
-		if (textureID > 0)
-			glDisableVertexAttribArray(3);
+		// Leave the texture state as the caller set it
+		if (boundTexture != textureID)
+		{
+			glUniform1i(locationTextureEnabled, textureID > 0 ? 1 : 0);
+			glBindTexture(GL_TEXTURE_2D, textureID);
 		}
+	}
+}
 
 
-	void Mesh::Render(unsigned offset, unsigned count)
-	{
-		glEnableVertexAttribArray(0); // 1st attribute buffer: vertices
-			glEnableVertexAttribArray(1); // 2nd attribute buffer: colors
-			glEnableVertexAttribArray(2); // 3rd attribute buffer: normals
+void Mesh::Render(unsigned offset, unsigned count, unsigned level)
+{
+	Bind();
+	DrawElements(level > 0 ? DRAW_TRIANGLES : mode, count, offset, 0);
+}
 
-			if (textureID > 0)
-				glEnableVertexAttribArray(3); // 4th attribute: texture coordinate
+// Screen-space error, in pixels, a level may show before a finer one is used
+static const float LOD_PIXEL_ERROR = 1.f;
+// Switches wait until the error is this fraction past the threshold, so a
+// placement sitting at a boundary does not pop back and forth
+static const float LOD_HYSTERESIS = 0.25f;
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+/******************************************************************************/
+/*!
+\brief
+Pick the coarsest level whose error, projected at the nearest point of the
+mesh's bounding sphere, stays under LOD_PIXEL_ERROR. Coming from lastLevel,
+a coarser level is only taken once it is comfortably under the threshold,
+and a finer one only once lastLevel is clearly over it.
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(glm::vec3));
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3)));
+\param model - model matrix of the placement
+\param eye - camera position, world space
+\param pixelScale - projection[1][1] * viewport height / 2
+\param lastLevel - level drawn last time, or LOD_NONE
 
-		if (textureID > 0)
-			glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec3)));
+\return level to draw, 0 being the full mesh
+*/
+/******************************************************************************/
+unsigned Mesh::SelectLod(const glm::mat4& model, const glm::vec3& eye, float pixelScale, unsigned lastLevel) const
+{
+	if (lods.empty() || bounds.IsEmpty())
+		return 0;
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	// Errors are in model units; the largest axis scale keeps them conservative
+	float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.f));
+	float distance = glm::length(center - eye) - bounds.radius * scale;
+	if (distance <= 0.f)
+		return 0;
+	float pixelsPerUnit = pixelScale * scale / distance;
 
-		if (mode == DRAW_LINES)
-			glDrawElements(GL_LINES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-		else if (mode == DRAW_TRIANGLE_STRIP)
-			glDrawElements(GL_TRIANGLE_STRIP, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-		else
-			glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(offset * sizeof(GLuint)));
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		glDisableVertexAttribArray(2);
-		if (textureID > 0)
-			glDisableVertexAttribArray(3);
-	
+	auto coarsest = [&](float limit) {
+		unsigned level = 0;
+		while (level < lods.size() && lods[level].error * pixelsPerUnit <= limit)
+			++level;
+		return level;
+	};
+
+	unsigned target = coarsest(LOD_PIXEL_ERROR);
+	if (lastLevel > lods.size() || target == lastLevel)
+		return target;
+	if (target > lastLevel)
+		return glm::max(lastLevel, coarsest(LOD_PIXEL_ERROR * (1.f - LOD_HYSTERESIS)));
+	float lastError = lods[lastLevel - 1].error * pixelsPerUnit;
+	return lastError > LOD_PIXEL_ERROR * (1.f + LOD_HYSTERESIS) ? target : lastLevel;
+}
+
+unsigned Mesh::locationTextureEnabled = static_cast<unsigned>(-1); // -1: glUniform ignores it
+unsigned Mesh::locationInstanced = static_cast<unsigned>(-1);
+unsigned Mesh::trianglesDrawn = 0;
+void Mesh::SetTextureLoc(unsigned textureEnabled)
+{
+	locationTextureEnabled = textureEnabled;
+}
+
+void Mesh::SetInstancedLoc(unsigned instanced)
+{
+	locationInstanced = instanced;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw a square grid of textured ground tiles, first with one draw call per
+tile and then with a single RenderInstanced, and report the draw calls and
+frame time of each. Needs a current GL context.
+
+\param tiles - number of tiles, rounded down to a square grid
+*/
+/******************************************************************************/
+void RunInstancingBenchmark(unsigned tiles)
+{
+	const float spacing = 12.f;
+
+	unsigned side = static_cast<unsigned>(std::sqrt(static_cast<float>(tiles)));
+	if (side == 0)
+		return;
+	tiles = side * side;
+
+	DrawBenchmark benchmark;
+	glUniform1i(benchmark.GetUniform("lightEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("textEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("colorTextureEnabled"), 1);
+	glUniform1i(benchmark.GetUniform("colorTexture"), 0);
+	GLint locationModel = benchmark.GetUniform("model");
+	Mesh::SetInstancedLoc(benchmark.GetUniform("instanced"));
+
+	Mesh* tile = MeshBuilder::GenerateQuad("Ground", glm::vec3(1.f, 1.f, 1.f), 10.f);
+	tile->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga");
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tile->textureID);
+
+	std::vector<glm::mat4> models;
+	models.reserve(tiles);
+	float half = (side - 1) * spacing * 0.5f;
+	for (unsigned x = 0; x < side; ++x)
+	{
+		for (unsigned z = 0; z < side; ++z)
+		{
+			glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(x * spacing - half, 0.f, z * spacing - half));
+			models.push_back(glm::rotate(model, glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f)));
+		}
 	}
 
-unsigned Mesh::locationKa;
-unsigned Mesh::locationKd;
-unsigned Mesh::locationKs;
-unsigned Mesh::locationNs;
-void Mesh::SetMaterialLoc(unsigned ambient, unsigned diffuse, unsigned specular, unsigned shininess)
-{
-	locationKa = ambient;
-	locationKd = diffuse;
-	locationKs = specular;
-	locationNs = shininess;
-}
\ No newline at end of file
+	GLint width = 800, height = 600;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.f), (float)width / (float)height, 0.1f, 5000.f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.f, half, half * 2.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	UniformBlocks::GetInstance()->SetCamera(view, projection);
+	const glm::mat4 identity(1.f);
+
+	benchmark.Run("One draw per tile: ", "draw calls", [&]() {
+		for (const glm::mat4& model : models)
+		{
+			glUniformMatrix4fv(locationModel, 1, GL_FALSE, &model[0][0]);
+			tile->Render();
+		}
+		return tiles;
+	});
+	benchmark.Run("Instanced: ", "draw calls", [&]() {
+		glUniformMatrix4fv(locationModel, 1, GL_FALSE, &identity[0][0]);
+		tile->RenderInstanced(&models[0], tiles);
+		return 1u;
+	});
+
+	delete tile; // releases the texture too
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw a row of 64x64 spheres receding from the camera, first all in full and
+then at the levels SelectLod picks, and report the triangles and frame time
+of each. Needs a current GL context.
+
+\param copies - number of spheres
+*/
+/******************************************************************************/
+void RunLodBenchmark(unsigned copies)
+{
+	const float spacing = 8.f;
+
+	DrawBenchmark benchmark;
+	glUniform1i(benchmark.GetUniform("lightEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("textEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("colorTextureEnabled"), 0);
+	GLint locationModel = benchmark.GetUniform("model");
+
+	StopWatch timer;
+	timer.startTimer();
+	Mesh* sphere = MeshBuilder::GenerateSphere("Sphere", glm::vec3(0.8f, 0.3f, 0.3f), 1.f, 64, 64);
+	std::cout << "Built sphere with " << sphere->lods.size() << " levels in " << timer.getElapsedTime() * 1000.0 << " ms\n";
+
+	std::vector<glm::mat4> models;
+	for (unsigned i = 0; i < copies; ++i)
+		models.push_back(glm::translate(glm::mat4(1.f), glm::vec3((i % 2 ? 2.f : -2.f), 0.f, -5.f - i * spacing)));
+	std::vector<LodState> states(copies);
+
+	GLint width = 800, height = 600;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.f), (float)width / (float)height, 0.1f, 5000.f);
+	glm::vec3 eye(0.f, 1.f, 0.f);
+	glm::mat4 view = glm::lookAt(eye, glm::vec3(0.f, 0.f, -1000.f), glm::vec3(0.f, 1.f, 0.f));
+	UniformBlocks::GetInstance()->SetCamera(view, projection);
+	float pixelScale = projection[1][1] * height * 0.5f;
+
+	benchmark.Run("Full detail: ", "triangles", [&]() {
+		Mesh::trianglesDrawn = 0;
+		for (const glm::mat4& model : models)
+		{
+			glUniformMatrix4fv(locationModel, 1, GL_FALSE, &model[0][0]);
+			sphere->Render();
+		}
+		return Mesh::trianglesDrawn;
+	});
+	benchmark.Run("LOD: ", "triangles", [&]() {
+		Mesh::trianglesDrawn = 0;
+		for (unsigned i = 0; i < copies; ++i)
+		{
+			glUniformMatrix4fv(locationModel, 1, GL_FALSE, &models[i][0][0]);
+			states[i].level[0] = sphere->SelectLod(models[i], eye, pixelScale, states[i].level[0]);
+			sphere->RenderLod(states[i].level[0]);
+		}
+		return Mesh::trianglesDrawn;
+	});
+
+	delete sphere;
+}
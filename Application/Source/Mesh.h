@@ -4,8 +4,12 @@
 #include <string>
 #include <vector>
 #include "Material.h"
+#include "Bounds.h"
+#include "MeshLod.h"
 #include <GL/glew.h>
 
+struct Vertex;
+
 /******************************************************************************/
 /*!
 		Class Mesh:
@@ -23,16 +27,21 @@ public:
 		DRAW_MODE_LAST,
 	};
 
-	GLuint instanceBuffer;
-	unsigned instanceCount;
+	GLuint instanceBuffer;		// per-instance model matrices, created on first use
+	unsigned instanceCount;		// matrices uploaded by the last RenderInstanced
 
 	Mesh(const std::string& meshName);
+	// Draw a cached primitive's buffers in color; holds one AssetCache reference to it
+	Mesh(const std::string& meshName, Mesh* shared, const glm::vec3& vertexColor);
 	~Mesh();
 
 	void Render();
+	// Draw count copies in one call; models are relative to the model uniform
+	void RenderInstanced(const glm::mat4* models, unsigned count);
 
 	const std::string name;
 	DRAW_MODE mode;
+	unsigned vertexArray;		// VAO holding the attribute layout and index buffer
 	unsigned vertexBuffer;
 	unsigned indexBuffer;
 	unsigned indexSize;
@@ -40,15 +49,50 @@ public:
 	Material material;
 	unsigned textureID;
 
-	static void SetMaterialLoc(unsigned kA, unsigned kD, unsigned kS, unsigned nS);
+	// Shared geometry this mesh draws, or nullptr when it owns its buffers.
+	// Such a mesh has no colour attribute array; color is applied to every vertex instead
+	Mesh* primitive;
+	glm::vec3 color;
+
+	// Decimated levels after the full mesh in indexBuffer, finest first; level 0 is the mesh itself
+	std::vector<MeshLod> lods;
+	// Level to draw at model, seen from eye. pixelScale is projection[1][1] times
+	// half the viewport height; lastLevel is held while inside the hysteresis band
+	unsigned SelectLod(const glm::mat4& model, const glm::vec3& eye, float pixelScale, unsigned lastLevel = LOD_NONE) const;
+	// Render() at a level, materials included
+	void RenderLod(unsigned level);
+
+	// Triangles drawn by every mesh since the caller last reset it
+	static unsigned trianglesDrawn;
+
+	Bounds bounds;						// whole mesh, model space
+	std::vector<Bounds> rangeBounds;	// one per materialRanges entry
+	// Fill bounds and rangeBounds from the data just uploaded; call after materialRanges is set
+	void ComputeBounds(const Vertex* vertices, const unsigned* indices, unsigned indexCount);
+
+	// colorTextureEnabled, switched for materials with their own texture
+	static void SetTextureLoc(unsigned textureEnabled);
+	// instanced, switched on around RenderInstanced
+	static void SetInstancedLoc(unsigned instanced);
 	// Step 11 - Add the following variables
-	std::vector<Material> materials;
-	static unsigned locationKa;
-	static unsigned locationKd;
-	static unsigned locationKs;
-	static unsigned locationNs;
+	std::vector<Material> materials;			// material table
+	std::vector<MaterialRange> materialRanges;	// index runs, each drawn with one material
+	static unsigned locationTextureEnabled;
+	static unsigned locationInstanced;
+
+	void AcquireMaterialTextures(bool streamed);
 
-	void Render(unsigned offset, unsigned count);
+	// Draw indices [offset, offset + count) of a level, which decides the primitive type
+	void Render(unsigned offset, unsigned count, unsigned level = 0);
+
+private:
+	void Bind();
+	void Draw(unsigned instances, unsigned level);
 };
 
+// Time a grid of tiles drawn one call each against one instanced call
+void RunInstancingBenchmark(unsigned tiles);
+// Time a row of high-poly spheres receding from the camera, drawn in full and with LOD selection
+void RunLodBenchmark(unsigned copies);
+
 #endif
\ No newline at end of file
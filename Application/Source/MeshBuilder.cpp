@@ -1,10 +1,20 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cstdio>
+#include <iostream>
 
 #include "MeshBuilder.h"
 #include <GL\glew.h>
 #include <vector>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <iterator>
 #include "LoadOBJ.h"
+#include "MeshCache.h"
+#include "AssetStreamer.h"
+#include "AssetCache.h"
+#include "timer.h"
 
 /******************************************************************************/
 /*!
@@ -53,6 +63,7 @@ Mesh* MeshBuilder::GenerateAxes(const std::string& meshName, float lengthX, floa
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
 
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_LINES;
 
 	return mesh;
@@ -103,6 +114,7 @@ Mesh* MeshBuilder::GenerateQuad(const std::string& meshName, glm::vec3 color, fl
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
 
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
@@ -172,12 +184,13 @@ Mesh* MeshBuilder::GenerateCube(const std::string& meshName, glm::vec3 color, fl
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
 
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
 }
 
-Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, glm::vec3 color, float radius, int numSlice, int numStack)
+Mesh* MeshBuilder::BuildSphere(const std::string& meshName, glm::vec3 color, float radius, int numSlice, int numStack)
 {
 	Vertex v; // Vertex definition
 	std::vector<Vertex> vertex_buffer_data; // Vertex Buffer Objects (VBOs)
@@ -215,6 +228,10 @@ Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, glm::vec3 color,
 		}
 	}
 
+	unsigned stripSize = index_buffer_data.size();
+	std::vector<MeshLod> lods;
+	GenerateSphereLods(radius, numSlice, numStack, index_buffer_data, lods);
+
 	// Create the new mesh
 	Mesh* mesh = new Mesh(meshName);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
@@ -225,12 +242,14 @@ Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, glm::vec3 color,
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() *
 		sizeof(GLuint),
 		&index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	mesh->indexSize = stripSize;
+	mesh->lods = lods;
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], stripSize);
 	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
 	return mesh;
 }
 
-Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, glm::vec3 color, float innerR, float outerR, int numSlice, int numStack)
+Mesh* MeshBuilder::BuildTorus(const std::string& meshName, glm::vec3 color, float innerR, float outerR, int numSlice, int numStack)
 {
 	Vertex v; // Vertex definition
 	std::vector<Vertex> vertex_buffer_data; // Vertex Buffer Objects (VBOs)
@@ -276,11 +295,12 @@ Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, glm::vec3 color, f
 		sizeof(GLuint),
 		&index_buffer_data[0], GL_STATIC_DRAW);
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_TRIANGLE_STRIP;
 	return mesh;
 }
 
-Mesh* MeshBuilder::GenerateHemisphere(const std::string& meshName, glm::vec3 color, unsigned numStack, unsigned numSlice, float radius)
+Mesh* MeshBuilder::BuildHemisphere(const std::string& meshName, glm::vec3 color, unsigned numStack, unsigned numSlice, float radius)
 {
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<GLuint> index_buffer_data;
@@ -380,6 +400,7 @@ Mesh* MeshBuilder::GenerateHemisphere(const std::string& meshName, glm::vec3 col
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
 
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
@@ -387,7 +408,7 @@ Mesh* MeshBuilder::GenerateHemisphere(const std::string& meshName, glm::vec3 col
 
 
 
-Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, glm::vec3 color, unsigned numSlice, float radius, float height)
+Mesh* MeshBuilder::BuildCylinder(const std::string& meshName, glm::vec3 color, unsigned numSlice, float radius, float height)
 {
 	Vertex v;
 	v.color = color;
@@ -505,12 +526,116 @@ Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, glm::vec3 color
 		GL_STATIC_DRAW);
 
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
 }
 
 
+// Chord error, in model units, that adaptive segment counts keep under
+static const float PRIMITIVE_TOLERANCE = 0.005f;
+static const unsigned PRIMITIVE_MIN_SEGMENTS = 12;
+static const unsigned PRIMITIVE_MAX_SEGMENTS = 96;
+
+unsigned MeshBuilder::AdaptiveSegments(float radius)
+{
+	radius = std::fabs(radius);
+	if (radius <= PRIMITIVE_TOLERANCE)
+		return PRIMITIVE_MIN_SEGMENTS;
+
+	// A chord spanning angle a sags radius * (1 - cos(a / 2)) inside the circle
+	float angle = 2.f * std::acos(1.f - PRIMITIVE_TOLERANCE / radius);
+	unsigned segments = static_cast<unsigned>(std::ceil(glm::two_pi<float>() / angle));
+	segments = (segments + 3) / 4 * 4; // keeps the quarter points on the circle
+	return glm::clamp(segments, PRIMITIVE_MIN_SEGMENTS, PRIMITIVE_MAX_SEGMENTS);
+}
+
+Mesh* MeshBuilder::SharePrimitive(const std::string& meshName, const std::string& key, glm::vec3 color, const std::function<Mesh*()>& build)
+{
+	Mesh* primitive = AssetCache::GetInstance()->AcquirePrimitive(key, build);
+	if (primitive == nullptr)
+		return nullptr;
+	return new Mesh(meshName, primitive, color);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get a sphere drawing the cached geometry for its radius and tessellation,
+building it the first time they are asked for
+
+\param meshName - name of mesh
+\param color - colour of every vertex, applied when drawn
+\param radius - radius of the sphere
+\param numSlice - segments around the equator, 0 for AdaptiveSegments
+\param numStack - segments from pole to pole, 0 for half the adaptive count
+
+\return Pointer to a mesh of its own, sharing the buffers
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateSphere(const std::string& meshName, glm::vec3 color, float radius, int numSlice, int numStack)
+{
+	if (numSlice <= 0)
+		numSlice = AdaptiveSegments(radius);
+	if (numStack <= 0)
+		numStack = AdaptiveSegments(radius) / 2;
+
+	// %.9g keeps every float bit, so sizes %g would round together get keys of their own
+	char key[64];
+	snprintf(key, sizeof(key), "sphere %.9g %d %d", radius, numSlice, numStack);
+	std::string name = key;
+	return SharePrimitive(meshName, key, color, [=]() {
+		return BuildSphere(name, glm::vec3(1.f, 1.f, 1.f), radius, numSlice, numStack);
+	});
+}
+
+// As GenerateSphere; slices go round the tube, stacks round the ring
+Mesh* MeshBuilder::GenerateTorus(const std::string& meshName, glm::vec3 color, float innerR, float outerR, int numSlice, int numStack)
+{
+	if (numSlice <= 0)
+		numSlice = AdaptiveSegments(innerR);
+	if (numStack <= 0)
+		numStack = AdaptiveSegments(std::fabs(outerR) + std::fabs(innerR));
+
+	char key[64];
+	snprintf(key, sizeof(key), "torus %.9g %.9g %d %d", innerR, outerR, numSlice, numStack);
+	std::string name = key;
+	return SharePrimitive(meshName, key, color, [=]() {
+		return BuildTorus(name, glm::vec3(1.f, 1.f, 1.f), innerR, outerR, numSlice, numStack);
+	});
+}
+
+// As GenerateSphere
+Mesh* MeshBuilder::GenerateCylinder(const std::string& meshName, glm::vec3 color, unsigned numSlice, float radius, float height)
+{
+	if (numSlice == 0)
+		numSlice = AdaptiveSegments(radius);
+
+	char key[64];
+	snprintf(key, sizeof(key), "cylinder %u %.9g %.9g", numSlice, radius, height);
+	std::string name = key;
+	return SharePrimitive(meshName, key, color, [=]() {
+		return BuildCylinder(name, glm::vec3(1.f, 1.f, 1.f), numSlice, radius, height);
+	});
+}
+
+// As GenerateSphere; stacks span the 90 degrees from the rim to the top
+Mesh* MeshBuilder::GenerateHemisphere(const std::string& meshName, glm::vec3 color, unsigned numStack, unsigned numSlice, float radius)
+{
+	if (numSlice == 0)
+		numSlice = AdaptiveSegments(radius);
+	if (numStack == 0)
+		numStack = AdaptiveSegments(radius) / 4;
+
+	char key[64];
+	snprintf(key, sizeof(key), "hemisphere %u %u %.9g", numStack, numSlice, radius);
+	std::string name = key;
+	return SharePrimitive(meshName, key, color, [=]() {
+		return BuildHemisphere(name, glm::vec3(1.f, 1.f, 1.f), numStack, numSlice, radius);
+	});
+}
+
 Mesh* MeshBuilder::GenerateHead(const std::string& meshName, glm::vec3 color, unsigned numStack, unsigned numSlice, float radius, float cylHeight)
 {
 	std::vector<Vertex> vData;
@@ -633,6 +758,7 @@ Mesh* MeshBuilder::GenerateHead(const std::string& meshName, glm::vec3 color, un
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, iData.size() * sizeof(GLuint), &iData[0], GL_STATIC_DRAW);
 
 	mesh->indexSize = iData.size();
+	mesh->ComputeBounds(&vData[0], &iData[0], iData.size());
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 	return mesh;
 }
@@ -653,6 +779,8 @@ Mesh* MeshBuilder::GenerateOBJ(const std::string& meshName, const
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<GLuint> index_buffer_data;
 	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+	std::vector<MeshLod> lods;
+	GenerateLods(vertex_buffer_data, index_buffer_data, std::vector<MaterialRange>(), index_buffer_data, lods);
 
 	Mesh* mesh = new Mesh(meshName);
 
@@ -660,7 +788,9 @@ Mesh* MeshBuilder::GenerateOBJ(const std::string& meshName, const
 	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	mesh->indexSize = BaseIndexCount(lods, index_buffer_data.size());
+	mesh->lods = lods;
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], mesh->indexSize);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 
 	return mesh;
@@ -675,32 +805,82 @@ Mesh* MeshBuilder::GenerateOBJMTL(const std::string& meshName,
 	std::vector<glm::vec2> uvs;
 	std::vector<glm::vec3> normals;
 	std::vector<Material> materials;
+	std::vector<MaterialRange> ranges;
 
-	bool success = LoadOBJMTL(file_path.c_str(), mtl_path.c_str(), vertices, uvs, normals, materials);
+	// Use the cooked .mesh if it is newer than the OBJ/MTL it came from
+	std::string cache_path = GetCookedMeshPath(file_path);
+	CookedMesh cooked;
+	if (cooked.Open(cache_path.c_str(), file_path.c_str(), mtl_path.c_str()))
+	{
+		Mesh* mesh = new Mesh(meshName);
+
+		cooked.GetMaterials(mesh->materials);
+		cooked.GetMaterialRanges(mesh->materialRanges);
+		cooked.GetLods(mesh->lods);
+		mesh->AcquireMaterialTextures(false);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, cooked.VertexCount() * sizeof(Vertex), cooked.Vertices(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, cooked.IndexCount() * sizeof(GLuint), cooked.Indices(), GL_STATIC_DRAW);
+		mesh->indexSize = BaseIndexCount(mesh->lods, cooked.IndexCount());
+		mesh->ComputeBounds(cooked.Vertices(), cooked.Indices(), mesh->indexSize);
+		mesh->mode = Mesh::DRAW_TRIANGLES;
+		return mesh;
+	}
+
+	bool success = LoadOBJMTL(file_path.c_str(), mtl_path.c_str(), vertices, uvs, normals, materials, ranges);
 	if (!success) return NULL;
 
 	//Index the vertices, texcoords & normals properly
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<GLuint> index_buffer_data;
 	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+	std::vector<MeshLod> lods;
+	GenerateLods(vertex_buffer_data, index_buffer_data, ranges, index_buffer_data, lods);
+
+	// Cook it so the next load skips the text parse and the decimation
+	WriteCookedMesh(cache_path.c_str(), file_path.c_str(), mtl_path.c_str(), vertex_buffer_data, index_buffer_data, materials, ranges, lods);
 
 	Mesh* mesh = new Mesh(meshName);
 
-	for (Material& material : materials) 
-		mesh->materials.push_back(material);
+	mesh->materials = materials;
+	mesh->materialRanges = ranges;
+	mesh->lods = lods;
+	mesh->AcquireMaterialTextures(false);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
 	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_data.size() * sizeof(Vertex), &vertex_buffer_data[0], GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_data.size() * sizeof(GLuint), &index_buffer_data[0], GL_STATIC_DRAW);
-	mesh->indexSize = index_buffer_data.size();
+	mesh->indexSize = BaseIndexCount(lods, index_buffer_data.size());
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], mesh->indexSize);
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 	return mesh;
 }
 
+/******************************************************************************/
+/*!
+\brief
+Streamed version of GenerateOBJMTL. Returns an empty placeholder mesh at once;
+the OBJ is loaded on a worker thread and uploaded by AssetStreamer::Update.
+
+\param meshName - name of mesh
+\param file_path - OBJ file
+\param mtl_path - MTL file
+
+\return Pointer to the placeholder mesh
+*/
+/******************************************************************************/
+Mesh* MeshBuilder::GenerateOBJMTLAsync(const std::string& meshName,
+	const std::string& file_path, const std::string& mtl_path)
+{
+	return AssetStreamer::GetInstance()->QueueOBJMTL(meshName, file_path, mtl_path);
+}
+
 
 Mesh* MeshBuilder::GenerateText(const std::string& meshName, unsigned numRow, unsigned numCol)
 {
 	Vertex v;
+	v.color = glm::vec3(1, 1, 1); // Text.fragmentshader tints it by textColor
 	std::vector<Vertex> vertex_buffer_data;
 	std::vector<unsigned> index_buffer_data;
 
@@ -747,5 +927,524 @@ Mesh* MeshBuilder::GenerateText(const std::string& meshName, unsigned numRow, un
 
 	mesh->mode = Mesh::DRAW_TRIANGLES;
 	mesh->indexSize = index_buffer_data.size();
+	mesh->ComputeBounds(&vertex_buffer_data[0], &index_buffer_data[0], index_buffer_data.size());
 	return mesh;
 }
+
+// Meshes smaller than this are drawn in full at any distance
+static const unsigned LOD_MIN_TRIANGLES = 256;
+// Triangles kept by each level, as a fraction of the full mesh
+static const float LOD_RATIOS[] = { 0.5f, 0.25f, 0.125f };
+static const unsigned LOD_LEVELS = sizeof(LOD_RATIOS) / sizeof(LOD_RATIOS[0]);
+// A level is dropped unless it removes at least this share of the one before
+static const float LOD_MIN_REDUCTION = 0.15f;
+// Open edges count this much more than faces, so holes and material borders keep their outline
+static const double LOD_BORDER_WEIGHT = 10.0;
+
+// Sum of squared distances to a set of planes, as the upper triangle of a
+// symmetric 4x4 matrix
+struct Quadric
+{
+	double a[10];
+
+	Quadric() { for (double& value : a) value = 0.0; }
+
+	void AddPlane(const glm::dvec3& n, double d, double weight)
+	{
+		a[0] += weight * n.x * n.x; a[1] += weight * n.x * n.y; a[2] += weight * n.x * n.z; a[3] += weight * n.x * d;
+		a[4] += weight * n.y * n.y; a[5] += weight * n.y * n.z; a[6] += weight * n.y * d;
+		a[7] += weight * n.z * n.z; a[8] += weight * n.z * d;
+		a[9] += weight * d * d;
+	}
+
+	void Add(const Quadric& rhs) { for (unsigned i = 0; i < 10; ++i) a[i] += rhs.a[i]; }
+
+	double Evaluate(const glm::dvec3& p) const
+	{
+		return a[0] * p.x * p.x + 2.0 * a[1] * p.x * p.y + 2.0 * a[2] * p.x * p.z + 2.0 * a[3] * p.x
+			+ a[4] * p.y * p.y + 2.0 * a[5] * p.y * p.z + 2.0 * a[6] * p.y
+			+ a[7] * p.z * p.z + 2.0 * a[8] * p.z
+			+ a[9];
+	}
+};
+
+// Moving vertex from onto vertex to; versions catch candidates made stale by
+// a later collapse next to either end
+struct LodCollapse
+{
+	double cost;
+	unsigned from;
+	unsigned to;
+	unsigned fromVersion;
+	unsigned toVersion;
+
+	bool operator<(const LodCollapse& rhs) const { return cost > rhs.cost; } // cheapest on top
+};
+
+struct LodTriangle
+{
+	unsigned v[3];		// welded vertices of the run
+	unsigned corner[3];	// vertex buffer entries the corners are drawn with
+	bool removed;
+};
+
+// Copy of a welded position whose colour, normal and UV are closest to corner's,
+// so a collapsed corner keeps the attributes of its side of a seam
+static unsigned NearestCopy(const std::vector<Vertex>& vertices, const std::vector<unsigned>& copies, unsigned corner)
+{
+	const Vertex& original = vertices[corner];
+	unsigned best = copies[0];
+	float bestDistance = FLT_MAX;
+	for (unsigned copy : copies)
+	{
+		const Vertex& v = vertices[copy];
+		glm::vec2 uv = v.texCoord - original.texCoord;
+		glm::vec3 normal = v.normal - original.normal;
+		glm::vec3 color = v.color - original.color;
+		float distance = glm::dot(uv, uv) + glm::dot(normal, normal) + glm::dot(color, color);
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			best = copy;
+		}
+	}
+	return best;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Decimate one material run by quadric edge collapse. Vertices are welded by
+position first, so UV and normal seams do not tear, and every collapse moves
+one end onto the other, so the levels reuse the existing vertex buffer.
+
+\param vertices - vertex buffer of the mesh
+\param weld - welded id of every vertex
+\param copies - vertices of every welded id
+\param indices - triangles of the run
+\param count - number of indices
+\param out_levels - indices of each level, LOD_LEVELS of them
+\param out_errors - largest collapse error of each level, as a distance
+*/
+/******************************************************************************/
+static void SimplifyRun(const std::vector<Vertex>& vertices,
+	const std::vector<unsigned>& weld,
+	const std::vector<std::vector<unsigned> >& copies,
+	const unsigned* indices, unsigned count,
+	std::vector<std::vector<unsigned> >& out_levels,
+	std::vector<float>& out_errors)
+{
+	out_levels.assign(LOD_LEVELS, std::vector<unsigned>());
+	out_errors.assign(LOD_LEVELS, 0.f);
+
+	// Run-local vertices, one per welded position the run touches
+	std::map<unsigned, unsigned> local;
+	std::vector<unsigned> welded;
+	std::vector<LodTriangle> triangles;
+	for (unsigned i = 0; i + 2 < count; i += 3)
+	{
+		LodTriangle triangle;
+		triangle.removed = false;
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			triangle.corner[k] = indices[i + k];
+			unsigned id = weld[indices[i + k]];
+			std::map<unsigned, unsigned>::iterator it = local.find(id);
+			if (it == local.end())
+			{
+				it = local.insert(std::make_pair(id, static_cast<unsigned>(welded.size()))).first;
+				welded.push_back(id);
+			}
+			triangle.v[k] = it->second;
+		}
+		// Zero area once welded, like the seam and pole triangles of a sphere
+		if (triangle.v[0] == triangle.v[1] || triangle.v[1] == triangle.v[2] || triangle.v[0] == triangle.v[2])
+			continue;
+		triangles.push_back(triangle);
+	}
+
+	unsigned vertexCount = static_cast<unsigned>(welded.size());
+	std::vector<glm::dvec3> positions(vertexCount);
+	for (unsigned i = 0; i < vertexCount; ++i)
+		positions[i] = glm::dvec3(vertices[copies[welded[i]][0]].pos);
+
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<std::vector<unsigned> > adjacent(vertexCount);
+	std::map<std::pair<unsigned, unsigned>, unsigned> edgeUse;
+	std::vector<glm::dvec3> faceNormals(triangles.size());
+	for (unsigned t = 0; t < triangles.size(); ++t)
+	{
+		const unsigned* v = triangles[t].v;
+		glm::dvec3 normal = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+		double length = glm::length(normal);
+		if (length > 0.0)
+			normal /= length;
+		faceNormals[t] = normal;
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			if (length > 0.0)
+				quadrics[v[k]].AddPlane(normal, -glm::dot(normal, positions[v[0]]), 1.0);
+			adjacent[v[k]].push_back(t);
+			unsigned a = v[k], b = v[(k + 1) % 3];
+			++edgeUse[std::make_pair(std::min(a, b), std::max(a, b))];
+		}
+	}
+
+	// Open edges get a plane through them, perpendicular to their face
+	for (unsigned t = 0; t < triangles.size(); ++t)
+	{
+		const unsigned* v = triangles[t].v;
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			unsigned a = v[k], b = v[(k + 1) % 3];
+			if (edgeUse[std::make_pair(std::min(a, b), std::max(a, b))] != 1)
+				continue;
+			glm::dvec3 normal = glm::cross(positions[b] - positions[a], faceNormals[t]);
+			double length = glm::length(normal);
+			if (length == 0.0)
+				continue;
+			normal /= length;
+			double d = -glm::dot(normal, positions[a]);
+			quadrics[a].AddPlane(normal, d, LOD_BORDER_WEIGHT);
+			quadrics[b].AddPlane(normal, d, LOD_BORDER_WEIGHT);
+		}
+	}
+
+	std::vector<unsigned> version(vertexCount, 0);
+	std::vector<bool> collapsed(vertexCount, false);
+	std::priority_queue<LodCollapse> candidates;
+	auto push = [&](unsigned from, unsigned to) {
+		Quadric merged = quadrics[from];
+		merged.Add(quadrics[to]);
+		LodCollapse collapse = { std::max(merged.Evaluate(positions[to]), 0.0), from, to, version[from], version[to] };
+		candidates.push(collapse);
+	};
+	for (const auto& edge : edgeUse)
+	{
+		push(edge.first.first, edge.first.second);
+		push(edge.first.second, edge.first.first);
+	}
+
+	// Vertices sharing a live triangle with v, sorted
+	std::vector<unsigned> ringFrom, ringTo, common;
+	auto ring = [&](unsigned v, std::vector<unsigned>& out) {
+		out.clear();
+		for (unsigned t : adjacent[v])
+		{
+			if (triangles[t].removed)
+				continue;
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				if (triangles[t].v[k] != v)
+					out.push_back(triangles[t].v[k]);
+			}
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	};
+
+	unsigned live = static_cast<unsigned>(triangles.size());
+	double maxCost = 0.0;
+	unsigned level = 0;
+	while (level < LOD_LEVELS)
+	{
+		if (live <= triangles.size() * LOD_RATIOS[level] || candidates.empty())
+		{
+			for (const LodTriangle& triangle : triangles)
+			{
+				if (!triangle.removed)
+					out_levels[level].insert(out_levels[level].end(), triangle.corner, triangle.corner + 3);
+			}
+			out_errors[level] = static_cast<float>(std::sqrt(maxCost));
+			++level;
+			continue;
+		}
+
+		LodCollapse collapse = candidates.top();
+		candidates.pop();
+		unsigned from = collapse.from, to = collapse.to;
+		if (collapsed[from] || collapsed[to] || version[from] != collapse.fromVersion || version[to] != collapse.toVersion)
+			continue;
+
+		// Only collapse a live edge, and only if the two rings meet at the
+		// triangles on it; more common neighbours would fold the surface
+		unsigned shared = 0;
+		for (unsigned t : adjacent[from])
+		{
+			const LodTriangle& triangle = triangles[t];
+			if (!triangle.removed && (triangle.v[0] == to || triangle.v[1] == to || triangle.v[2] == to))
+				++shared;
+		}
+		if (shared == 0)
+			continue;
+		ring(from, ringFrom);
+		ring(to, ringTo);
+		common.clear();
+		std::set_intersection(ringFrom.begin(), ringFrom.end(), ringTo.begin(), ringTo.end(), std::back_inserter(common));
+		if (common.size() > shared)
+			continue;
+
+		// Reject collapses that would turn a remaining triangle over
+		bool flips = false;
+		for (unsigned t : adjacent[from])
+		{
+			const LodTriangle& triangle = triangles[t];
+			if (triangle.removed || triangle.v[0] == to || triangle.v[1] == to || triangle.v[2] == to)
+				continue;
+			glm::dvec3 p[3];
+			for (unsigned k = 0; k < 3; ++k)
+				p[k] = positions[triangle.v[k] == from ? to : triangle.v[k]];
+			glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+			double length = glm::length(after);
+			if (length == 0.0 || glm::dot(after / length, faceNormals[t]) < 0.2)
+			{
+				flips = true;
+				break;
+			}
+		}
+		if (flips)
+			continue;
+
+		for (unsigned t : adjacent[from])
+		{
+			LodTriangle& triangle = triangles[t];
+			if (triangle.removed)
+				continue;
+			if (triangle.v[0] == to || triangle.v[1] == to || triangle.v[2] == to)
+			{
+				triangle.removed = true;
+				--live;
+				continue;
+			}
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				if (triangle.v[k] == from)
+				{
+					triangle.v[k] = to;
+					triangle.corner[k] = NearestCopy(vertices, copies[welded[to]], triangle.corner[k]);
+				}
+			}
+			adjacent[to].push_back(t);
+		}
+		adjacent[from].clear();
+		adjacent[to].erase(std::remove_if(adjacent[to].begin(), adjacent[to].end(),
+			[&](unsigned t) { return triangles[t].removed; }), adjacent[to].end());
+
+		quadrics[to].Add(quadrics[from]);
+		collapsed[from] = true;
+		++version[to];
+		maxCost = std::max(maxCost, collapse.cost);
+
+		ring(to, ringTo);
+		for (unsigned neighbour : ringTo)
+		{
+			push(to, neighbour);
+			push(neighbour, to);
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Build the levels of a BuildSphere mesh by keeping every 2nd, 4th and 8th row
+and column of its vertex grid, so each keeps about 1/4 of the triangles of
+the one before. The grid is already known, so this costs no more than
+building the sphere, unlike the quadric decimation of GenerateLods.
+
+\param radius - radius the sphere was built with
+\param numSlice - columns of the grid
+\param numStack - rows of the grid
+\param out_indices - index buffer the levels are appended to, as triangle lists
+\param out_lods - levels, finest first; left empty for small spheres
+*/
+/******************************************************************************/
+void MeshBuilder::GenerateSphereLods(float radius, unsigned numSlice, unsigned numStack,
+	std::vector<unsigned>& out_indices,
+	std::vector<MeshLod>& out_lods)
+{
+	out_lods.clear();
+	if (numSlice * numStack * 2 < LOD_MIN_TRIANGLES)
+		return;
+
+	// Kept rows or columns of count + 1, always including both ends
+	auto keep = [](unsigned count, unsigned step) {
+		std::vector<unsigned> kept;
+		for (unsigned i = 0; i < count; i += step)
+			kept.push_back(i);
+		kept.push_back(count);
+		return kept;
+	};
+
+	for (unsigned level = 0, step = 2; level < LOD_LEVELS; ++level, step *= 2)
+	{
+		std::vector<unsigned> slices = keep(numSlice, step);
+		std::vector<unsigned> stacks = keep(numStack, step);
+		if (slices.size() < 4 || stacks.size() < 3)
+			break;
+
+		MeshLod lod;
+		lod.offset = static_cast<unsigned>(out_indices.size());
+		for (unsigned i = 0; i + 1 < stacks.size(); ++i)
+		{
+			for (unsigned j = 0; j + 1 < slices.size(); ++j)
+			{
+				// Same winding as the strip: (a,c) (b,c) (a,d), then (a,d) (b,c) (b,d)
+				unsigned ac = stacks[i] * (numSlice + 1) + slices[j];
+				unsigned bc = stacks[i + 1] * (numSlice + 1) + slices[j];
+				unsigned ad = stacks[i] * (numSlice + 1) + slices[j + 1];
+				unsigned bd = stacks[i + 1] * (numSlice + 1) + slices[j + 1];
+				unsigned quad[] = { ac, bc, ad, ad, bc, bd };
+				out_indices.insert(out_indices.end(), quad, quad + 6);
+			}
+		}
+		lod.count = static_cast<unsigned>(out_indices.size()) - lod.offset;
+
+		// A cell spanning angles a and b sags at most radius * (1 - cos(a / 2) cos(b / 2))
+		float slice = glm::two_pi<float>() / numSlice * step;
+		float stack = glm::pi<float>() / numStack * step;
+		lod.error = std::fabs(radius) * (1.f - std::cos(glm::min(slice, glm::pi<float>()) * 0.5f) * std::cos(glm::min(stack, glm::pi<float>()) * 0.5f));
+		out_lods.push_back(lod);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Build up to three decimated levels of a mesh, keeping about 1/2, 1/4 and 1/8
+of its triangles. Each material range is simplified on its own, so levels
+keep the material table and ranges never bleed into each other. The levels
+are appended to out_indices after the full mesh, and their offsets point
+into it; triangles may be out_indices itself.
+
+\param vertices - vertex buffer of the mesh
+\param triangles - full-detail indices, a triangle list
+\param ranges - material ranges of triangles, may be empty
+\param out_indices - index buffer the levels are appended to
+\param out_lods - levels, finest first; left empty for small meshes
+*/
+/******************************************************************************/
+void MeshBuilder::GenerateLods(const std::vector<Vertex>& vertices,
+	const std::vector<unsigned>& triangles,
+	const std::vector<MaterialRange>& ranges,
+	std::vector<unsigned>& out_indices,
+	std::vector<MeshLod>& out_lods)
+{
+	out_lods.clear();
+	unsigned indexCount = static_cast<unsigned>(triangles.size());
+	if (vertices.empty() || indexCount / 3 < LOD_MIN_TRIANGLES)
+		return;
+
+	// Weld vertices that share a position, whatever their other attributes
+	std::vector<unsigned> order(vertices.size());
+	for (unsigned i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+		const glm::vec3& p = vertices[a].pos;
+		const glm::vec3& q = vertices[b].pos;
+		if (p.x != q.x) return p.x < q.x;
+		if (p.y != q.y) return p.y < q.y;
+		return p.z < q.z;
+	});
+	std::vector<unsigned> weld(vertices.size());
+	std::vector<std::vector<unsigned> > copies;
+	for (unsigned i = 0; i < order.size(); ++i)
+	{
+		if (i == 0 || vertices[order[i]].pos != vertices[order[i - 1]].pos)
+			copies.push_back(std::vector<unsigned>());
+		weld[order[i]] = static_cast<unsigned>(copies.size() - 1);
+		copies.back().push_back(order[i]);
+	}
+
+	std::vector<MaterialRange> runs = ranges;
+	if (runs.empty())
+	{
+		MaterialRange whole = { 0, 0, indexCount };
+		runs.push_back(whole);
+	}
+
+	std::vector<std::vector<std::vector<unsigned> > > levels(runs.size());
+	std::vector<std::vector<float> > errors(runs.size());
+	for (unsigned r = 0; r < runs.size(); ++r)
+	{
+		if (runs[r].offset + runs[r].count > indexCount)
+			return;
+		SimplifyRun(vertices, weld, copies, &triangles[0] + runs[r].offset, runs[r].count, levels[r], errors[r]);
+	}
+
+	unsigned previous = indexCount;
+	for (unsigned level = 0; level < LOD_LEVELS; ++level)
+	{
+		unsigned total = 0;
+		float error = 0.f;
+		for (unsigned r = 0; r < runs.size(); ++r)
+		{
+			total += static_cast<unsigned>(levels[r][level].size());
+			error = std::max(error, errors[r][level]);
+		}
+		if (total == 0 || total > previous * (1.f - LOD_MIN_REDUCTION))
+			break;
+
+		MeshLod lod;
+		lod.error = error;
+		lod.offset = static_cast<unsigned>(out_indices.size());
+		for (unsigned r = 0; r < runs.size(); ++r)
+		{
+			MaterialRange range = runs[r];
+			range.offset = static_cast<unsigned>(out_indices.size());
+			range.count = static_cast<unsigned>(levels[r][level].size());
+			out_indices.insert(out_indices.end(), levels[r][level].begin(), levels[r][level].end());
+			if (!ranges.empty())
+				lod.ranges.push_back(range);
+		}
+		lod.count = static_cast<unsigned>(out_indices.size()) - lod.offset;
+		out_lods.push_back(lod);
+		previous = total;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Build one sphere at the old fixed 360x360 default, then meshes spheres at
+the adaptive default, first built one each and then shared through the
+cache. Reports indices and build time; needs a current GL context.
+
+\param meshes - number of spheres a scene asks for
+*/
+/******************************************************************************/
+void RunPrimitiveCacheBenchmark(unsigned meshes)
+{
+	const glm::vec3 color(0.8f, 0.3f, 0.3f);
+	StopWatch timer;
+
+	timer.startTimer();
+	Mesh* fixed = MeshBuilder::BuildSphere("Sphere", color, 1.f, 360, 360);
+	glFinish();
+	std::cout << "360x360 sphere: " << fixed->indexSize << " indices, "
+		<< timer.getElapsedTime() * 1000.0 << " ms\n";
+	delete fixed;
+
+	std::vector<Mesh*> spheres;
+	int slices = MeshBuilder::AdaptiveSegments(1.f);
+	timer.startTimer();
+	for (unsigned i = 0; i < meshes; ++i)
+		spheres.push_back(MeshBuilder::BuildSphere("Sphere", color, 1.f, slices, slices / 2));
+	glFinish();
+	std::cout << meshes << " adaptive spheres, built each: " << spheres[0]->indexSize << " indices, "
+		<< timer.getElapsedTime() * 1000.0 << " ms\n";
+	for (Mesh* sphere : spheres)
+		delete sphere;
+	spheres.clear();
+
+	AssetCache::GetInstance()->ResetStats();
+	timer.startTimer();
+	for (unsigned i = 0; i < meshes; ++i)
+		spheres.push_back(MeshBuilder::GenerateSphere("Sphere", glm::vec3(float(i % 2), 0.5f, float(1 - i % 2))));
+	glFinish();
+	std::cout << meshes << " adaptive spheres, cached: " << AssetCache::GetInstance()->GetMissCount() << " built, "
+		<< AssetCache::GetInstance()->GetHitCount() << " shared, "
+		<< timer.getElapsedTime() * 1000.0 << " ms\n";
+	for (Mesh* sphere : spheres)
+		delete sphere;
+}
@@ -3,11 +3,17 @@
 
 #include "Mesh.h"
 #include "Vertex.h"
+#include <functional>
 
 /******************************************************************************/
 /*!
 		Class MeshBuilder:
 \brief	Provides methods to generate mesh of different shapes
+
+		Spheres, tori, cylinders and hemispheres come from AssetCache: one
+		white mesh is built per shape and tessellation and every caller
+		gets its own Mesh drawing it in their colour. A segment count of 0
+		picks one from the size with AdaptiveSegments.
 */
 /******************************************************************************/
 class MeshBuilder
@@ -19,19 +25,19 @@ public:
 	static Mesh* GenerateSphere(const std::string& meshName,
 		glm::vec3 color,
 		float radius = 1.f,
-		int numSlice = 360,
-		int numStack = 360);
+		int numSlice = 0,
+		int numStack = 0);
 
 	static Mesh* GenerateTorus(const std::string& meshName,
 		glm::vec3 color,
 		float innerR = 1.f,
 		float outerR = 1.f,
-		int numSlice = 360,
-		int numStack = 360);
+		int numSlice = 0,
+		int numStack = 0);
 
 	static Mesh* GenerateCylinder(const std::string& meshName,
 		glm::vec3 color,
-		unsigned numSlice = 360,
+		unsigned numSlice = 0,
 		float radius = 1.f,
 		float height = 2.f);
 
@@ -50,8 +56,38 @@ public:
 
 	static Mesh* GenerateOBJ(const std::string& meshName, const std::string& file_path);
 	static Mesh* GenerateOBJMTL(const std::string& meshName, const std::string& file_path, const std::string& mtl_path);
+	static Mesh* GenerateOBJMTLAsync(const std::string& meshName, const std::string& file_path, const std::string& mtl_path);
 
 	static Mesh* GenerateText(const std::string& meshName, unsigned numRow, unsigned numCol);
+
+	// Decimated levels of an indexed triangle list, appended to out_indices.
+	// CPU only, so loaders can run it on a worker thread or when cooking
+	static void GenerateLods(const std::vector<Vertex>& vertices,
+		const std::vector<unsigned>& triangles,
+		const std::vector<MaterialRange>& ranges,
+		std::vector<unsigned>& out_indices,
+		std::vector<MeshLod>& out_lods);
+
+	// Segments a circle of this radius needs to stay within PRIMITIVE_TOLERANCE of it
+	static unsigned AdaptiveSegments(float radius);
+
+	// Uncached builders behind the Generate functions above; every call makes new buffers
+	static Mesh* BuildSphere(const std::string& meshName, glm::vec3 color, float radius, int numSlice, int numStack);
+	static Mesh* BuildTorus(const std::string& meshName, glm::vec3 color, float innerR, float outerR, int numSlice, int numStack);
+	static Mesh* BuildCylinder(const std::string& meshName, glm::vec3 color, unsigned numSlice, float radius, float height);
+	static Mesh* BuildHemisphere(const std::string& meshName, glm::vec3 color, unsigned numStack, unsigned numSlice, float radius);
+
+private:
+	// A Mesh drawing the cached primitive key in color, building it on a miss
+	static Mesh* SharePrimitive(const std::string& meshName, const std::string& key, glm::vec3 color, const std::function<Mesh*()>& build);
+	// Coarser levels of a BuildSphere vertex grid that skip its rows and columns
+	static void GenerateSphereLods(float radius, unsigned numSlice, unsigned numStack,
+		std::vector<unsigned>& out_indices,
+		std::vector<MeshLod>& out_lods);
 };
 
+// Time building spheres at the old fixed tessellation, the adaptive one and
+// through the primitive cache
+void RunPrimitiveCacheBenchmark(unsigned meshes);
+
 #endif
\ No newline at end of file
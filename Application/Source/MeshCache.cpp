@@ -0,0 +1,420 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include "MeshCache.h"
+#include "LoadOBJ.h"
+#include "MeshBuilder.h"
+#include "timer.h"
+
+// Bump whenever Vertex, the header or the material record changes
+static const unsigned COOKED_MESH_VERSION = 3;
+static const char COOKED_MESH_MAGIC[4] = { 'M', 'E', 'S', 'H' };
+
+// File layout: header, materials, material ranges, levels, level ranges,
+// vertices, indices (the full mesh's, then each level's)
+struct CookedMeshHeader
+{
+	char magic[4];
+	unsigned version;
+	unsigned long long objWriteTime;
+	unsigned long long mtlWriteTime;
+	unsigned vertexSize;
+	unsigned vertexCount;
+	unsigned indexCount;
+	unsigned materialCount;
+	unsigned rangeCount;
+	unsigned lodCount;
+};
+
+struct CookedLod
+{
+	float error;
+	unsigned offset;
+	unsigned count;
+};
+
+struct CookedMaterial
+{
+	float kAmbient[3];
+	float kDiffuse[3];
+	float kSpecular[3];
+	float kShininess;
+	float dissolve;
+	unsigned illum;
+	char texturePath[260];	// MAX_PATH, null-terminated
+};
+
+CookedMesh::CookedMesh()
+	: vertices(nullptr)
+	, indices(nullptr)
+	, materials(nullptr)
+	, ranges(nullptr)
+	, lods(nullptr)
+	, lodRanges(nullptr)
+	, vertexCount(0)
+	, indexCount(0)
+	, materialCount(0)
+	, rangeCount(0)
+	, lodCount(0)
+{
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map a cooked mesh and check it is still valid for its sources. Fails if the
+file is missing, truncated, from another format version, or if the .obj/.mtl
+have been modified since it was cooked.
+
+\param mesh_path - cooked .mesh file
+\param obj_path - source OBJ the mesh was cooked from
+\param mtl_path - source MTL the mesh was cooked from (may be nullptr)
+
+\return true if the cooked data can be used
+*/
+/******************************************************************************/
+bool CookedMesh::Open(const char* mesh_path, const char* obj_path, const char* mtl_path)
+{
+	Close();
+	if (!file.Open(mesh_path) || file.Size() < sizeof(CookedMeshHeader))
+	{
+		Close();
+		return false;
+	}
+
+	CookedMeshHeader header;
+	memcpy(&header, file.Data(), sizeof(header));
+	if (memcmp(header.magic, COOKED_MESH_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != COOKED_MESH_VERSION ||
+		header.vertexSize != sizeof(Vertex) ||
+		header.objWriteTime != GetFileWriteTime(obj_path) ||
+		header.mtlWriteTime != GetFileWriteTime(mtl_path))
+	{
+		Close();
+		return false;
+	}
+
+	size_t materialBytes = static_cast<size_t>(header.materialCount) * sizeof(CookedMaterial);
+	size_t rangeBytes = static_cast<size_t>(header.rangeCount) * sizeof(MaterialRange);
+	size_t lodBytes = static_cast<size_t>(header.lodCount) * sizeof(CookedLod);
+	size_t lodRangeBytes = static_cast<size_t>(header.lodCount) * rangeBytes;
+	size_t vertexBytes = static_cast<size_t>(header.vertexCount) * sizeof(Vertex);
+	size_t indexBytes = static_cast<size_t>(header.indexCount) * sizeof(unsigned);
+	if (file.Size() != sizeof(CookedMeshHeader) + materialBytes + rangeBytes + lodBytes + lodRangeBytes + vertexBytes + indexBytes)
+	{
+		Close();
+		return false;
+	}
+
+	materials = file.Data() + sizeof(CookedMeshHeader);
+	ranges = reinterpret_cast<const MaterialRange*>(materials + materialBytes);
+	lods = materials + materialBytes + rangeBytes;
+	lodRanges = reinterpret_cast<const MaterialRange*>(lods + lodBytes);
+	vertices = reinterpret_cast<const Vertex*>(lods + lodBytes + lodRangeBytes);
+	indices = reinterpret_cast<const unsigned*>(lods + lodBytes + lodRangeBytes + vertexBytes);
+	vertexCount = header.vertexCount;
+	indexCount = header.indexCount;
+	materialCount = header.materialCount;
+	rangeCount = header.rangeCount;
+	lodCount = header.lodCount;
+	return true;
+}
+
+void CookedMesh::Close()
+{
+	file.Close();
+	vertices = nullptr;
+	indices = nullptr;
+	materials = nullptr;
+	ranges = nullptr;
+	lods = nullptr;
+	lodRanges = nullptr;
+	vertexCount = indexCount = materialCount = rangeCount = lodCount = 0;
+}
+
+void CookedMesh::GetMaterials(std::vector<Material>& out_materials) const
+{
+	for (unsigned i = 0; i < materialCount; ++i)
+	{
+		CookedMaterial cooked;
+		memcpy(&cooked, materials + i * sizeof(CookedMaterial), sizeof(cooked));
+
+		Material material;
+		material.kAmbient = glm::vec3(cooked.kAmbient[0], cooked.kAmbient[1], cooked.kAmbient[2]);
+		material.kDiffuse = glm::vec3(cooked.kDiffuse[0], cooked.kDiffuse[1], cooked.kDiffuse[2]);
+		material.kSpecular = glm::vec3(cooked.kSpecular[0], cooked.kSpecular[1], cooked.kSpecular[2]);
+		material.kShininess = cooked.kShininess;
+		material.dissolve = cooked.dissolve;
+		material.illum = cooked.illum;
+		cooked.texturePath[sizeof(cooked.texturePath) - 1] = '\0';
+		material.texturePath = cooked.texturePath;
+		out_materials.push_back(material);
+	}
+}
+
+void CookedMesh::GetMaterialRanges(std::vector<MaterialRange>& out_ranges) const
+{
+	out_ranges.insert(out_ranges.end(), ranges, ranges + rangeCount);
+}
+
+void CookedMesh::GetLods(std::vector<MeshLod>& out_lods) const
+{
+	for (unsigned i = 0; i < lodCount; ++i)
+	{
+		CookedLod cooked;
+		memcpy(&cooked, lods + i * sizeof(CookedLod), sizeof(cooked));
+
+		MeshLod lod;
+		lod.error = cooked.error;
+		lod.offset = cooked.offset;
+		lod.count = cooked.count;
+		lod.ranges.assign(lodRanges + i * rangeCount, lodRanges + (i + 1) * rangeCount);
+		out_lods.push_back(lod);
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Cooked mesh file for an OBJ: same directory and name, .mesh extension
+
+\param obj_path - path of the source OBJ
+*/
+/******************************************************************************/
+std::string GetCookedMeshPath(const std::string& obj_path)
+{
+	size_t dot = obj_path.find_last_of('.');
+	size_t slash = obj_path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return obj_path + ".mesh";
+	return obj_path.substr(0, dot) + ".mesh";
+}
+
+/******************************************************************************/
+/*!
+\brief
+Write already indexed mesh data to a cooked .mesh file, stamped with the
+current write times of its sources. The data goes to a temporary file first
+that then replaces the .mesh, so streaming jobs cooking the same OBJ at once
+never read or leave a partly written file.
+
+\return true if the whole file was written
+*/
+/******************************************************************************/
+bool WriteCookedMesh(
+	const char* mesh_path,
+	const char* obj_path,
+	const char* mtl_path,
+	const std::vector<Vertex>& vertices,
+	const std::vector<unsigned>& indices,
+	const std::vector<Material>& materials,
+	const std::vector<MaterialRange>& ranges,
+	const std::vector<MeshLod>& lods
+)
+{
+	// One temporary file per writing thread
+	std::string temp_path = std::string(mesh_path) + "." + std::to_string(GetCurrentThreadId()) + ".tmp";
+	std::ofstream fileStream(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+	{
+		std::cout << "Impossible to write " << temp_path << "\n";
+		return false;
+	}
+
+	CookedMeshHeader header;
+	memcpy(header.magic, COOKED_MESH_MAGIC, sizeof(header.magic));
+	header.version = COOKED_MESH_VERSION;
+	header.objWriteTime = GetFileWriteTime(obj_path);
+	header.mtlWriteTime = GetFileWriteTime(mtl_path);
+	header.vertexSize = sizeof(Vertex);
+	header.vertexCount = static_cast<unsigned>(vertices.size());
+	header.indexCount = static_cast<unsigned>(indices.size());
+	header.materialCount = static_cast<unsigned>(materials.size());
+	header.rangeCount = static_cast<unsigned>(ranges.size());
+	header.lodCount = static_cast<unsigned>(lods.size());
+	fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const Material& material : materials)
+	{
+		CookedMaterial cooked = {
+			{ material.kAmbient.r, material.kAmbient.g, material.kAmbient.b },
+			{ material.kDiffuse.r, material.kDiffuse.g, material.kDiffuse.b },
+			{ material.kSpecular.r, material.kSpecular.g, material.kSpecular.b },
+			material.kShininess,
+			material.dissolve,
+			material.illum
+		};
+		strncpy(cooked.texturePath, material.texturePath.c_str(), sizeof(cooked.texturePath) - 1);
+		fileStream.write(reinterpret_cast<const char*>(&cooked), sizeof(cooked));
+	}
+	if (!ranges.empty())
+		fileStream.write(reinterpret_cast<const char*>(&ranges[0]), ranges.size() * sizeof(MaterialRange));
+	for (const MeshLod& lod : lods)
+	{
+		CookedLod cooked = { lod.error, lod.offset, lod.count };
+		fileStream.write(reinterpret_cast<const char*>(&cooked), sizeof(cooked));
+	}
+	for (const MeshLod& lod : lods)
+	{
+		// Every level has one range per material range, or none when the mesh has none
+		if (!lod.ranges.empty())
+			fileStream.write(reinterpret_cast<const char*>(&lod.ranges[0]), lod.ranges.size() * sizeof(MaterialRange));
+	}
+	if (!vertices.empty())
+		fileStream.write(reinterpret_cast<const char*>(&vertices[0]), vertices.size() * sizeof(Vertex));
+	if (!indices.empty())
+		fileStream.write(reinterpret_cast<const char*>(&indices[0]), indices.size() * sizeof(unsigned));
+
+	bool written = fileStream.good();
+	fileStream.close();
+	if (!written)
+	{
+		remove(temp_path.c_str());
+		return false;
+	}
+	return ReplaceFileWith(mesh_path, temp_path.c_str());
+}
+
+/******************************************************************************/
+/*!
+\brief
+Get the indexed data of an OBJ/MTL pair on the CPU: from its cooked .mesh if
+that is up to date, otherwise by parsing the text files and re-cooking.
+Touches no GL state, so it can run on a worker thread.
+
+\return true if the mesh data was loaded
+*/
+/******************************************************************************/
+bool LoadMeshData(
+	const char* obj_path,
+	const char* mtl_path,
+	std::vector<Vertex>& out_vertices,
+	std::vector<unsigned>& out_indices,
+	std::vector<Material>& out_materials,
+	std::vector<MaterialRange>& out_ranges,
+	std::vector<MeshLod>& out_lods
+)
+{
+	std::string cache_path = GetCookedMeshPath(obj_path);
+	CookedMesh cooked;
+	if (cooked.Open(cache_path.c_str(), obj_path, mtl_path))
+	{
+		out_vertices.assign(cooked.Vertices(), cooked.Vertices() + cooked.VertexCount());
+		out_indices.assign(cooked.Indices(), cooked.Indices() + cooked.IndexCount());
+		cooked.GetMaterials(out_materials);
+		cooked.GetMaterialRanges(out_ranges);
+		cooked.GetLods(out_lods);
+		return true;
+	}
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	if (!LoadOBJMTL(obj_path, mtl_path, vertices, uvs, normals, out_materials, out_ranges))
+		return false;
+	IndexVBO(vertices, uvs, normals, out_indices, out_vertices);
+	MeshBuilder::GenerateLods(out_vertices, out_indices, out_ranges, out_indices, out_lods);
+
+	WriteCookedMesh(cache_path.c_str(), obj_path, mtl_path, out_vertices, out_indices, out_materials, out_ranges, out_lods);
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Parse, index and decimate an OBJ/MTL pair and write its cooked .mesh next to it
+
+\param obj_path - source OBJ
+\param mtl_path - source MTL (may be nullptr)
+
+\return true if the mesh was cooked
+*/
+/******************************************************************************/
+bool CookOBJMTL(const char* obj_path, const char* mtl_path)
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<Material> materials;
+	std::vector<MaterialRange> ranges;
+	if (!LoadOBJMTL(obj_path, mtl_path, vertices, uvs, normals, materials, ranges))
+		return false;
+
+	std::vector<Vertex> vertex_buffer_data;
+	std::vector<unsigned> index_buffer_data;
+	IndexVBO(vertices, uvs, normals, index_buffer_data, vertex_buffer_data);
+	std::vector<MeshLod> lods;
+	MeshBuilder::GenerateLods(vertex_buffer_data, index_buffer_data, ranges, index_buffer_data, lods);
+
+	return WriteCookedMesh(GetCookedMeshPath(obj_path).c_str(), obj_path, mtl_path,
+		vertex_buffer_data, index_buffer_data, materials, ranges, lods);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Offline cooker, run as "Application.exe -cook [-threads N] a.obj b.obj ...".
+Each OBJ is cooked with the .mtl of the same name if there is one. Also
+reports, per model, the cold OBJ parse + index time against the cooked load
+time; rerun with different -threads values to compare parser scaling.
+
+\return process exit code, non-zero if any model failed to cook
+*/
+/******************************************************************************/
+int RunMeshCooker(int argc, char* argv[])
+{
+	int failures = 0;
+	StopWatch timer;
+	for (int i = 0; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			SetOBJParseThreads(static_cast<unsigned>(atoi(argv[++i])));
+			continue;
+		}
+
+		std::string obj_path = argv[i];
+		std::string mtl_path = obj_path.substr(0, obj_path.find_last_of('.')) + ".mtl";
+		if (GetFileWriteTime(mtl_path.c_str()) == 0)
+			mtl_path.clear();
+		const char* mtl = mtl_path.empty() ? nullptr : mtl_path.c_str();
+
+		timer.startTimer();
+		if (!CookOBJMTL(obj_path.c_str(), mtl))
+		{
+			std::cout << "Failed to cook " << obj_path << "\n";
+			++failures;
+			continue;
+		}
+		double cookTime = timer.getElapsedTime();
+
+		// Cooked load: map the file and read every byte, as glBufferData would
+		CookedMesh cooked;
+		if (!cooked.Open(GetCookedMeshPath(obj_path).c_str(), obj_path.c_str(), mtl))
+		{
+			std::cout << "Failed to reload cooked " << obj_path << "\n";
+			++failures;
+			continue;
+		}
+		std::vector<Vertex> vertexCopy(cooked.Vertices(), cooked.Vertices() + cooked.VertexCount());
+		std::vector<unsigned> indexCopy(cooked.Indices(), cooked.Indices() + cooked.IndexCount());
+		std::vector<Material> materials;
+		cooked.GetMaterials(materials);
+		std::vector<MeshLod> lods;
+		cooked.GetLods(lods);
+		double loadTime = timer.getElapsedTime();
+
+		std::cout << obj_path << ": " << cooked.VertexCount() << " vertices, " << cooked.IndexCount() << " indices, "
+			<< "OBJ parse+index+LOD " << cookTime * 1000.0 << " ms, cooked load " << loadTime * 1000.0 << " ms\n";
+		unsigned fullCount = BaseIndexCount(lods, cooked.IndexCount());
+		for (unsigned level = 0; level < lods.size(); ++level)
+		{
+			std::cout << "  LOD " << level + 1 << ": " << lods[level].count / 3 << " of " << fullCount / 3
+				<< " triangles, error " << lods[level].error << "\n";
+		}
+	}
+	return failures;
+}
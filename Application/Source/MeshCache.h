@@ -0,0 +1,80 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <string>
+#include <vector>
+#include "Vertex.h"
+#include "Material.h"
+#include "MeshLod.h"
+#include "MappedFile.h"
+
+/******************************************************************************/
+/*!
+		Class CookedMesh:
+\brief	Read-only view of a cooked .mesh file: the indexed Vertex array,
+		32-bit indices, material table, material ranges and decimated
+		levels produced from an OBJ/MTL pair. The levels' indices follow
+		the full mesh's in Indices().
+		The file is memory-mapped, so Vertices()/Indices() can be handed to
+		glBufferData directly.
+*/
+/******************************************************************************/
+class CookedMesh
+{
+public:
+	CookedMesh();
+
+	bool Open(const char* mesh_path, const char* obj_path, const char* mtl_path);
+	void Close();
+
+	const Vertex* Vertices() const { return vertices; }
+	unsigned VertexCount() const { return vertexCount; }
+	const unsigned* Indices() const { return indices; }
+	unsigned IndexCount() const { return indexCount; }
+	void GetMaterials(std::vector<Material>& out_materials) const;
+	void GetMaterialRanges(std::vector<MaterialRange>& out_ranges) const;
+	void GetLods(std::vector<MeshLod>& out_lods) const;
+
+private:
+	MappedFile file;
+	const Vertex* vertices;
+	const unsigned* indices;
+	const char* materials;
+	const MaterialRange* ranges;
+	const char* lods;
+	const MaterialRange* lodRanges;	// rangeCount per level
+	unsigned vertexCount;
+	unsigned indexCount;
+	unsigned materialCount;
+	unsigned rangeCount;
+	unsigned lodCount;
+};
+
+std::string GetCookedMeshPath(const std::string& obj_path);
+
+bool WriteCookedMesh(
+	const char* mesh_path,
+	const char* obj_path,
+	const char* mtl_path,
+	const std::vector<Vertex>& vertices,
+	const std::vector<unsigned>& indices,
+	const std::vector<Material>& materials,
+	const std::vector<MaterialRange>& ranges,
+	const std::vector<MeshLod>& lods
+);
+
+bool LoadMeshData(
+	const char* obj_path,
+	const char* mtl_path,
+	std::vector<Vertex>& out_vertices,
+	std::vector<unsigned>& out_indices,
+	std::vector<Material>& out_materials,
+	std::vector<MaterialRange>& out_ranges,
+	std::vector<MeshLod>& out_lods
+);
+
+bool CookOBJMTL(const char* obj_path, const char* mtl_path);
+
+int RunMeshCooker(int argc, char* argv[]);
+
+#endif
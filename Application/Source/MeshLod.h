@@ -0,0 +1,36 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <vector>
+#include "Material.h"
+
+// Level index meaning "not drawn yet", so selection starts without hysteresis
+const unsigned LOD_NONE = ~0u;
+
+// A decimated copy of a mesh's triangles, stored after the full mesh in the
+// same index buffer. Always a triangle list, whatever the mesh's draw mode
+struct MeshLod
+{
+	float error;						// model-space distance the level may stray from the full mesh
+	unsigned offset;					// first index of the level
+	unsigned count;						// number of indices
+	std::vector<MaterialRange> ranges;	// one per entry of the mesh's materialRanges, empty if it has none
+};
+
+// Level one placement of a mesh was last drawn at, per view, so selection
+// can hold it inside the hysteresis band instead of popping every frame
+struct LodState
+{
+	static const unsigned MAX_VIEWS = 2;
+	unsigned level[MAX_VIEWS];
+
+	LodState() { for (unsigned& view : level) view = LOD_NONE; }
+};
+
+// Indices of the full mesh, at the front of a buffer that holds its levels after it
+inline unsigned BaseIndexCount(const std::vector<MeshLod>& lods, unsigned indexCount)
+{
+	return lods.empty() ? indexCount : lods[0].offset;
+}
+
+#endif
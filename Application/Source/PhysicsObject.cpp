@@ -1,13 +1,13 @@
 #include "PhysicsObject.h"
 
 PhysicsObject::PhysicsObject()
-    : sizeX{ 1.f }, sizeY{ 1.f }, sizeZ{ 1.f }, pos{}, prevPos{}, vel{}, accel{},
+    : sizeX{ 1.f }, sizeY{ 1.f }, sizeZ{ 1.f }, pos{}, prevPos{}, impactPos{}, impactAlpha{ 0.f }, vel{}, accel{},
 	mass{ 1.f }, m_totalForces{}, angularVel{}, orientation{}, bounciness{ 1.f }
 {
 }
 
 PhysicsObject::PhysicsObject(float sizeX, float sizeY, float sizeZ, glm::vec3 pos, float mass, float bounciness)
-    : sizeX{ 1.f }, sizeY{ 1.f }, sizeZ{ 1.f }, pos{}, prevPos{}, vel{}, accel{},
+    : sizeX{ 1.f }, sizeY{ 1.f }, sizeZ{ 1.f }, pos{}, prevPos{}, impactPos{}, impactAlpha{ 0.f }, vel{}, accel{},
 	mass{ 1.f }, m_totalForces{}, angularVel{}, orientation{}, bounciness{ 1.f }
 {
 	this->sizeX = sizeX;
@@ -15,6 +15,7 @@ PhysicsObject::PhysicsObject(float sizeX, float sizeY, float sizeZ, glm::vec3 po
 	this->sizeZ = sizeZ;
 
 	this->pos = pos;
+	this->prevPos = pos;
 
 	this->mass = mass;
     this->bounciness = bounciness;
@@ -34,8 +35,27 @@ void PhysicsObject::AddImpulse(const glm::vec3& impulse)
 	vel += impulse * (1.0f / mass);
 }
 
+float PhysicsObject::GetDampingFactor(float dt)
+{
+    const float damping = 0.98f;
+    return pow(damping, dt * 60.f);
+}
+
 void PhysicsObject::UpdatePhysics(float dt)
 {
+    UpdatePhysics(dt, GetDampingFactor(dt));
+}
+
+void PhysicsObject::BeginStep()
+{
+    prevPos = pos;
+    impactAlpha = 0.f;
+}
+
+void PhysicsObject::UpdatePhysics(float dt, float dampingFactor)
+{
+    BeginStep();
+
     if (mass == 0.f)
     {
         m_totalForces = glm::vec3(0.f);
@@ -47,8 +67,7 @@ void PhysicsObject::UpdatePhysics(float dt)
 
     vel += finalAccel * dt;
 
-    const float damping = 0.98f;
-    vel *= pow(damping, dt * 60.f);
+    vel *= dampingFactor;
 
     pos += vel * dt;
 
@@ -60,4 +79,17 @@ void PhysicsObject::UpdatePhysics(float dt)
     orientation = glm::normalize(orientation);
 
     m_totalForces = glm::vec3(0.f);
-}
\ No newline at end of file
+}
+
+glm::vec3 PhysicsObject::GetInterpolatedPos(float alpha) const
+{
+    // Straight from the step's start to its end, or through the impact so the
+    // drawn ball neither cuts across the obstacle nor jumps at the bounce
+    if (impactAlpha <= 0.f)
+        return prevPos + (pos - prevPos) * alpha;
+    if (alpha < impactAlpha)
+        return prevPos + (impactPos - prevPos) * (alpha / impactAlpha);
+    if (impactAlpha >= 1.f)
+        return impactPos;
+    return impactPos + (pos - impactPos) * ((alpha - impactAlpha) / (1.f - impactAlpha));
+}
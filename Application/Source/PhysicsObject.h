@@ -21,6 +21,10 @@ public:
 	//for linear movement
 	glm::vec3 pos;
 	glm::vec3 prevPos;
+	// Where a swept collision left the object during the last step, and how far
+	// through the step that was; impactAlpha is 0 when the step had no impact
+	glm::vec3 impactPos;
+	float impactAlpha;
 	glm::vec3 vel;
 	glm::vec3 accel;
 	float mass;
@@ -34,7 +38,16 @@ public:
 
 	void AddForce(const glm::vec3& force); //add a pushing force through the center of mass
 	void AddImpulse(const glm::vec3& impulse); //an impulse results in an immediate change in velocity
+	// Start a step from pos: sets prevPos and forgets the last step's impact. UpdatePhysics calls it
+	void BeginStep();
 	void UpdatePhysics(float dt);
+	// As above with GetDampingFactor(dt) worked out once by the caller for every object it steps
+	void UpdatePhysics(float dt, float dampingFactor);
+	// Velocity kept after a step of dt: 0.98 per 1/60 s
+	static float GetDampingFactor(float dt);
+	// Position to draw between the last two steps: prevPos at alpha 0, pos at 1,
+	// going through impactPos at impactAlpha when the step bounced
+	glm::vec3 GetInterpolatedPos(float alpha) const;
 
 	bool hitBoard = false;
 protected:
@@ -0,0 +1,383 @@
+#include "PhysicsWorld.h"
+#include "timer.h"
+#include <cmath>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+// Step() works on this many bodies at a time; /arch:AVX widens it to 8
+#if defined(__AVX__)
+#include <immintrin.h>
+typedef __m256 Lanes;
+static const unsigned LANES = 8;
+static inline Lanes SimdLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void SimdStore(float* p, Lanes a) { _mm256_storeu_ps(p, a); }
+static inline Lanes SimdSplat(float f) { return _mm256_set1_ps(f); }
+static inline Lanes SimdAdd(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+static inline Lanes SimdSub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+static inline Lanes SimdMul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes SimdDiv(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+static inline Lanes SimdSqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+static inline Lanes SimdGreater(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline Lanes SimdSelect(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+#else
+#include <emmintrin.h>
+typedef __m128 Lanes;
+static const unsigned LANES = 4;
+static inline Lanes SimdLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void SimdStore(float* p, Lanes a) { _mm_storeu_ps(p, a); }
+static inline Lanes SimdSplat(float f) { return _mm_set1_ps(f); }
+static inline Lanes SimdAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes SimdSub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+static inline Lanes SimdMul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes SimdDiv(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+static inline Lanes SimdSqrt(Lanes a) { return _mm_sqrt_ps(a); }
+static inline Lanes SimdGreater(Lanes a, Lanes b) { return _mm_cmpgt_ps(a, b); }
+static inline Lanes SimdSelect(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+const PhysicsWorld::Handle PhysicsWorld::INVALID_HANDLE;
+
+PhysicsWorld::PhysicsWorld()
+	: count(0)
+	, padded(0)
+{
+}
+
+// Grow the arrays to hold bodies, filling the new slots with static bodies at rest
+void PhysicsWorld::Reserve(unsigned bodies)
+{
+	unsigned size = (bodies + LANES - 1) / LANES * LANES;
+	if (size <= padded)
+		return;
+
+	for (int k = 0; k < 3; ++k)
+	{
+		pos[k].resize(size, 0.f);
+		vel[k].resize(size, 0.f);
+		force[k].resize(size, 0.f);
+		accel[k].resize(size, 0.f);
+		angularVel[k].resize(size, 0.f);
+	}
+	invMass.resize(size, 0.f);
+	orientation[0].resize(size, 1.f);
+	for (int k = 1; k < 4; ++k)
+		orientation[k].resize(size, 0.f);
+	padded = size;
+}
+
+PhysicsWorld::Handle PhysicsWorld::Add(const glm::vec3& position, float mass)
+{
+	unsigned index = count++;
+	Reserve(count);
+
+	Handle handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<Handle>(handleToIndex.size());
+		handleToIndex.push_back(INVALID_HANDLE);
+	}
+	handleToIndex[handle] = index;
+	indexToHandle.push_back(handle);
+
+	for (int k = 0; k < 3; ++k)
+		pos[k][index] = position[k];
+	SetMass(handle, mass);
+	return handle;
+}
+
+PhysicsWorld::Handle PhysicsWorld::Add(const PhysicsObject& obj)
+{
+	Handle handle = Add(obj.pos, obj.mass);
+	SetVelocity(handle, obj.vel);
+	SetAcceleration(handle, obj.accel);
+	SetOrientation(handle, obj.orientation);
+	SetAngularVelocity(handle, obj.angularVel);
+	return handle;
+}
+
+void PhysicsWorld::Remove(Handle handle)
+{
+	unsigned index = Index(handle);
+	unsigned last = --count;
+	if (index != last)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			pos[k][index] = pos[k][last];
+			vel[k][index] = vel[k][last];
+			force[k][index] = force[k][last];
+			accel[k][index] = accel[k][last];
+			angularVel[k][index] = angularVel[k][last];
+		}
+		for (int k = 0; k < 4; ++k)
+			orientation[k][index] = orientation[k][last];
+		invMass[index] = invMass[last];
+
+		Handle moved = indexToHandle[last];
+		indexToHandle[index] = moved;
+		handleToIndex[moved] = index;
+	}
+	indexToHandle.pop_back();
+	handleToIndex[handle] = INVALID_HANDLE;
+	freeHandles.push_back(handle);
+
+	// The freed slot becomes padding, which has to stay static
+	for (int k = 0; k < 3; ++k)
+	{
+		pos[k][last] = vel[k][last] = force[k][last] = 0.f;
+		accel[k][last] = angularVel[k][last] = 0.f;
+	}
+	orientation[0][last] = 1.f;
+	orientation[1][last] = orientation[2][last] = orientation[3][last] = 0.f;
+	invMass[last] = 0.f;
+}
+
+void PhysicsWorld::Clear()
+{
+	count = 0;
+	padded = 0;
+	for (int k = 0; k < 3; ++k)
+	{
+		pos[k].clear();
+		vel[k].clear();
+		force[k].clear();
+		accel[k].clear();
+		angularVel[k].clear();
+	}
+	for (int k = 0; k < 4; ++k)
+		orientation[k].clear();
+	invMass.clear();
+	handleToIndex.clear();
+	indexToHandle.clear();
+	freeHandles.clear();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Integrate every body over dt the way PhysicsObject::UpdatePhysics does:
+velocity from the constant acceleration plus force times inverse mass,
+damped, then position from the new velocity, and the orientation turned by
+the angular velocity and renormalised. Static bodies in a group are masked
+out of the stores, so padding needs no separate tail loop.
+
+\param dt - time step in seconds
+*/
+/******************************************************************************/
+void PhysicsWorld::Step(float dt)
+{
+	const Lanes zero = SimdSplat(0.f);
+	const Lanes one = SimdSplat(1.f);
+	const Lanes step = SimdSplat(dt);
+	const Lanes halfStep = SimdSplat(0.5f * dt);
+	const Lanes damping = SimdSplat(PhysicsObject::GetDampingFactor(dt));
+
+	for (unsigned i = 0; i < padded; i += LANES)
+	{
+		Lanes inverse = SimdLoad(&invMass[i]);
+		Lanes moving = SimdGreater(inverse, zero);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			Lanes v = SimdLoad(&vel[k][i]);
+			Lanes a = SimdAdd(SimdLoad(&accel[k][i]), SimdMul(SimdLoad(&force[k][i]), inverse));
+			Lanes newVel = SimdMul(SimdAdd(v, SimdMul(a, step)), damping);
+			Lanes p = SimdLoad(&pos[k][i]);
+			SimdStore(&vel[k][i], SimdSelect(moving, newVel, v));
+			SimdStore(&pos[k][i], SimdSelect(moving, SimdAdd(p, SimdMul(newVel, step)), p));
+			SimdStore(&force[k][i], zero);
+		}
+
+		// q += 0.5 * (0, w) * q * dt
+		Lanes qw = SimdLoad(&orientation[0][i]);
+		Lanes qx = SimdLoad(&orientation[1][i]);
+		Lanes qy = SimdLoad(&orientation[2][i]);
+		Lanes qz = SimdLoad(&orientation[3][i]);
+		Lanes wx = SimdLoad(&angularVel[0][i]);
+		Lanes wy = SimdLoad(&angularVel[1][i]);
+		Lanes wz = SimdLoad(&angularVel[2][i]);
+
+		Lanes nw = SimdSub(qw, SimdMul(SimdAdd(SimdAdd(SimdMul(wx, qx), SimdMul(wy, qy)), SimdMul(wz, qz)), halfStep));
+		Lanes nx = SimdAdd(qx, SimdMul(SimdAdd(SimdMul(wx, qw), SimdSub(SimdMul(wy, qz), SimdMul(wz, qy))), halfStep));
+		Lanes ny = SimdAdd(qy, SimdMul(SimdAdd(SimdMul(wy, qw), SimdSub(SimdMul(wz, qx), SimdMul(wx, qz))), halfStep));
+		Lanes nz = SimdAdd(qz, SimdMul(SimdAdd(SimdMul(wz, qw), SimdSub(SimdMul(wx, qy), SimdMul(wy, qx))), halfStep));
+
+		// A zero quaternion normalises to identity, as in glm::normalize
+		Lanes length = SimdSqrt(SimdAdd(SimdAdd(SimdMul(nw, nw), SimdMul(nx, nx)), SimdAdd(SimdMul(ny, ny), SimdMul(nz, nz))));
+		Lanes valid = SimdGreater(length, zero);
+		Lanes scale = SimdDiv(one, SimdSelect(valid, length, one));
+		nw = SimdSelect(valid, SimdMul(nw, scale), one);
+		nx = SimdSelect(valid, SimdMul(nx, scale), zero);
+		ny = SimdSelect(valid, SimdMul(ny, scale), zero);
+		nz = SimdSelect(valid, SimdMul(nz, scale), zero);
+
+		SimdStore(&orientation[0][i], SimdSelect(moving, nw, qw));
+		SimdStore(&orientation[1][i], SimdSelect(moving, nx, qx));
+		SimdStore(&orientation[2][i], SimdSelect(moving, ny, qy));
+		SimdStore(&orientation[3][i], SimdSelect(moving, nz, qz));
+	}
+}
+
+glm::vec3 PhysicsWorld::GetPosition(Handle handle) const
+{
+	unsigned index = Index(handle);
+	return glm::vec3(pos[0][index], pos[1][index], pos[2][index]);
+}
+
+void PhysicsWorld::SetPosition(Handle handle, const glm::vec3& position)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		pos[k][index] = position[k];
+}
+
+glm::vec3 PhysicsWorld::GetVelocity(Handle handle) const
+{
+	unsigned index = Index(handle);
+	return glm::vec3(vel[0][index], vel[1][index], vel[2][index]);
+}
+
+void PhysicsWorld::SetVelocity(Handle handle, const glm::vec3& velocity)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		vel[k][index] = velocity[k];
+}
+
+void PhysicsWorld::SetAcceleration(Handle handle, const glm::vec3& acceleration)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		accel[k][index] = acceleration[k];
+}
+
+float PhysicsWorld::GetMass(Handle handle) const
+{
+	float inverse = invMass[Index(handle)];
+	return inverse > 0.f ? 1.f / inverse : 0.f;
+}
+
+void PhysicsWorld::SetMass(Handle handle, float mass)
+{
+	invMass[Index(handle)] = mass > 0.f ? 1.f / mass : 0.f;
+}
+
+glm::quat PhysicsWorld::GetOrientation(Handle handle) const
+{
+	unsigned index = Index(handle);
+	return glm::quat(orientation[0][index], orientation[1][index], orientation[2][index], orientation[3][index]);
+}
+
+void PhysicsWorld::SetOrientation(Handle handle, const glm::quat& q)
+{
+	unsigned index = Index(handle);
+	orientation[0][index] = q.w;
+	orientation[1][index] = q.x;
+	orientation[2][index] = q.y;
+	orientation[3][index] = q.z;
+}
+
+void PhysicsWorld::SetAngularVelocity(Handle handle, const glm::vec3& angular)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		angularVel[k][index] = angular[k];
+}
+
+void PhysicsWorld::AddForce(Handle handle, const glm::vec3& f)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		force[k][index] += f[k];
+}
+
+void PhysicsWorld::AddImpulse(Handle handle, const glm::vec3& impulse)
+{
+	unsigned index = Index(handle);
+	for (int k = 0; k < 3; ++k)
+		vel[k][index] += impulse[k] * invMass[index];
+}
+
+void PhysicsWorld::CopyTo(Handle handle, PhysicsObject& obj) const
+{
+	obj.pos = GetPosition(handle);
+	obj.vel = GetVelocity(handle);
+	obj.orientation = GetOrientation(handle);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Scatter bodies with random motion and spin, one in sixteen static, and step
+them for a second at 60 Hz under gravity and a force per body: first as
+PhysicsObjects one UpdatePhysics call at a time, then as a PhysicsWorld.
+Reports the time per step of both and the largest difference between the
+final positions, which only rounding should leave.
+
+\param bodies - number of bodies
+*/
+/******************************************************************************/
+void RunPhysicsWorldBenchmark(unsigned bodies)
+{
+	const unsigned steps = 60;
+	const float dt = 1.f / 60.f;
+	const glm::vec3 gravity(0.f, -10.f, 0.f);
+	const glm::vec3 push(1.f, 0.f, 0.5f);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> field(-100.f, 100.f);
+	std::uniform_real_distribution<float> speed(-10.f, 10.f);
+	std::uniform_real_distribution<float> weight(0.5f, 5.f);
+
+	std::vector<PhysicsObject> objects(bodies);
+	for (unsigned i = 0; i < bodies; ++i)
+	{
+		PhysicsObject& obj = objects[i];
+		obj.pos = glm::vec3(field(random), field(random), field(random));
+		obj.vel = glm::vec3(speed(random), speed(random), speed(random));
+		obj.angularVel = glm::vec3(speed(random), speed(random), speed(random)) * 0.1f;
+		obj.orientation = glm::quat(1.f, 0.f, 0.f, 0.f);
+		obj.accel = gravity;
+		obj.mass = i % 16 == 0 ? 0.f : weight(random);
+	}
+
+	PhysicsWorld world;
+	std::vector<PhysicsWorld::Handle> handles;
+	for (const PhysicsObject& obj : objects)
+		handles.push_back(world.Add(obj));
+
+	StopWatch timer;
+	timer.startTimer();
+	for (unsigned s = 0; s < steps; ++s)
+	{
+		for (PhysicsObject& obj : objects)
+		{
+			obj.AddForce(push);
+			obj.UpdatePhysics(dt);
+		}
+	}
+	double objectTime = timer.getElapsedTime();
+
+	for (unsigned s = 0; s < steps; ++s)
+	{
+		for (PhysicsWorld::Handle handle : handles)
+			world.AddForce(handle, push);
+		world.Step(dt);
+	}
+	double worldTime = timer.getElapsedTime();
+
+	float largest = 0.f;
+	for (unsigned i = 0; i < bodies; ++i)
+		largest = std::max(largest, glm::length(world.GetPosition(handles[i]) - objects[i].pos));
+
+	std::cout << bodies << " bodies, " << LANES << " per SIMD step\n"
+		<< "PhysicsObject::UpdatePhysics: " << objectTime * 1000.0 / steps << " ms per step\n"
+		<< "PhysicsWorld::Step: " << worldTime * 1000.0 / steps << " ms per step (forces included)\n"
+		<< "Largest position difference: " << largest << "\n";
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+#include "PhysicsObject.h"
+
+/******************************************************************************/
+/*!
+		Class PhysicsWorld:
+\brief	Integrates many bodies at once. Positions, velocities, forces,
+		constant accelerations, inverse masses, angular velocities and
+		orientations are kept in one array per component, so Step() can
+		load several bodies into an SSE register (AVX when the build
+		enables it) and run the same semi-implicit Euler as
+		PhysicsObject::UpdatePhysics on all of them together. The damping
+		factor depends only on dt and is worked out once per step.
+
+		Sizes, bounciness and the like stay with the scene, which keeps
+		only the handle Add() returns and reads or writes a body through
+		it. Handles stay valid until Remove(); the arrays are kept packed
+		by moving the last body into the removed one's place.
+
+		Bodies with zero inverse mass are static: Step() clears their
+		forces and leaves the rest alone, as UpdatePhysics does for a
+		zero mass.
+*/
+/******************************************************************************/
+class PhysicsWorld
+{
+public:
+	typedef unsigned Handle;
+	static const Handle INVALID_HANDLE = ~0u;
+
+	PhysicsWorld();
+
+	// A body at rest at pos; a mass of 0 makes it static
+	Handle Add(const glm::vec3& pos, float mass);
+	// A body with obj's position, motion and mass
+	Handle Add(const PhysicsObject& obj);
+	void Remove(Handle handle);
+	void Clear();
+
+	void Step(float dt);
+
+	glm::vec3 GetPosition(Handle handle) const;
+	void SetPosition(Handle handle, const glm::vec3& pos);
+	glm::vec3 GetVelocity(Handle handle) const;
+	void SetVelocity(Handle handle, const glm::vec3& vel);
+	void SetAcceleration(Handle handle, const glm::vec3& accel);
+	float GetMass(Handle handle) const;
+	void SetMass(Handle handle, float mass);
+	glm::quat GetOrientation(Handle handle) const;
+	void SetOrientation(Handle handle, const glm::quat& orientation);
+	void SetAngularVelocity(Handle handle, const glm::vec3& angularVel);
+
+	void AddForce(Handle handle, const glm::vec3& force);
+	void AddImpulse(Handle handle, const glm::vec3& impulse);
+
+	// Copy a body's position, motion and orientation back into obj
+	void CopyTo(Handle handle, PhysicsObject& obj) const;
+
+	unsigned GetCount() const { return count; }
+
+private:
+	unsigned Index(Handle handle) const { return handleToIndex[handle]; }
+	void Reserve(unsigned bodies);
+
+	unsigned count;
+	// Arrays are padded to a whole number of SIMD lanes with static bodies
+	unsigned padded;
+
+	std::vector<float> pos[3];
+	std::vector<float> vel[3];
+	std::vector<float> force[3];
+	std::vector<float> accel[3];
+	std::vector<float> invMass;
+	std::vector<float> angularVel[3];
+	std::vector<float> orientation[4];	// w, x, y, z
+
+	std::vector<unsigned> handleToIndex;	// INVALID_HANDLE for free handles
+	std::vector<Handle> indexToHandle;
+	std::vector<Handle> freeHandles;
+};
+
+// Step bodies with PhysicsObject::UpdatePhysics one by one and with
+// PhysicsWorld::Step, and report the time per step of each
+void RunPhysicsWorldBenchmark(unsigned bodies);
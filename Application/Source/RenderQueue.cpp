@@ -0,0 +1,369 @@
+#include <iostream>
+#include <algorithm>
+#include <glm\gtc\type_ptr.hpp>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\matrix_inverse.hpp>
+#include "RenderQueue.h"
+#include "Mesh.h"
+#include "UniformBlocks.h"
+#include "Frustum.h"
+#include "MeshBuilder.h"
+#include "DrawBenchmark.h"
+#include <GLFW/glfw3.h>
+
+RenderQueue::RenderQueue()
+	: currentProgram(0)
+	, currentViews(ALL_VIEWS)
+	, sorted(true)
+	, frustum(nullptr)
+{
+	ResetStats();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Select the program for the following submits, looking up the uniforms the
+queue sets the first time a program is seen
+
+\param programID - linked program using the Texture.vertexshader uniforms
+*/
+/******************************************************************************/
+void RenderQueue::SetProgram(GLuint programID)
+{
+	for (unsigned i = 0; i < programs.size(); ++i)
+	{
+		if (programs[i].id == programID)
+		{
+			currentProgram = i;
+			return;
+		}
+	}
+
+	Program program;
+	program.id = programID;
+	program.locationModel = glGetUniformLocation(programID, "model");
+	program.locationNormal = glGetUniformLocation(programID, "MV_inverse_transpose");
+	program.locationLightEnabled = glGetUniformLocation(programID, "lightEnabled");
+	program.locationTextureEnabled = glGetUniformLocation(programID, "colorTextureEnabled");
+	currentProgram = programs.size();
+	programs.push_back(program);
+}
+
+void RenderQueue::SetFrustum(const Frustum* frustum)
+{
+	this->frustum = frustum;
+}
+
+void RenderQueue::SetViews(unsigned mask)
+{
+	currentViews = mask;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Queue a mesh for the following replays, in the views set by SetViews
+
+\param mesh - mesh to draw, one item per material range
+\param model - model matrix
+\param lightEnabled - light the mesh with its material
+\param lod - level history of this placement, or nullptr to select without hysteresis
+*/
+/******************************************************************************/
+void RenderQueue::Submit(Mesh* mesh, const glm::mat4& model, bool lightEnabled, LodState* lod)
+{
+	if (programs.empty() || mesh->indexSize == 0 || currentViews == 0)
+		return;
+
+	Item item;
+	item.program = currentProgram;
+	item.mesh = mesh;
+	item.bounds = &mesh->bounds;
+	item.views = currentViews;
+	item.lod = lod;
+	item.lightEnabled = lightEnabled;
+	item.model = model;
+
+	if (mesh->materialRanges.empty())
+	{
+		item.texture = mesh->textureID;
+		item.range = LOD_NONE;
+		item.offset = 0;
+		item.count = mesh->indexSize;
+		item.kAmbient = mesh->material.kAmbient;
+		item.kDiffuse = mesh->material.kDiffuse;
+		item.kSpecular = mesh->material.kSpecular;
+		item.kShininess = mesh->material.kShininess;
+		items.push_back(item);
+		sorted = false;
+		return;
+	}
+
+	for (unsigned i = 0; i < mesh->materialRanges.size(); ++i)
+	{
+		const MaterialRange& range = mesh->materialRanges[i];
+		if (i < mesh->rangeBounds.size())
+			item.bounds = &mesh->rangeBounds[i];
+
+		const Material& material = mesh->materials[range.material];
+		item.texture = material.textureID > 0 ? material.textureID : mesh->textureID;
+		item.range = i;
+		item.offset = range.offset;
+		item.count = range.count;
+		item.kAmbient = material.kAmbient;
+		item.kDiffuse = material.kDiffuse;
+		item.kSpecular = material.kSpecular;
+		item.kShininess = material.kShininess;
+		items.push_back(item);
+	}
+	sorted = false;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw the queued items tagged for one view, leaving them queued for the next
+view. The light block is left to the caller, as with RenderMesh.
+
+\param viewIndex - bit of the SetViews masks this view answers to
+\param view - view matrix of this view
+\param projection - projection matrix of this view
+*/
+/******************************************************************************/
+void RenderQueue::Replay(unsigned viewIndex, const glm::mat4& view, const glm::mat4& projection)
+{
+	// The order does not depend on the camera, so later views reuse it
+	if (!sorted)
+	{
+		std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+			if (a.program != b.program)
+				return a.program < b.program;
+			if (a.texture != b.texture)
+				return a.texture < b.texture;
+			if (a.mesh != b.mesh)
+				return a.mesh < b.mesh;
+			return a.offset < b.offset;
+		});
+		sorted = true;
+	}
+	const unsigned viewBit = 1u << viewIndex;
+
+	// Level selection needs the eye and how many pixels a unit at distance 1 covers
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+	float pixelScale = projection[1][1] * viewport[3] * 0.5f;
+
+	// Nothing is assumed about the state left by draws outside the queue
+	const Program* program = nullptr;
+	GLuint texture = 0;
+	const Mesh* mesh = nullptr;
+	int lightEnabled = -1;
+	int textureEnabled = -1;
+	const Item* material = nullptr;
+
+	// One camera upload for the whole view; draws only send their model matrix
+	UniformBlocks::GetInstance()->SetCamera(view, projection);
+	++stats.uniforms;
+
+	for (const Item& item : items)
+	{
+		if (!(item.views & viewBit))
+			continue;
+		++stats.submitted;
+		if (frustum && !frustum->Intersects(*item.bounds, item.model))
+		{
+			++stats.culled;
+			continue;
+		}
+
+		if (program != &programs[item.program])
+		{
+			program = &programs[item.program];
+			glUseProgram(program->id);
+			++stats.binds;
+			texture = 0;
+			lightEnabled = textureEnabled = -1;
+		}
+
+		int enableTexture = item.texture > 0 ? 1 : 0;
+		if (enableTexture != textureEnabled)
+		{
+			glUniform1i(program->locationTextureEnabled, enableTexture);
+			++stats.uniforms;
+			textureEnabled = enableTexture;
+		}
+		if (item.texture > 0 && item.texture != texture)
+		{
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, item.texture);
+			++stats.binds;
+			texture = item.texture;
+		}
+
+		glUniformMatrix4fv(program->locationModel, 1, GL_FALSE, glm::value_ptr(item.model));
+		++stats.uniforms;
+
+		int enableLight = item.lightEnabled ? 1 : 0;
+		if (enableLight != lightEnabled)
+		{
+			glUniform1i(program->locationLightEnabled, enableLight);
+			++stats.uniforms;
+			lightEnabled = enableLight;
+		}
+		if (item.lightEnabled)
+		{
+			glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(view * item.model));
+			glUniformMatrix3fv(program->locationNormal, 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+			++stats.uniforms;
+
+			// Materials only matter while lit. The block is shared by all
+			// programs, so a program switch does not invalidate it
+			if (material == nullptr || material->kAmbient != item.kAmbient || material->kDiffuse != item.kDiffuse ||
+				material->kSpecular != item.kSpecular || material->kShininess != item.kShininess)
+			{
+				UniformBlocks::GetInstance()->SetMaterial(item.kAmbient, item.kDiffuse, item.kSpecular, item.kShininess);
+				++stats.uniforms;
+				material = &item;
+			}
+		}
+
+		if (item.mesh != mesh)
+		{
+			++stats.binds; // the vertex array, bound by Render
+			mesh = item.mesh;
+		}
+
+		// Every range of a placement sees the same bounds, so they agree on the level
+		unsigned level = 0;
+		unsigned offset = item.offset;
+		unsigned count = item.count;
+		if (!item.mesh->lods.empty())
+		{
+			bool tracked = item.lod && viewIndex < LodState::MAX_VIEWS;
+			level = item.mesh->SelectLod(item.model, eye, pixelScale, tracked ? item.lod->level[viewIndex] : LOD_NONE);
+			if (tracked)
+				item.lod->level[viewIndex] = level;
+			if (level > 0)
+			{
+				const MeshLod& lod = item.mesh->lods[level - 1];
+				bool whole = item.range == LOD_NONE || item.range >= lod.ranges.size();
+				offset = whole ? lod.offset : lod.ranges[item.range].offset;
+				count = whole ? lod.count : lod.ranges[item.range].count;
+			}
+		}
+		item.mesh->Render(offset, count, level);
+		++stats.draws;
+		stats.triangles += level > 0 || item.mesh->mode == Mesh::DRAW_TRIANGLES ? count / 3 : (count > 2 ? count - 2 : 0);
+	}
+}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	sorted = true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw and clear everything queued since the last Flush
+
+\param view - view matrix of this view
+\param projection - projection matrix of this view
+*/
+/******************************************************************************/
+void RenderQueue::Flush(const glm::mat4& view, const glm::mat4& projection)
+{
+	Replay(0, view, projection);
+	Clear();
+}
+
+void RenderQueue::ResetStats()
+{
+	stats.draws = 0;
+	stats.binds = 0;
+	stats.uniforms = 0;
+	stats.submitted = 0;
+	stats.culled = 0;
+	stats.triangles = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw props alternating spheres and cubes from one camera, then split-screen
+from two cameras, first building the list per view and then building it once
+and replaying it per view. The model matrices are rebuilt every frame like a
+scene's modelStack work. Needs a current GL context.
+
+\param props - number of props
+*/
+/******************************************************************************/
+void RunSplitScreenBenchmark(unsigned props)
+{
+	const float spacing = 6.f;
+
+	DrawBenchmark benchmark;
+	glUniform1i(benchmark.GetUniform("textEnabled"), 0);
+
+	Mesh* meshes[2] = {
+		MeshBuilder::GenerateSphere("Sphere", glm::vec3(0.8f, 0.3f, 0.3f), 1.f, 16, 16),
+		MeshBuilder::GenerateCube("Cube", glm::vec3(0.3f, 0.3f, 0.8f), 1.5f),
+	};
+
+	unsigned side = 1;
+	while (side * side < props)
+		++side;
+	float half = (side - 1) * spacing * 0.5f;
+
+	GLint width = 800, height = 600;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.f), (float)(width / 2) / (float)height, 0.1f, 5000.f);
+	glm::mat4 views[2] = {
+		glm::lookAt(glm::vec3(-10.f, half, half * 2.f + 10.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)),
+		glm::lookAt(glm::vec3(10.f, half, half * 2.f + 10.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)),
+	};
+	Frustum frustum;
+
+	RenderQueue queue;
+	queue.SetProgram(benchmark.GetProgram());
+	queue.SetFrustum(&frustum);
+
+	auto submitAll = [&]() {
+		for (unsigned i = 0; i < props; ++i)
+		{
+			glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3((i % side) * spacing - half, 0.f, (i / side) * spacing - half));
+			model = glm::rotate(model, glm::radians(i * 37.f), glm::vec3(0.f, 1.f, 0.f));
+			queue.Submit(meshes[i % 2], model, true);
+		}
+	};
+
+	// Draws issued by the frame, with the list built per view or once and replayed
+	auto drawFrame = [&](unsigned viewCount, bool replay) {
+		queue.ResetStats();
+		if (replay)
+			submitAll();
+		for (unsigned v = 0; v < viewCount; ++v)
+		{
+			glViewport(v * width / 2, 0, width / 2, height);
+			frustum.Extract(projection * views[v]);
+			if (!replay)
+				submitAll();
+			queue.Replay(replay ? v : 0, views[v], projection);
+			if (!replay)
+				queue.Clear();
+		}
+		queue.Clear();
+		return queue.GetStats().draws;
+	};
+
+	benchmark.Run("One view: ", "draw calls", [&]() { return drawFrame(1, false); });
+	benchmark.Run("Two views, list per view: ", "draw calls", [&]() { return drawFrame(2, false); });
+	benchmark.Run("Two views, list replayed: ", "draw calls", [&]() { return drawFrame(2, true); });
+
+	glViewport(0, 0, width, height);
+	delete meshes[0];
+	delete meshes[1];
+}
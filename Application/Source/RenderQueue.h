@@ -0,0 +1,114 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+#include <glm\glm.hpp>
+#include <GL\glew.h>
+
+class Mesh;
+class Frustum;
+struct Bounds;
+struct LodState;
+
+/******************************************************************************/
+/*!
+		Class RenderQueue:
+\brief	Collects the draws of one view instead of issuing them on the spot.
+		Flush sorts them by shader, then texture, then mesh, and only
+		touches GL state that differs from the previous draw. Meshes with
+		a material table are split into one item per material range.
+
+		Items snapshot the mesh's material when submitted, so scenes can
+		keep tweaking mesh->material between submits as they did between
+		RenderMesh calls.
+
+		Split-screen scenes submit the frame's draws once and Replay the
+		list per camera, so only the camera block, the culling and the
+		draws themselves are repeated per view. Draws meant for some views
+		only, like a player's own model, are tagged with SetViews.
+
+		With a frustum set, each view drops the items outside it, testing
+		a mesh's material ranges one by one. Meshes with decimated levels
+		are drawn at the level Mesh::SelectLod picks for each view.
+*/
+/******************************************************************************/
+class RenderQueue
+{
+public:
+	struct Stats
+	{
+		unsigned draws;
+		unsigned binds;		// program, texture and vertex array binds
+		unsigned uniforms;	// glUniform* calls and uniform block uploads
+		unsigned submitted;	// queued items the view considered
+		unsigned culled;	// of those, the ones outside the frustum
+		unsigned triangles;	// drawn, after level selection
+	};
+
+	static const unsigned ALL_VIEWS = ~0u;
+
+	RenderQueue();
+
+	// Program used by the following submits; uniform locations are looked up once per program
+	void SetProgram(GLuint programID);
+	// Frustum items are tested against, or nullptr to draw everything. It is
+	// read at each Replay, so the caller can re-extract it between views
+	void SetFrustum(const Frustum* frustum);
+	// Views the following submits are drawn in, one bit per view index
+	void SetViews(unsigned mask);
+
+	// lod keeps the placement's levels between frames, for hysteresis; it must outlive the queue's items
+	void Submit(Mesh* mesh, const glm::mat4& model, bool lightEnabled, LodState* lod = nullptr);
+	// Draw the items tagged for view without clearing them
+	void Replay(unsigned viewIndex, const glm::mat4& view, const glm::mat4& projection);
+	// Forget everything queued; the next frame submits afresh
+	void Clear();
+	// Replay as view 0 and clear, for scenes with a single view
+	void Flush(const glm::mat4& view, const glm::mat4& projection);
+
+	const Stats& GetStats() const { return stats; }
+	void ResetStats();
+
+private:
+	struct Program
+	{
+		GLuint id;
+		GLint locationModel;
+		GLint locationNormal;
+		GLint locationLightEnabled;
+		GLint locationTextureEnabled;
+	};
+
+	struct Item
+	{
+		unsigned program;	// index into programs
+		GLuint texture;
+		Mesh* mesh;
+		const Bounds* bounds;	// of the whole mesh or of its range
+		unsigned views;		// mask of the views the item is drawn in
+		unsigned range;		// material range, or LOD_NONE for the whole mesh
+		LodState* lod;
+		unsigned offset;	// index range drawn at full detail
+		unsigned count;
+		bool lightEnabled;
+		glm::vec3 kAmbient;
+		glm::vec3 kDiffuse;
+		glm::vec3 kSpecular;
+		float kShininess;
+		glm::mat4 model;
+	};
+
+	std::vector<Program> programs;
+	std::vector<Item> items;
+	unsigned currentProgram;
+	unsigned currentViews;
+	bool sorted;		// items are sorted once, before the first Replay
+	const Frustum* frustum;
+	Stats stats;
+};
+
+// Time props drawn from one camera against two cameras, with the draw list
+// built per view and built once and replayed
+void RunSplitScreenBenchmark(unsigned props);
+
+#endif
@@ -9,8 +9,16 @@ public:
 
 	virtual void Init() = 0;
 	virtual void Update(double dt) = 0;
+	// Physics, run by the application at a fixed step zero or more times a frame after Update
+	virtual void FixedUpdate(double dt) {}
 	virtual void Render() = 0;
 	virtual void Exit() = 0;
+
+	// How far this frame lies from the last fixed step towards the next one, in [0, 1)
+	void SetInterpolation(float alpha) { interpolation = alpha; }
+
+protected:
+	float interpolation = 1.f;
 };
 
 #endif
\ No newline at end of file
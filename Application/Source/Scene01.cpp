@@ -3,6 +3,7 @@
 // ---------------------------------------------------------------
 
 #include "Scene01.h"
+#include "UniformBlocks.h"
 #include "Mesh.h"
 #include "GL\glew.h"
 
@@ -18,11 +19,14 @@
 #include "shader.hpp"
 #include "Application.h"
 #include "MeshBuilder.h"
+#include "AssetCache.h"
 #include "KeyboardController.h"
 #include "LoadTGA.h"
+#include "AssetStreamer.h"
 #include "MouseController.h"
 #include <iostream>
 #include <iomanip>
+#include <cstdio>
 #include <cmath> // for atan2, etc.
 
 // repo cloning text test
@@ -57,32 +61,20 @@ void Scene01::Init()
 	//m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Texture.fragmentshader");
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
 	glUseProgram(m_programID);
+	UniformBlocks::GetInstance()->BindProgram(m_programID);
 
-	// Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
+	// Get a handle for our "model" uniform
+	m_parameters[U_MODEL] = glGetUniformLocation(m_programID, "model");
 	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
 	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
 	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
 	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
 
-	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT], m_parameters[U_MATERIAL_DIFFUSE], m_parameters[U_MATERIAL_SPECULAR], m_parameters[U_MATERIAL_SHININESS]);
+	Mesh::SetTextureLoc(m_parameters[U_COLOR_TEXTURE_ENABLED]);
+	m_parameters[U_INSTANCED] = glGetUniformLocation(m_programID, "instanced");
+	Mesh::SetInstancedLoc(m_parameters[U_INSTANCED]);
+	renderQueue.SetProgram(m_programID);
+	renderQueue.SetFrustum(&frustum);
 
 	// Initialise camera properties
 	//camera.Init(45.f, 45.f, 10.f);
@@ -119,6 +111,8 @@ void Scene01::Init()
 	}
 
 	// Init VBO here
+	// Models and textures stream in over the next frames; until then the
+	// meshes draw nothing and textures are plain white
 	for (int i = 0; i < NUM_GEOMETRY; ++i)
 	{
 		meshList[i] = nullptr;
@@ -130,33 +124,33 @@ void Scene01::Init()
 
 	meshList[GEO_LEFT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_LEFT]->textureID = LoadTGA("Images//blackblack.tga");
-	meshList[GEO_LEFT]->textureID = LoadTGA("Images//whitesky//whiteskyleft.tga");
+	meshList[GEO_LEFT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskyleft.tga", true);
 	//meshList[GEO_LEFT]->textureID = LoadTGA("Images//left.tga");
 
 	meshList[GEO_RIGHT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_RIGHT]->textureID = LoadTGA("Images//blackblack.tga");
-	meshList[GEO_RIGHT]->textureID = LoadTGA("Images//whitesky//whiteskyright.tga");
+	meshList[GEO_RIGHT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskyright.tga", true);
 	//meshList[GEO_RIGHT]->textureID = LoadTGA("Images//right.tga");
 
 	meshList[GEO_BACK] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_BACK]->textureID = LoadTGA("Images//blackblack.tga");
-	meshList[GEO_BACK]->textureID = LoadTGA("Images//whitesky//whiteskyback.tga");
+	meshList[GEO_BACK]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskyback.tga", true);
 	//meshList[GEO_BACK]->textureID = LoadTGA("Images//back.tga");
 
 	meshList[GEO_FRONT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_FRONT]->textureID = LoadTGA("Images//blackblack.tga");
-	meshList[GEO_FRONT]->textureID = LoadTGA("Images//whitesky//whiteskyfront.tga");
+	meshList[GEO_FRONT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskyfront.tga", true);
 	//meshList[GEO_FRONT]->textureID = LoadTGA("Images//front.tga");
 
 	meshList[GEO_TOP] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//saharatop.tga");
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//top.tga");
-	meshList[GEO_TOP]->textureID = LoadTGA("Images//whitesky//whiteskytop.tga");
+	meshList[GEO_TOP]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskytop.tga", true);
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//bigblackmoon.tga");
 
 	meshList[GEO_BOTTOM] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//blackblack.tga");
-	meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//whitesky//whiteskybottom.tga");
+	meshList[GEO_BOTTOM]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//whitesky//whiteskybottom.tga", true);
 	//meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//bottom.tga");
 
 	//meshList[GEO_QUAD]->textureID = LoadTGA("Images//NYP.tga");
@@ -165,63 +159,58 @@ void Scene01::Init()
 	meshList[GEO_CYLINDER] = MeshBuilder::GenerateCylinder("Cylinder", glm::vec3(1.f, 1.f, 1.f), 36, 1.f, 2.f);
 
 	meshList[GEO_GRASS] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
-	meshList[GEO_GRASS]->textureID = LoadTGA("Images//coast_sand_rocks_02 copy.tga");
+	meshList[GEO_GRASS]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga", true);
 
 	//meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
 	//meshList[GEO_GUI]->textureID = LoadTGA("Images//color.tga");
 
 	// 16 x 16 is the number of columns and rows for the text
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
-	meshList[GEO_TEXT]->textureID = LoadTGA("Images//Georgia.tga");
+	meshList[GEO_TEXT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//Georgia.tga");
+	textRenderer = new TextRenderer("Images//Georgia.tga", 16, 16);
 
 	meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_GUI]->textureID = LoadTGA("Images//blackblack.tga");
+	meshList[GEO_GUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//blackblack.tga", true);
 
-	meshList[GEO_SHADOW] = MeshBuilder::GenerateOBJMTL("shadow", "Models//swamp_monster.obj", "Models//swamp_monster.mtl");
-	meshList[GEO_SHADOW]->textureID = LoadTGA("Images//FOREST_MONSTER_V1_mat_diffuse.tga");
+	meshList[GEO_SHADOW] = AssetCache::GetInstance()->AcquireOBJMTL("shadow", "Models//swamp_monster.obj", "Models//swamp_monster.mtl", "", true);
 
-	meshList[GEO_ABANDONEDHOUSE] = MeshBuilder::GenerateOBJMTL("bumper car", "Models//abandoned_house.obj", "Models//abandoned_house.mtl");
-	meshList[GEO_ABANDONEDHOUSE]->textureID = LoadTGA("Images//abandonedhouseBaseColor.tga");
+	meshList[GEO_ABANDONEDHOUSE] = AssetCache::GetInstance()->AcquireOBJMTL("bumper car", "Models//abandoned_house.obj", "Models//abandoned_house.mtl", "Images//abandonedhouseBaseColor.tga", true);
 
-	meshList[BUMPERCAR] = MeshBuilder::GenerateOBJMTL("bumper car", "Models//Bumper Car//bumper_car.obj", "Models//Bumper Car//bumper_car.mtl");
-	meshList[BUMPERCAR]->textureID = LoadTGA("Images//Bumper Car//bumpercar_baseColor.tga");
+	meshList[BUMPERCAR] = AssetCache::GetInstance()->AcquireOBJMTL("bumper car", "Models//Bumper Car//bumper_car.obj", "Models//Bumper Car//bumper_car.mtl", "", true);
 
-	meshList[TALLTREE] = MeshBuilder::GenerateOBJMTL("bumper car", "Models//tree//VeryTallTree.obj", "Models//tree//VeryTallTree.mtl");
-	meshList[TALLTREE]->textureID = LoadTGA("Images//TallTree_baseColor.tga");
+	meshList[TALLTREE] = AssetCache::GetInstance()->AcquireOBJMTL("bumper car", "Models//tree//VeryTallTree.obj", "Models//tree//VeryTallTree.mtl", "Images//TallTree_baseColor.tga", true);
 
-	meshList[JEFFREYEPSTEIN] = MeshBuilder::GenerateOBJMTL("bumper car", "Models//jeffrey//jeffreyepsteinfiles.obj", "Models//jeffrey//jeffreyepsteinfiles.mtl");
-	meshList[JEFFREYEPSTEIN]->textureID = LoadTGA("Images//jeffrey//jeffreyepstein_baseColor.tga");
+	meshList[JEFFREYEPSTEIN] = AssetCache::GetInstance()->AcquireOBJMTL("bumper car", "Models//jeffrey//jeffreyepsteinfiles.obj", "Models//jeffrey//jeffreyepsteinfiles.mtl", "Images//jeffrey//jeffreyepstein_baseColor.tga", true);
 
-	meshList[FOREST] = MeshBuilder::GenerateOBJMTL("bumper car", "Models//forest//forest.obj", "Models//forest//forest.mtl");
-	meshList[FOREST]->textureID = LoadTGA("Images//forest//forest_baseColor.tga");
+	meshList[FOREST] = AssetCache::GetInstance()->AcquireOBJMTL("bumper car", "Models//forest//forest.obj", "Models//forest//forest.mtl", "Images//forest//forest_baseColor.tga", true);
 
 	meshList[EXITBUTTON] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[EXITBUTTON]->textureID = LoadTGA("Images//exitScene01button.tga");
+	meshList[EXITBUTTON]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//exitScene01button.tga", true);
 
 	meshList[PAUSEMENU] = MeshBuilder::GenerateQuad("pause", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[PAUSEMENU]->textureID = LoadTGA("Images//scene01pausemenuv2.tga");
+	meshList[PAUSEMENU]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//scene01pausemenuv2.tga", true);
 
 	{
 		// PLAYER INDICATOR
 		meshList[PLAYER1INDICATORUI] = MeshBuilder::GenerateQuad("player1", glm::vec3(1.f, 1.f, 1.f), 1.f);
-		meshList[PLAYER1INDICATORUI]->textureID = LoadTGA("Images//scene01 UI//scene01player1_indicatorUI.tga");
+		meshList[PLAYER1INDICATORUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//scene01 UI//scene01player1_indicatorUI.tga", true);
 
 		meshList[PLAYER2INDICATORUI] = MeshBuilder::GenerateQuad("player2", glm::vec3(1.f, 1.f, 1.f), 1.f);
-		meshList[PLAYER2INDICATORUI]->textureID = LoadTGA("Images//scene01 UI//scene01player2_indicatorUI.tga");
+		meshList[PLAYER2INDICATORUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//scene01 UI//scene01player2_indicatorUI.tga", true);
 	}
 
 	{
 		// GROUND
 		meshList[GREYGROUND] = MeshBuilder::GenerateQuad("grey ground", glm::vec3(1.f, 1.f, 1.f), 1.f);
-		meshList[GREYGROUND]->textureID = LoadTGA("Images//scene01_ground//greyground.tga");
+		meshList[GREYGROUND]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//scene01_ground//greyground.tga", true);
 	}
 
+	BuildStaticWorld();
+
 	glm::mat4 projection = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 1000.0f);
 	projectionStack.LoadMatrix(projection);
 
 
-	glUniform1i(m_parameters[U_NUMLIGHTS], NUM_LIGHTS);
-
 	light[0].position = glm::vec3(100, 100, 0);
 	light[0].color = glm::vec3(1, 1, 0.7);
 	light[0].type = Light::LIGHT_DIRECTIONAL;
@@ -234,16 +223,6 @@ void Scene01::Init()
 	light[0].exponent = 3.f;
 	light[0].spotDirection = glm::vec3(0.f, 1.f, 0.f);
 
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], cosf(glm::radians<float>(light[0].cosCutoff)));
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], cosf(glm::radians<float>(light[0].cosInner)));
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-
 	enableLight = true;
 
 	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
@@ -453,7 +432,7 @@ void Scene01::RenderSkybox()
 	modelStack.Translate(0.f, 0.f, -500.f);
 	modelStack.Scale(10.f, 10.f, 10.f);
 	modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
-	RenderMesh(meshList[GEO_FRONT], false);
+	QueueMesh(meshList[GEO_FRONT], false);
 	modelStack.PopMatrix();
 
 	// Back face (rotate 180 degrees around Y)
@@ -461,7 +440,7 @@ void Scene01::RenderSkybox()
 	modelStack.Translate(0.f, 0.f, 500.f);
 	modelStack.Rotate(-180.f, 1.f, 1.f, 0.f);
 	modelStack.Scale(10.f, 10.f, 10.f);
-	RenderMesh(meshList[GEO_BACK], false);
+	QueueMesh(meshList[GEO_BACK], false);
 	modelStack.PopMatrix();
 
 	// Left face (rotate 90 degrees around Y)
@@ -470,7 +449,7 @@ void Scene01::RenderSkybox()
 	modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
 	modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
 	modelStack.Scale(10.f, 10.f, 10.f);
-	RenderMesh(meshList[GEO_LEFT], false);
+	QueueMesh(meshList[GEO_LEFT], false);
 	modelStack.PopMatrix();
 
 	// Right face (rotate -90 degrees around Y)
@@ -479,7 +458,7 @@ void Scene01::RenderSkybox()
 	modelStack.Rotate(-90.f, 0.f, 1.f, 0.f);
 	modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
 	modelStack.Scale(10.f, 10.f, 10.f);
-	RenderMesh(meshList[GEO_RIGHT], false);
+	QueueMesh(meshList[GEO_RIGHT], false);
 	modelStack.PopMatrix();
 
 	// Top face (rotate -90 degrees around X)
@@ -488,7 +467,7 @@ void Scene01::RenderSkybox()
 	modelStack.Rotate(90.f, 1.f, 0.f, 0.f);
 	modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
 	modelStack.Scale(10.f, 10.f, 10.f);
-	RenderMesh(meshList[GEO_TOP], false);
+	QueueMesh(meshList[GEO_TOP], false);
 	modelStack.PopMatrix();
 
 	// Bottom face (rotate 90 degrees around X)
@@ -497,11 +476,11 @@ void Scene01::RenderSkybox()
 	modelStack.Scale(10.f, 10.f, 10.f); // CHANGE TO 10
 	modelStack.Rotate(-90.f, 1.f, 0.f, 0.f);
 	modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
-	RenderMesh(meshList[GEO_BOTTOM], false);
+	QueueMesh(meshList[GEO_BOTTOM], false);
 	modelStack.PopMatrix();
 }
 
-void Scene01::RenderPathway()
+void Scene01::BuildPathway()
 {
 	// Render the pathway as a smooth curved strip built from identical GREYGROUND quads.
 	// Each tile keeps the same scale used previously so visual scale remains unchanged.
@@ -531,6 +510,7 @@ void Scene01::RenderPathway()
 	const float pathHeightScale = 50;
 	const float pathDepthScale = 5;
 
+	// The curve is fixed, so the tiles are baked into the static world
 	for (int i = 0; i < segments; ++i)
 	{
 		// center each segment on its parametric midpoint for nicer overlap
@@ -542,6 +522,7 @@ void Scene01::RenderPathway()
 		float yaw = glm::degrees(atan2(tangent.z, tangent.x));
 
 		modelStack.PushMatrix();
+		modelStack.LoadIdentity();
 		// Position on the curve
 		modelStack.Translate(pos.x, pos.y, pos.z);
 
@@ -555,12 +536,109 @@ void Scene01::RenderPathway()
 		// Keep tile scale but use narrower width (X)
 		modelStack.Scale(pathWidth, pathHeightScale, pathDepthScale);
 
-		// Render without lighting (same as original pathway)
-		RenderMesh(meshList[GREYGROUND], false);
+		// Without lighting, same as the original pathway
+		staticWorld.Add(meshList[GREYGROUND], modelStack.Top(), false);
 		modelStack.PopMatrix();
 	}
 }
 
+/******************************************************************************/
+/*!
+\brief
+Record the props that never move. They are merged into a few world-space
+meshes by RenderStaticWorld once every one of them has streamed in.
+*/
+/******************************************************************************/
+void Scene01::BuildStaticWorld()
+{
+	staticWorld.Clear();
+
+	modelStack.PushMatrix();
+	modelStack.LoadIdentity();
+
+	/*
+	========================================
+	FOREST
+	========================================
+	*/
+	{
+
+		modelStack.PushMatrix();
+		modelStack.Translate(250, -2, 0.f);
+		modelStack.Scale(10, 10, 10);
+		meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
+		staticWorld.Add(meshList[FOREST], modelStack.Top(), false);
+		modelStack.PopMatrix();
+
+		modelStack.PushMatrix();
+		modelStack.Translate(250, -2, 150);
+		modelStack.Scale(10, 10, 10);
+		meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
+		staticWorld.Add(meshList[FOREST], modelStack.Top(), false);
+		modelStack.PopMatrix();
+
+		modelStack.PushMatrix();
+		modelStack.Translate(250, -2, -150);
+		modelStack.Scale(10, 10, 10);
+		meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
+		staticWorld.Add(meshList[FOREST], modelStack.Top(), false);
+		modelStack.PopMatrix();
+
+	}
+
+	{
+
+		modelStack.PushMatrix();
+		modelStack.Translate(30.f, 0.f, -10.f);
+		modelStack.Scale(0.5, 0.5, 0.5);
+		modelStack.Rotate(75.f, 0.f, 1.f, 0.f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kShininess = 5.0f;
+		staticWorld.Add(meshList[GEO_ABANDONEDHOUSE], modelStack.Top(), true);
+		modelStack.PopMatrix();
+
+		modelStack.PushMatrix();
+		modelStack.Translate(10.f, 0.f, -10.f);
+		modelStack.Scale(0.5, 0.5, 0.5);
+		modelStack.Rotate(-75.f, 0.f, 1.f, 0.f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+		meshList[GEO_ABANDONEDHOUSE]->material.kShininess = 5.0f;
+		staticWorld.Add(meshList[GEO_ABANDONEDHOUSE], modelStack.Top(), true);
+		modelStack.PopMatrix();
+	}
+
+	modelStack.PushMatrix();
+	modelStack.Translate(0.f, 0.f, -10.f);
+	modelStack.Scale(0.1, 0.1, 0.1);
+	meshList[TALLTREE]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+	meshList[TALLTREE]->material.kDiffuse = glm::vec3(1, 1, 1);
+	meshList[TALLTREE]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
+	meshList[TALLTREE]->material.kShininess = 5.0f;
+	staticWorld.Add(meshList[TALLTREE], modelStack.Top(), false);
+	modelStack.PopMatrix();
+
+	BuildPathway();
+
+	modelStack.PopMatrix();
+}
+
+void Scene01::RenderStaticWorld()
+{
+	// Nothing is drawn until the last prop has streamed in and the batches are baked
+	if (!staticWorld.Build())
+		return;
+
+	modelStack.PushMatrix();
+	modelStack.LoadIdentity();
+	for (const StaticBatch::Batch& batch : staticWorld.GetBatches())
+		QueueMesh(batch.mesh, batch.lightEnabled);
+	modelStack.PopMatrix();
+}
+
 void Scene01::RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey)
 {
 	glDisable(GL_DEPTH_TEST);
@@ -616,16 +694,11 @@ void Scene01::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(
-			glm::mat4(1.f),
-			glm::vec3(i * 1.f, 0, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	// Centred on the origin like the old one-quad-per-character layout
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, -0.5f, -0.4f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
@@ -634,11 +707,18 @@ void Scene01::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 }
 
 
-void Scene01::RenderTextOnScreen(Mesh* mesh, std::string
-	text, glm::vec3 color, float size, float x, float y)
+// Queues the text for FlushTextOnScreen, which draws the whole viewport's HUD in one call
+void Scene01::RenderTextOnScreen(Mesh* mesh, const char* text, glm::vec3 color, float size, float x, float y)
 {
 	if (!mesh || mesh->textureID <= 0) //Proper error check
 		return;
+	textRenderer->Add(text, color, size, x, y);
+}
+
+void Scene01::FlushTextOnScreen(Mesh* mesh)
+{
+	if (!mesh || mesh->textureID <= 0 || textRenderer->GetQueuedCount() == 0)
+		return;
 	// Enable blending
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -651,12 +731,12 @@ void Scene01::RenderTextOnScreen(Mesh* mesh, std::string
 	viewStack.PushMatrix();
 	viewStack.LoadIdentity(); //No need camera for ortho mode
 	modelStack.PushMatrix();
-	modelStack.LoadIdentity(); //Reset modelStack
-	modelStack.Translate(x, y, 0);
-	modelStack.Scale(size, size, size);
+	modelStack.LoadIdentity(); //Glyphs are laid out in screen units already
 
+	// Each string's colour is in its vertices
+	glm::vec3 white(1.f, 1.f, 1.f);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 1);
-	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &color.r);
+	glUniform3fv(m_parameters[U_TEXT_COLOR], 1, &white.r);
 	glUniform1i(m_parameters[U_LIGHTENABLED], 0);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 1);
 
@@ -665,13 +745,9 @@ void Scene01::RenderTextOnScreen(Mesh* mesh, std::string
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(glm::mat4(1.f), glm::vec3(0.6f + i * 0.6f, 0.4f, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -685,322 +761,281 @@ void Scene01::RenderTextOnScreen(Mesh* mesh, std::string
 	glDisable(GL_BLEND);
 }
 
-void Scene01::RenderSceneFromCamera(FPCamera& cam)
+// Queue the CPU time and render counters of one viewport
+void Scene01::RenderViewStats(int view)
 {
-	if (!pausemenu)
-	{
-		bool isCamera1 = (&cam == &camera1);
-		bool isCamera2 = (&cam == &camera2);
-
-		viewStack.LoadIdentity();
-		viewStack.LookAt(
-			cam.position.x, cam.position.y, cam.position.z,
-			cam.target.x, cam.target.y, cam.target.z,
-			cam.up.x, cam.up.y, cam.up.z
-		);
-
-		// Load identity matrix into the model stack
-		modelStack.LoadIdentity();
-
-		if (light[0].type == Light::LIGHT_DIRECTIONAL)
-		{
-			glm::vec3 lightDir(light[0].position.x, light[0].position.y, light[0].position.z);
-			glm::vec3 lightDirection_cameraspace = viewStack.Top() * glm::vec4(lightDir, 0);
-			glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightDirection_cameraspace));
-		}
-		else if (light[0].type == Light::LIGHT_SPOT)
-		{
-			glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-			glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-			glm::vec3 spotDirection_cameraspace = viewStack.Top() * glm::vec4(light[0].spotDirection, 0);
-			glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, glm::value_ptr(spotDirection_cameraspace));
-		}
-		else {
-			// Calculate the light position in camera space
-			glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-			glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-		}
+	// Formatted in place, so the HUD allocates no strings per frame
+	char line[64];
+	snprintf(line, sizeof(line), "CPU:%.2fms List:%.2fms", viewCPUTime[view], drawListCPUTime);
+	RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 105);
+	snprintf(line, sizeof(line), "Draws:%u Binds:%u Uniforms:%u", viewStats[view].draws, viewStats[view].binds, viewStats[view].uniforms);
+	RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 135);
+	snprintf(line, sizeof(line), "Culled:%u/%u", viewStats[view].culled, viewStats[view].submitted);
+	RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 165);
+	snprintf(line, sizeof(line), "Triangles:%u", viewStats[view].triangles);
+	RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 195);
+}
 
-		// ---- RENDER EVERYTHING BELOW ----
+/******************************************************************************/
+/*!
+\brief
+Queue the frame's world draws once for both cameras. Draws that belong to one
+camera only, like the other player's model, are tagged with its view.
+*/
+/******************************************************************************/
+void Scene01::BuildDrawList()
+{
+	modelStack.LoadIdentity();
 
-		// Render light sphere - isolated transformations
+	// Render light sphere above each camera, in that camera's view only
+	FPCamera* cameras[2] = { &camera1, &camera2 };
+	for (int view = 0; view < 2; ++view)
+	{
+		renderQueue.SetViews(1u << view);
 		modelStack.PushMatrix();
-		modelStack.Translate(cam.position.x, 15.f, cam.position.z);
+		modelStack.Translate(cameras[view]->position.x, 15.f, cameras[view]->position.z);
 		modelStack.Scale(0.1f, 0.1f, 0.1f);
 		meshList[GEO_SPHERE]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
 		meshList[GEO_SPHERE]->material.kDiffuse = glm::vec3(0.f, 0.f, 0.f);
 		meshList[GEO_SPHERE]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
 		meshList[GEO_SPHERE]->material.kShininess = 5.0f;
-		RenderMesh(meshList[GEO_SPHERE], true);
+		QueueMesh(meshList[GEO_SPHERE], true);
 		modelStack.PopMatrix();
+	}
+	renderQueue.SetViews(RenderQueue::ALL_VIEWS);
 
-		// Skybox - now renders at world origin without accumulated transforms
-		RenderSkybox();
+	// Skybox - now renders at world origin without accumulated transforms
+	RenderSkybox();
+
+	// Forest, houses, tall tree and pathway, baked by BuildStaticWorld
+	RenderStaticWorld();
+
+	modelStack.PushMatrix();
+	modelStack.Translate(0.f, 0.f, -25.f);
+	modelStack.Scale(2, 2, 2);
+	meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+	meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(1, 1, 1);
+	meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
+	meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
+	QueueMesh(meshList[JEFFREYEPSTEIN], false, &statueLod);
+	modelStack.PopMatrix();
 
-		// grass tiled from -100 to 100 on X and Z, keep existing scale (5,1,5)
+	if (!player1InCar)
+	{
 		modelStack.PushMatrix();
+		modelStack.Translate(25, 0, -25);
+		modelStack.Scale(3, 3, 3);
+		meshList[BUMPERCAR]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+		meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(1, 1, 1);
+		meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
+		meshList[BUMPERCAR]->material.kShininess = 5.0f;
+		QueueMesh(meshList[BUMPERCAR], true, &carLods[0]);
+		modelStack.PopMatrix();
+
+		// ----- Render Player 1 Model -----
+		renderQueue.SetViews(1u << 1);  // only seen from camera2
 		{
-			// spacing chosen to match the previous manual placement (50 units)
-			const float start = -250.f;
-			const float end = 250.f;
-			const float step = 50.f;
-			for (float x = start; x <= end; x += step)
+			modelStack.PushMatrix();
+			modelStack.Translate(camera1.position.x, 0.5f, camera1.position.z);
+			modelStack.Scale(2, 2, 2);
+			modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
+
+			// Make the model face the direction camera1 is facing:
 			{
-				for (float z = start; z <= end; z += step)
-				{
-					modelStack.PushMatrix();
-					modelStack.Translate(x, 0.f, z);
-					modelStack.Scale(5.f, 1.f, 5.f);
-					// keep original rotations so the tile faces the same way as before
-					modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
-					modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-					RenderMesh(meshList[GEO_GRASS], true);
-					modelStack.PopMatrix();
-				}
+				glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
+				// Yaw in degrees from X axis
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				// Rotate the model around world Y so it faces the same horizontal direction
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
 			}
-			// keep the ambient material tweak from original code
-			meshList[GEO_GRASS]->material.kAmbient = glm::vec3(0.3f, 0.3f, 0.3f);
+
+			meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+			meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
+			QueueMesh(meshList[JEFFREYEPSTEIN], true, &playerLods[0]);
+			modelStack.PopMatrix();
 		}
-		modelStack.PopMatrix();
+		renderQueue.SetViews(RenderQueue::ALL_VIEWS);
+	}
 
-		RenderPathway();
+	if (!player2InCar)
+	{
+		modelStack.PushMatrix();
+		modelStack.Translate(25, 0, -45);
+		modelStack.Scale(3, 3, 3);
+		meshList[BUMPERCAR]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+		meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(1, 1, 1);
+		meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
+		meshList[BUMPERCAR]->material.kShininess = 5.0f;
+		QueueMesh(meshList[BUMPERCAR], true, &carLods[1]);
+		modelStack.PopMatrix();
 
-		/*
-		========================================
-		FOREST
-		========================================
-		*/
+		// ----- Render Player 2 Model -----
+		renderQueue.SetViews(1u << 0);  // only seen from camera1
 		{
-
 			modelStack.PushMatrix();
-			modelStack.Translate(250, -2, 0.f);
-			modelStack.Scale(10, 10, 10);
-			meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
-			RenderMesh(meshList[FOREST], false);
-			modelStack.PopMatrix();
+			modelStack.Translate(camera2.position.x, 0.5f, camera2.position.z);
+			modelStack.Scale(2, 2, 2);
+			modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
 
-			modelStack.PushMatrix();
-			modelStack.Translate(250, -2, 150);
-			modelStack.Scale(10, 10, 10);
-			meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
-			RenderMesh(meshList[FOREST], false);
-			modelStack.PopMatrix();
+			// Make the model face the direction camera2 is facing:
+			{
+				glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
+			}
 
-			modelStack.PushMatrix();
-			modelStack.Translate(250, -2, -150);
-			modelStack.Scale(10, 10, 10);
-			meshList[FOREST]->material.kAmbient = glm::vec3(0, 0, 0);
-			RenderMesh(meshList[FOREST], false);
+			meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+			meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
+			QueueMesh(meshList[JEFFREYEPSTEIN], true, &playerLods[1]);
 			modelStack.PopMatrix();
-
 		}
+		renderQueue.SetViews(RenderQueue::ALL_VIEWS);
+	}
 
+	if (player1InCar)
+	{
+		// ----- Render Player 1 Model -----
+		renderQueue.SetViews(1u << 1);  // only seen from camera2
 		{
-
 			modelStack.PushMatrix();
-			modelStack.Translate(30.f, 0.f, -10.f);
-			modelStack.Scale(0.5, 0.5, 0.5);
-			modelStack.Rotate(75.f, 0.f, 1.f, 0.f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kShininess = 5.0f;
-			RenderMesh(meshList[GEO_ABANDONEDHOUSE], true);
+			modelStack.Translate(camera1.position.x, 0.5f, camera1.position.z);
+			modelStack.Scale(3.f, 3.f, 3.f);
+
+			// Make the model face the direction camera1 is facing:
+			{
+				glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
+				// Yaw in degrees from X axis
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				// Rotate the model around world Y so it faces the same horizontal direction
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
+			}
+
+			meshList[BUMPERCAR]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+			meshList[BUMPERCAR]->material.kShininess = 5.0f;
+			QueueMesh(meshList[BUMPERCAR], true, &carLods[0]);
 			modelStack.PopMatrix();
 
 			modelStack.PushMatrix();
-			modelStack.Translate(10.f, 0.f, -10.f);
-			modelStack.Scale(0.5, 0.5, 0.5);
-			modelStack.Rotate(-75.f, 0.f, 1.f, 0.f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-			meshList[GEO_ABANDONEDHOUSE]->material.kShininess = 5.0f;
-			RenderMesh(meshList[GEO_ABANDONEDHOUSE], true);
+			modelStack.Translate(camera1.position.x, 0.f, camera1.position.z);
+			modelStack.Scale(2.f, 2.f, 2.f);
+			modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
+			// Make the model face the direction camera1 is facing:
+			{
+				glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
+				// Yaw in degrees from X axis
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				// Rotate the model around world Y so it faces the same horizontal direction
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
+			}
+			meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+			meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
+			QueueMesh(meshList[JEFFREYEPSTEIN], true, &playerLods[0]);
 			modelStack.PopMatrix();
 		}
-
-		modelStack.PushMatrix();
-		modelStack.Translate(0.f, 0.f, -10.f);
-		modelStack.Scale(0.1, 0.1, 0.1);
-		meshList[TALLTREE]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
-		meshList[TALLTREE]->material.kDiffuse = glm::vec3(1, 1, 1);
-		meshList[TALLTREE]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
-		meshList[TALLTREE]->material.kShininess = 5.0f;
-		RenderMesh(meshList[TALLTREE], false);
-		modelStack.PopMatrix();
-
-		modelStack.PushMatrix();
-		modelStack.Translate(0.f, 0.f, -25.f);
-		modelStack.Scale(2, 2, 2);
-		meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
-		meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(1, 1, 1);
-		meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
-		meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
-		RenderMesh(meshList[JEFFREYEPSTEIN], false);
-		modelStack.PopMatrix();
-
-		if (!player1InCar)
+		renderQueue.SetViews(RenderQueue::ALL_VIEWS);
+	}
+	if (player2InCar)
+	{
+		// ----- Render Player 2 Model -----
+		renderQueue.SetViews(1u << 0);  // only seen from camera1
 		{
 			modelStack.PushMatrix();
-			modelStack.Translate(25, 0, -25);
-			modelStack.Scale(3, 3, 3);
-			meshList[BUMPERCAR]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
-			meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(1, 1, 1);
-			meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
-			meshList[BUMPERCAR]->material.kShininess = 5.0f;
-			RenderMesh(meshList[BUMPERCAR], true);
-			modelStack.PopMatrix();
+			modelStack.Translate(camera2.position.x, 0.5f, camera2.position.z);
+			modelStack.Scale(3.f, 3.f, 3.f);
 
-			// ----- Render Player 1 Model -----
-			if (!isCamera1)  // If current view is NOT camera1
+			// Make the model face the direction camera2 is facing:
 			{
-				modelStack.PushMatrix();
-				modelStack.Translate(camera1.position.x, 0.5f, camera1.position.z);
-				modelStack.Scale(2, 2, 2);
-				modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-
-				// Make the model face the direction camera1 is facing:
-				{
-					glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
-					// Yaw in degrees from X axis
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					// Rotate the model around world Y so it faces the same horizontal direction
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
-				}
-
-				meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
-				RenderMesh(meshList[JEFFREYEPSTEIN], true);
-				modelStack.PopMatrix();
+				glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
 			}
-		}
 
-		if (!player2InCar)
-		{
-			modelStack.PushMatrix();
-			modelStack.Translate(25, 0, -45);
-			modelStack.Scale(3, 3, 3);
-			meshList[BUMPERCAR]->material.kAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
-			meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(1, 1, 1);
-			meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.9f, 0.9f, 0.9f);
+			meshList[BUMPERCAR]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
 			meshList[BUMPERCAR]->material.kShininess = 5.0f;
-			RenderMesh(meshList[BUMPERCAR], true);
+			QueueMesh(meshList[BUMPERCAR], true, &carLods[1]);
 			modelStack.PopMatrix();
 
-			// ----- Render Player 2 Model -----
-			if (isCamera1)  // If current view IS camera1
+			modelStack.PushMatrix();
+			modelStack.Translate(camera2.position.x, 0.f, camera2.position.z);
+			modelStack.Scale(2.f, 2.f, 2.f);
+			modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
+			// Make the model face the direction camera2 is facing:
 			{
-				modelStack.PushMatrix();
-				modelStack.Translate(camera2.position.x, 0.5f, camera2.position.z);
-				modelStack.Scale(2, 2, 2);
-				modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-
-				// Make the model face the direction camera2 is facing:
-				{
-					glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
-				}
-
-				meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
-				RenderMesh(meshList[JEFFREYEPSTEIN], true);
-				modelStack.PopMatrix();
+				glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
+				float yaw = glm::degrees(atan2(pForward.z, pForward.x));
+				modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
 			}
+			meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
+			meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+			meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
+			meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
+			QueueMesh(meshList[JEFFREYEPSTEIN], true, &playerLods[1]);
+			modelStack.PopMatrix();
 		}
+		renderQueue.SetViews(RenderQueue::ALL_VIEWS);
+	}
+}
 
-		if (player1InCar)
-		{
-			// ----- Render Player 1 Model -----
-			if (!isCamera1)  // If current view is NOT camera1
-			{
-				modelStack.PushMatrix();
-				modelStack.Translate(camera1.position.x, 0.5f, camera1.position.z);
-				modelStack.Scale(3.f, 3.f, 3.f);
+// Draw the frame's draw list from one camera into the current viewport
+void Scene01::RenderSceneFromCamera(FPCamera& cam, int view)
+{
+	viewStack.LoadIdentity();
+	viewStack.LookAt(
+		cam.position.x, cam.position.y, cam.position.z,
+		cam.target.x, cam.target.y, cam.target.z,
+		cam.up.x, cam.up.y, cam.up.z
+	);
+	frustum.Extract(cam, projectionStack.Top());
 
-				// Make the model face the direction camera1 is facing:
-				{
-					glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
-					// Yaw in degrees from X axis
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					// Rotate the model around world Y so it faces the same horizontal direction
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
-				}
+	// Load identity matrix into the model stack
+	modelStack.LoadIdentity();
 
-				meshList[BUMPERCAR]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[BUMPERCAR]->material.kShininess = 5.0f;
-				RenderMesh(meshList[BUMPERCAR], true);
-				modelStack.PopMatrix();
-
-				modelStack.PushMatrix();
-				modelStack.Translate(camera1.position.x, 0.f, camera1.position.z);
-				modelStack.Scale(2.f, 2.f, 2.f);
-				modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-				// Make the model face the direction camera1 is facing:
-				{
-					glm::vec3 pForward = glm::normalize(camera1.target - camera1.position);
-					// Yaw in degrees from X axis
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					// Rotate the model around world Y so it faces the same horizontal direction
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
-				}
-				meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
-				RenderMesh(meshList[JEFFREYEPSTEIN], true);
-				modelStack.PopMatrix();
-			}
-		}
-		if (player2InCar)
+	UniformBlocks::GetInstance()->SetLights(light, NUM_LIGHTS, viewStack.Top());
+
+	// grass tiled from -100 to 100 on X and Z, keep existing scale (5,1,5)
+	modelStack.PushMatrix();
+	{
+		// spacing chosen to match the previous manual placement (50 units)
+		// the tiles never move, so their matrices are built once and drawn in one call
+		if (grassTiles.empty())
 		{
-			// ----- Render Player 2 Model -----
-			if (isCamera1)  // If current view IS camera1
+			const float start = -250.f;
+			const float end = 250.f;
+			const float step = 50.f;
+			for (float x = start; x <= end; x += step)
 			{
-				modelStack.PushMatrix();
-				modelStack.Translate(camera2.position.x, 0.5f, camera2.position.z);
-				modelStack.Scale(3.f, 3.f, 3.f);
-
-				// Make the model face the direction camera2 is facing:
-				{
-					glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
-				}
-
-				meshList[BUMPERCAR]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[BUMPERCAR]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[BUMPERCAR]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[BUMPERCAR]->material.kShininess = 5.0f;
-				RenderMesh(meshList[BUMPERCAR], true);
-				modelStack.PopMatrix();
-
-				modelStack.PushMatrix();
-				modelStack.Translate(camera2.position.x, 0.f, camera2.position.z);
-				modelStack.Scale(2.f, 2.f, 2.f);
-				modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-				// Make the model face the direction camera2 is facing:
+				for (float z = start; z <= end; z += step)
 				{
-					glm::vec3 pForward = glm::normalize(camera2.target - camera2.position);
-					float yaw = glm::degrees(atan2(pForward.z, pForward.x));
-					modelStack.Rotate(yaw, 0.f, -1.f, 0.f);
+					modelStack.PushMatrix();
+					modelStack.LoadIdentity();
+					modelStack.Translate(x, 0.f, z);
+					modelStack.Scale(5.f, 1.f, 5.f);
+					// keep original rotations so the tile faces the same way as before
+					modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
+					modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
+					grassTiles.push_back(modelStack.Top());
+					modelStack.PopMatrix();
 				}
-				meshList[JEFFREYEPSTEIN]->material.kAmbient = glm::vec3(1.f, 1.f, 1.f);
-				meshList[JEFFREYEPSTEIN]->material.kDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-				meshList[JEFFREYEPSTEIN]->material.kSpecular = glm::vec3(0.8f, 0.8f, 0.8f);
-				meshList[JEFFREYEPSTEIN]->material.kShininess = 5.0f;
-				RenderMesh(meshList[JEFFREYEPSTEIN], true);
-				modelStack.PopMatrix();
 			}
 		}
+		RenderMeshInstanced(meshList[GEO_GRASS], grassTiles, true);
+		// keep the ambient material tweak from original code
+		meshList[GEO_GRASS]->material.kAmbient = glm::vec3(0.3f, 0.3f, 0.3f);
 	}
+	modelStack.PopMatrix();
+
+	// Everything queued by BuildDrawList; draw it sorted by state
+	renderQueue.Replay(view, viewStack.Top(), projectionStack.Top());
 }
 
 
@@ -1016,10 +1051,7 @@ void Scene01::Render()
 		int height = 1600;
 		glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
 
-		// LEFT SCREEN
-		glViewport(0, 0, width / 2, height);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
+		// Both halves share one projection and one draw list; only the camera changes
 		projectionStack.LoadMatrix(
 			glm::perspective(
 				glm::radians(45.f),
@@ -1029,12 +1061,32 @@ void Scene01::Render()
 			)
 		);
 
-		RenderSceneFromCamera(camera1);
+		sceneTimer.startTimer();
+		BuildDrawList();
+		drawListCPUTime = drawListCPUTime * 0.9 + sceneTimer.getElapsedTime() * 1000.0 * 0.1;
+
+		// LEFT SCREEN
+		glViewport(0, 0, width / 2, height);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		sceneTimer.startTimer();
+		RenderSceneFromCamera(camera1, 0);
+		RecordViewStats(0, sceneTimer.getElapsedTime());
 
-		std::string temp("FPS:" + std::to_string(fps));
-		RenderTextOnScreen(meshList[GEO_TEXT], temp.substr(0, 9), glm::vec3(1, 1, 1), 25, 5, 45);
+		char line[32];
+		snprintf(line, sizeof(line), "FPS:%.2f", fps);
+		RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 45);
+		RenderViewStats(0);
+
+		unsigned loading = AssetStreamer::GetInstance()->GetPendingCount();
+		if (loading > 0)
+		{
+			snprintf(line, sizeof(line), "Loading %u", loading);
+			RenderTextOnScreen(meshList[GEO_TEXT], line, glm::vec3(1, 1, 1), 25, 5, 75);
+		}
 
 		RenderTextOnScreen(meshList[GEO_TEXT], "Z to open menu", glm::vec3(1, 1, 1), 25, 5, 15);
+		FlushTextOnScreen(meshList[GEO_TEXT]);
 
 		/*
 		modelStack.PushMatrix();
@@ -1046,16 +1098,13 @@ void Scene01::Render()
 		glViewport(width / 2, 0, width / 2, height);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		projectionStack.LoadMatrix(
-			glm::perspective(
-				glm::radians(45.f),
-				(float)(width / 2) / (float)height,
-				0.1f,
-				1000.f
-			)
-		);
+		sceneTimer.startTimer();
+		RenderSceneFromCamera(camera2, 1);
+		RecordViewStats(1, sceneTimer.getElapsedTime());
+		renderQueue.Clear();
 
-		RenderSceneFromCamera(camera2);
+		RenderViewStats(1);
+		FlushTextOnScreen(meshList[GEO_TEXT]);
 
 		// Render objects
 		//RenderMesh(meshList[GEO_AXES], false);
@@ -1068,24 +1117,62 @@ void Scene01::Render()
 	}
 }
 
+// Smooth the view's CPU time and take its queue counters, then start the next view from zero
+void Scene01::RecordViewStats(int view, double cpuTime)
+{
+	viewCPUTime[view] = viewCPUTime[view] * 0.9 + cpuTime * 1000.0 * 0.1;
+
+	viewStats[view] = renderQueue.GetStats();
+	viewStats[view].submitted += tilesSubmitted;
+	viewStats[view].culled += tilesCulled;
+	renderQueue.ResetStats();
+	tilesSubmitted = 0;
+	tilesCulled = 0;
+}
+
+// Defers the draw to renderQueue, placed at modelStack.Top(). Placements that
+// pass a LodState keep their detail level steady between frames
+void Scene01::QueueMesh(Mesh* mesh, bool enableLight, LodState* lod)
+{
+	renderQueue.Submit(mesh, modelStack.Top(), enableLight, lod);
+}
+
 void Scene01::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	glm::mat4 MVP, modelView, modelView_inverse_transpose;
+	SetMeshUniforms(mesh, enableLight);
+	mesh->Render();   // only once
+}
+
+// Draws one copy of mesh per model matrix, placed relative to modelStack.Top().
+// Copies outside the frustum are left out of the instance buffer
+void Scene01::RenderMeshInstanced(Mesh* mesh, const std::vector<glm::mat4>& models, bool enableLight)
+{
+	visibleTiles.clear();
+	const glm::mat4& parent = modelStack.Top();
+	for (const glm::mat4& model : models)
+	{
+		if (frustum.Intersects(mesh->bounds, parent * model))
+			visibleTiles.push_back(model);
+	}
+	tilesSubmitted += models.size();
+	tilesCulled += models.size() - visibleTiles.size();
+
+	if (visibleTiles.empty())
+		return;
+	SetMeshUniforms(mesh, enableLight);
+	mesh->RenderInstanced(&visibleTiles[0], static_cast<unsigned>(visibleTiles.size()));
+}
 
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, glm::value_ptr(modelView));
+void Scene01::SetMeshUniforms(Mesh* mesh, bool enableLight)
+{
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
 
 	if (enableLight) {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = glm::inverseTranspose(modelView);
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
-
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
+		glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(viewStack.Top() * modelStack.Top()));
+		glUniformMatrix3fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+		UniformBlocks::GetInstance()->SetMaterial(mesh->material);
 	}
 	else {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
@@ -1100,8 +1187,6 @@ void Scene01::RenderMesh(Mesh* mesh, bool enableLight)
 	else {
 		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
 	}
-
-	mesh->Render();   // only once
 }
 
 void Scene01::ResolveCameraCollisionsWithBounce(FPCamera& a, glm::vec3& velA, FPCamera& b, glm::vec3& velB, double dt)
@@ -1175,14 +1260,16 @@ void Scene01::ResolveCameraCollisionsWithBounce(FPCamera& a, glm::vec3& velA, FP
 
 void Scene01::Exit()
 {
+	staticWorld.Clear();
 	// Cleanup VBO here
 	for (int i = 0; i < NUM_GEOMETRY; ++i)
 	{
 		if (meshList[i])
 		{
-			delete meshList[i];
+			AssetCache::GetInstance()->ReleaseMesh(meshList[i]);
 		}
 	}
+	delete textRenderer;
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 	glDeleteProgram(m_programID);
 }
@@ -1226,7 +1313,6 @@ void Scene01::HandleKeyPress1(FPCamera& cam, double dt)
 			light[0].power = 1.f;
 		else
 			light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -1240,8 +1326,6 @@ void Scene01::HandleKeyPress1(FPCamera& cam, double dt)
 		else {
 			light[0].type = Light::LIGHT_POINT;
 		}
-
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	};
 
 	glm::vec3* pVel = (&cam == &camera1) ? &cameraVelocity1 : &cameraVelocity2;
@@ -1381,7 +1465,6 @@ void Scene01::HandleKeyPress2(FPCamera& cam, double dt)
 	{
 		if (light[0].power <= 0.1f) light[0].power = 1.f;
 		else light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -1389,7 +1472,6 @@ void Scene01::HandleKeyPress2(FPCamera& cam, double dt)
 		if (light[0].type == Light::LIGHT_POINT) light[0].type = Light::LIGHT_DIRECTIONAL;
 		else if (light[0].type == Light::LIGHT_DIRECTIONAL) light[0].type = Light::LIGHT_SPOT;
 		else light[0].type = Light::LIGHT_POINT;
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	}
 
 	if (!player2InCar)
@@ -5,10 +5,15 @@
 
 #include "Scene.h"
 #include "Mesh.h"
+#include "TextRenderer.h"
 #include "AltAzCamera.h"
 #include "MatrixStack.h"
 #include "Light.h"
 #include "FPCamera.h"
+#include "timer.h"
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "StaticBatch.h"
 
 struct Player
 {
@@ -63,25 +68,8 @@ public:
 
 	enum UNIFORM_TYPE
 	{
-		U_MVP = 0,
-		U_MODELVIEW,
+		U_MODEL = 0,
 		U_MODELVIEW_INVERSE_TRANSPOSE,
-		U_MATERIAL_AMBIENT,
-		U_MATERIAL_DIFFUSE,
-		U_MATERIAL_SPECULAR,
-		U_MATERIAL_SHININESS,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
 		U_COLOR_TEXTURE,
 		U_LIGHTENABLED,
@@ -93,6 +81,7 @@ public:
 		U_FOG_START,
 		U_FOG_END,
 		U_FOG_COLOR,
+		U_INSTANCED,
 
 		U_TOTAL,
 	};
@@ -109,9 +98,14 @@ private:
 	void HandleKeyPress1(FPCamera& cam, double dt);
 	void HandleKeyPress2(FPCamera& cam, double dt);
 	void RenderMesh(Mesh* mesh, bool enableLight);
+	void QueueMesh(Mesh* mesh, bool enableLight, LodState* lod = nullptr);
+	void RenderMeshInstanced(Mesh* mesh, const std::vector<glm::mat4>& models, bool enableLight);
+	void SetMeshUniforms(Mesh* mesh, bool enableLight);
+	void RecordViewStats(int view, double cpuTime);
 
 	unsigned m_vertexArrayID;
 	Mesh* meshList[NUM_GEOMETRY];
+	TextRenderer* textRenderer;
 
 	unsigned m_programID;
 	unsigned m_parameters[U_TOTAL];
@@ -129,16 +123,25 @@ private:
 	bool enableLight;
 
 	void RenderSkybox();
-	void RenderSceneFromCamera(FPCamera& cam);
+	void BuildDrawList();
+	void RenderSceneFromCamera(FPCamera& cam, int view);
 
 	void RenderMeshOnScreen(Mesh* mesh, float x, float y, float sizex, float sizey);
 
 	void HandleMouseInput(FPCamera& cam);
 
 	void RenderText(Mesh* mesh, std::string text, glm::vec3 color);
-	void RenderTextOnScreen(Mesh* mesh, std::string text, glm::vec3 color, float size, float x, float y);
+	void RenderTextOnScreen(Mesh* mesh, const char* text, glm::vec3 color, float size, float x, float y);
+	void FlushTextOnScreen(Mesh* mesh);
+	void RenderViewStats(int view);
 
-	void RenderPathway();
+	void BuildPathway();
+	void BuildStaticWorld();
+	void RenderStaticWorld();
+
+	// Model matrices of the grass tiles, drawn with one instanced call
+	std::vector<glm::mat4> grassTiles;
+	std::vector<glm::mat4> visibleTiles;	// scratch for RenderMeshInstanced
 
 	glm::vec3 change;
 
@@ -155,6 +158,28 @@ private:
 
 	float fps = 0;
 
+	// CPU time spent in BuildDrawList once and in RenderSceneFromCamera by each camera, smoothed
+	StopWatch sceneTimer;
+	double drawListCPUTime = 0.0; // milliseconds per frame
+	double viewCPUTime[2] = { 0.0, 0.0 };
+
+	// World draws of the frame, queued once and replayed by each view
+	RenderQueue renderQueue;
+	// Frustum of the camera being rendered; the queue and the tiles are culled against it
+	Frustum frustum;
+	// Queue counters of each view, with the instanced tiles added to submitted/culled
+	RenderQueue::Stats viewStats[2] = { RenderQueue::Stats(), RenderQueue::Stats() };
+	unsigned tilesSubmitted = 0;
+	unsigned tilesCulled = 0;
+
+	// Detail level each moving placement was last drawn at, per view
+	LodState statueLod;
+	LodState carLods[2];
+	LodState playerLods[2];
+
+	// Forest, houses, tall tree and path tiles, merged once in world space
+	StaticBatch staticWorld;
+
 	// Physics / bumper-car properties
 	glm::vec3 cameraVelocity1 = glm::vec3(0.0f);
 	glm::vec3 cameraVelocity2 = glm::vec3(0.0f);
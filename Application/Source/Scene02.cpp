@@ -1,6 +1,7 @@
 // Jayren's Scene
 
 #include "Scene02.h"
+#include "UniformBlocks.h"
 #include "Mesh.h"
 #include "GL\glew.h"
 
@@ -16,14 +17,21 @@
 #include "shader.hpp"
 #include "Application.h"
 #include "MeshBuilder.h"
+#include "AssetCache.h"
 #include "KeyboardController.h"
 #include "LoadTGA.h"
 #include "MouseController.h"
 #include <iostream>
+#include <algorithm>
 
 // repo cloning text test
 
+// Boxes a projectile may bounce off within one physics step
+static const int MAX_IMPACTS = 4;
+
 Scene02::Scene02()
+	: broadPhase(5.f)
+	, pairsTested(0)
 {
 }
 
@@ -54,32 +62,16 @@ void Scene02::Init()
 	//m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Texture.fragmentshader");
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
 	glUseProgram(m_programID);
+	UniformBlocks::GetInstance()->BindProgram(m_programID);
 
-	// Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
+	// Get a handle for our "model" uniform
+	m_parameters[U_MODEL] = glGetUniformLocation(m_programID, "model");
 	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
 	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
 	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
 	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
 
-	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT], m_parameters[U_MATERIAL_DIFFUSE], m_parameters[U_MATERIAL_SPECULAR], m_parameters[U_MATERIAL_SHININESS]);
+	Mesh::SetTextureLoc(m_parameters[U_COLOR_TEXTURE_ENABLED]);
 
 	// Initialise camera properties
 	//camera.Init(45.f, 45.f, 10.f);
@@ -111,22 +103,22 @@ void Scene02::Init()
 
 	//SKYBOX
 	meshList[GEO_LEFT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_LEFT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Left.tga");
+	meshList[GEO_LEFT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Left.tga");
 
 	meshList[GEO_RIGHT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_RIGHT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Right.tga");
+	meshList[GEO_RIGHT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Right.tga");
 
 	meshList[GEO_BACK] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BACK]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Back.tga");
+	meshList[GEO_BACK]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Back.tga");
 
 	meshList[GEO_FRONT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_FRONT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Front.tga");
+	meshList[GEO_FRONT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Front.tga");
 
 	meshList[GEO_TOP] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_TOP]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Top.tga");
+	meshList[GEO_TOP]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Top.tga");
 
 	meshList[GEO_BOTTOM] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Bottom.tga");
+	meshList[GEO_BOTTOM]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Bottom.tga");
 
 	//meshList[GEO_QUAD]->textureID = LoadTGA("Images//NYP.tga");
 	meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
@@ -134,7 +126,7 @@ void Scene02::Init()
 	meshList[GEO_CYLINDER] = MeshBuilder::GenerateCylinder("Cylinder", glm::vec3(1.f, 1.f, 1.f), 36, 1.f, 2.f);
 
 	meshList[GEO_GRASS] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
-	meshList[GEO_GRASS]->textureID = LoadTGA("Images//coast_sand_rocks_02 copy.tga");
+	meshList[GEO_GRASS]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga");
 
 	meshList[GEO_WALL] = MeshBuilder::GenerateCube("Wall", glm::vec3(1.f, 1.f, 1.f), 1.f);
 
@@ -143,20 +135,18 @@ void Scene02::Init()
 
 	// 16 x 16 is the number of columns and rows for the text
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
-	meshList[GEO_TEXT]->textureID = LoadTGA("Images//Georgia.tga");
+	meshList[GEO_TEXT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//Georgia.tga");
+	textRenderer = new TextRenderer("Images//Georgia.tga", 16, 16);
 
 	meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_GUI]->textureID = LoadTGA("Images//blackblack.tga");
+	meshList[GEO_GUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//blackblack.tga");
 
-	meshList[GEO_BLASTER] = MeshBuilder::GenerateOBJMTL("Blaster", "Models//Blaster.obj", "Models//Blaster.mtl");
-	meshList[GEO_BLASTER]->textureID = LoadTGA("Images//Blaster.tga");
+	meshList[GEO_BLASTER] = AssetCache::GetInstance()->AcquireOBJMTL("Blaster", "Models//Blaster.obj", "Models//Blaster.mtl", "Images//Blaster.tga");
 
 	glm::mat4 projection = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 1000.0f);
 	projectionStack.LoadMatrix(projection);
 
 
-	glUniform1i(m_parameters[U_NUMLIGHTS], NUM_LIGHTS);
-
 	light[0].position = glm::vec3(camera.position.x, camera.position.y, camera.position.z);
 	light[0].color = glm::vec3(1, 1, 0.5);
 	light[0].type = Light::LIGHT_POINT;
@@ -169,16 +159,6 @@ void Scene02::Init()
 	light[0].exponent = 3.f;
 	light[0].spotDirection = glm::vec3(0.f, 1.f, 0.f);
 
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], cosf(glm::radians<float>(light[0].cosCutoff)));
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], cosf(glm::radians<float>(light[0].cosInner)));
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-
 	enableLight = true;
 	enableHitbox = false;
 	wasMousePressed = false;
@@ -283,6 +263,7 @@ void Scene02::HandleMouseInput(double dt)
 			+ forward * 2.5f
 			+ right * 1.0f
 			- up * 1.f;
+		ball.prevPos = ball.pos;
 
 		ball.vel = forward * 100.f;
 
@@ -290,6 +271,7 @@ void Scene02::HandleMouseInput(double dt)
 		ball.mass = 1.f;
 
 		projectiles.push_back(ball);
+		projectileHandles.push_back(projectileWorld.Add(ball));
 
 		blasterAngle = 0.f;
 
@@ -364,36 +346,98 @@ void Scene02::Update(double dt)
 
 	HandleMouseInput(dt);
 
-	for (int i = 0; i < projectiles.size(); i++) {
-		PhysicsObject& ball = projectiles[i];
-
-		for (int j = 0; j < walls.size(); j++) {
-			PhysicsObject& wall = walls[j];
-			CollisionData cd;
-			if (OverlapSphere2AABB(ball, wall, cd))
+	if (blasterAnimating == true)
+	{
+		if (blasterMovingUp)
+		{
+			if (blasterAngle < 15.f)
 			{
-				ResolveCollision(cd);
+				blasterAngle += 100.f * dt;
+			}
+			else {
+				blasterAngle = 15.f;
+				blasterMovingUp = false;
 			}
 		}
 
-		for (int j = 0; j < targets.size(); j++) {
-			CollisionData cd;
-			if (OverlapSphere2AABB(ball, *targets[j], cd))
+		else {
+			if (blasterAngle > 0.f)
 			{
-				if (targets[j]->OnHit())
+				blasterAngle -= 100.f * dt;
+			}
+			else {
+				blasterAngle = 0.f;
+				blasterAnimating = false;
+			}
+		}
+	}
+}
+
+void Scene02::FixedUpdate(double dt)
+{
+	broadPhase.Clear();
+	for (int j = 0; j < walls.size(); j++)
+		broadPhase.Insert(walls[j]);
+	for (int j = 0; j < targets.size(); j++)
+		broadPhase.Insert(*targets[j]);
+	const unsigned firstTarget = static_cast<unsigned>(walls.size());
+	pairsTested = 0;
+
+	projectileWorld.Step(static_cast<float>(dt));
+
+	for (int i = 0; i < projectiles.size(); i++) {
+		PhysicsObject& ball = projectiles[i];
+
+		ball.BeginStep();
+		projectileWorld.CopyTo(projectileHandles[i], ball);
+
+		// Sweep the ball along its step and stop it at the first box in the way,
+		// then carry on from there with the bounced velocity, so fast shots cannot
+		// pass through walls or targets between two steps
+		glm::vec3 from = ball.prevPos;
+		float remaining = static_cast<float>(dt);
+		glm::vec3 reach(ball.sizeX * 0.5f);
+		for (int impact = 0; impact < MAX_IMPACTS; ++impact) {
+			// Only boxes sharing a cell with the swept path are tested; walls win ties as before
+			candidates.clear();
+			broadPhase.Query(glm::min(from, ball.pos) - reach, glm::max(from, ball.pos) + reach, candidates);
+			std::sort(candidates.begin(), candidates.end());
+			pairsTested += static_cast<unsigned>(candidates.size());
+
+			CollisionData first;
+			float firstToi = 2.f;
+			unsigned firstHandle = 0;
+			for (unsigned handle : candidates) {
+				PhysicsObject& box = handle < firstTarget ? walls[handle] : *targets[handle - firstTarget];
+				CollisionData cd;
+				float toi;
+				if (SweepSphere2AABB(ball, from, box, cd, toi) && toi < firstToi) {
+					first = cd;
+					firstToi = toi;
+					firstHandle = handle;
+				}
+			}
+			if (firstToi > 1.f)
+				break;
+
+			if (firstHandle >= firstTarget) {
+				DuckTarget* target = targets[firstHandle - firstTarget];
+				if (target->OnHit())
 				{
-					int points = targets[j]->GetScoreValue();
+					int points = target->GetScoreValue();
 					score += points;
 				}
-				ResolveCollision(cd);
 			}
+			from = ResolveSweptCollision(first, from, firstToi, remaining);
 		}
-
-
-		ball.UpdatePhysics(dt);
+		// Bounces happen here, so the world steps on from where the sweep left the ball
+		projectileWorld.SetPosition(projectileHandles[i], ball.pos);
+		projectileWorld.SetVelocity(projectileHandles[i], ball.vel);
 
 		if (ball.pos.y < -10.f)
 		{
+			projectileWorld.Remove(projectileHandles[i]);
+			projectileHandles.erase(projectileHandles.begin() + i);
 			projectiles.erase(projectiles.begin() + i);
 			i--;
 		}
@@ -411,32 +455,6 @@ void Scene02::Update(double dt)
 			i--;
 		}
 	}
-
-	if (blasterAnimating == true)
-	{
-		if (blasterMovingUp)
-		{
-			if (blasterAngle < 15.f)
-			{
-				blasterAngle += 100.f * dt;
-			}
-			else {
-				blasterAngle = 15.f;
-				blasterMovingUp = false;
-			}
-		}
-
-		else {
-			if (blasterAngle > 0.f)
-			{
-				blasterAngle -= 100.f * dt;
-			}
-			else {
-				blasterAngle = 0.f;
-				blasterAnimating = false;
-			}
-		}
-	}
 }
 
 void Scene02::RenderSkybox() {
@@ -536,16 +554,11 @@ void Scene02::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(
-			glm::mat4(1.f),
-			glm::vec3(i * 1.f, 0, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	// Centred on the origin like the old one-quad-per-character layout
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, -0.5f, -0.4f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
@@ -584,13 +597,10 @@ void Scene02::RenderTextOnScreen(Mesh* mesh, std::string text, glm::vec3 color,
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(glm::mat4(1.f), glm::vec3(0.5f + i * 0.6f, 0.4f, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, 0.f, 0.f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -625,24 +635,7 @@ void Scene02::Render()
 	// Load identity matrix into the model stack
 	modelStack.LoadIdentity();
 
-	if (light[0].type == Light::LIGHT_DIRECTIONAL)
-	{
-		glm::vec3 lightDir(light[0].position.x, light[0].position.y, light[0].position.z);
-		glm::vec3 lightDirection_cameraspace = viewStack.Top() * glm::vec4(lightDir, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightDirection_cameraspace));
-	}
-	else if (light[0].type == Light::LIGHT_SPOT)
-	{
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-		glm::vec3 spotDirection_cameraspace = viewStack.Top() * glm::vec4(light[0].spotDirection, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, glm::value_ptr(spotDirection_cameraspace));
-	}
-	else {
-		// Calculate the light position in camera space
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-	}
+	UniformBlocks::GetInstance()->SetLights(light, NUM_LIGHTS, viewStack.Top());
 
 	// Render objects
 	//RenderMesh(meshList[GEO_AXES], false);
@@ -731,8 +724,9 @@ void Scene02::Render()
 	// Render Projectiles
 	for (int i=0;i<projectiles.size();i++) {
 		PhysicsObject& ball = projectiles[i];
+		glm::vec3 pos = ball.GetInterpolatedPos(interpolation);
 		modelStack.PushMatrix();
-		modelStack.Translate(ball.pos.x, ball.pos.y, ball.pos.z);
+		modelStack.Translate(pos.x, pos.y, pos.z);
 		modelStack.Scale(ball.sizeX, ball.sizeY, ball.sizeZ);
 		RenderMesh(meshList[GEO_SPHERE], true);
 		modelStack.PopMatrix();
@@ -754,8 +748,9 @@ void Scene02::Render()
 	// Render Targets
 	for (int i = 0; i < targets.size(); i++) {
 		DuckTarget* target = targets[i];
+		glm::vec3 pos = target->GetInterpolatedPos(interpolation);
 		modelStack.PushMatrix();
-		modelStack.Translate(target->pos.x, target->pos.y, target->pos.z);
+		modelStack.Translate(pos.x, pos.y, pos.z);
 		modelStack.Scale(target->sizeX, target->sizeY, target->sizeZ);
 		meshList[GEO_WALL]->material.kAmbient = glm::vec3(1.f, 1.f, 0.f);
 		if (targets[i]->GetScoreValue() < 0)
@@ -777,26 +772,24 @@ void Scene02::Render()
 		std::string temp("Score:" + std::to_string(score));
 		RenderTextOnScreen(meshList[GEO_TEXT], temp.substr(0, 9), glm::vec3(1, 0, 0), 20, 0, 540);
 	}
+
+	// BROAD PHASE
+	{
+		std::string temp("Balls:" + std::to_string(projectiles.size()) + " Pairs:" + std::to_string(pairsTested));
+		RenderTextOnScreen(meshList[GEO_TEXT], temp, glm::vec3(1, 1, 1), 20, 0, 500);
+	}
 }
 
 void Scene02::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	glm::mat4 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, glm::value_ptr(modelView));
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
 
 	if (enableLight) {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = glm::inverseTranspose(modelView);
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
-
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
+		glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(viewStack.Top() * modelStack.Top()));
+		glUniformMatrix3fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+		UniformBlocks::GetInstance()->SetMaterial(mesh->material);
 	}
 	else {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
@@ -823,9 +816,10 @@ void Scene02::Exit()
 	{
 		if (meshList[i])
 		{
-			delete meshList[i];
+			AssetCache::GetInstance()->ReleaseMesh(meshList[i]);
 		}
 	}
+	delete textRenderer;
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 	glDeleteProgram(m_programID);
 }
@@ -869,7 +863,6 @@ void Scene02::HandleKeyPress(double dt)
 			light[0].power = 1.f;
 		else
 			light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -883,8 +876,6 @@ void Scene02::HandleKeyPress(double dt)
 		else {
 			light[0].type = Light::LIGHT_POINT;
 		}
-
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	};
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_H))
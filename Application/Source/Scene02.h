@@ -5,12 +5,15 @@
 
 #include "Scene.h"
 #include "Mesh.h"
+#include "TextRenderer.h"
 #include "AltAzCamera.h"
 #include "MatrixStack.h"
 #include "Light.h"
 #include "FPCamera.h"
 #include "PhysicsObject.h"
+#include "PhysicsWorld.h"
 #include "DuckTarget.h"
+#include "SpatialHash.h"
 #include <vector>
 
 class Scene02 : public Scene
@@ -42,25 +45,8 @@ public:
 
 	enum UNIFORM_TYPE
 	{
-		U_MVP = 0,
-		U_MODELVIEW,
+		U_MODEL = 0,
 		U_MODELVIEW_INVERSE_TRANSPOSE,
-		U_MATERIAL_AMBIENT,
-		U_MATERIAL_DIFFUSE,
-		U_MATERIAL_SPECULAR,
-		U_MATERIAL_SHININESS,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
 		U_COLOR_TEXTURE,
 		U_LIGHTENABLED,
@@ -81,6 +67,7 @@ public:
 
 	virtual void Init();
 	virtual void Update(double dt);
+	virtual void FixedUpdate(double dt);
 	virtual void Render();
 	virtual void Exit();
 
@@ -101,6 +88,7 @@ private:
 
 	unsigned m_vertexArrayID;
 	Mesh* meshList[NUM_GEOMETRY];
+	TextRenderer* textRenderer;
 
 	unsigned m_programID;
 	unsigned m_parameters[U_TOTAL];
@@ -126,10 +114,19 @@ private:
 	float moveSpeed = 5.0f;
 
 	// Objects
+	// Sizes and the swept collision state stay in projectiles; projectileWorld
+	// integrates them, one handle per projectile at the same index
 	std::vector<PhysicsObject> projectiles;
+	std::vector<PhysicsWorld::Handle> projectileHandles;
+	PhysicsWorld projectileWorld;
 	std::vector<PhysicsObject> walls;
 	std::vector<DuckTarget*> targets;
 
+	// Walls then targets, rebuilt every step as the targets move
+	SpatialHash broadPhase;
+	std::vector<unsigned> candidates;
+	unsigned pairsTested; // narrow-phase tests in the last FixedUpdate
+
 	bool enableHitbox;
 	float fps;
 	bool wasMousePressed;
@@ -1,6 +1,7 @@
 //Alvin
 
 #include "Scene03.h"
+#include "UniformBlocks.h"
 #include "Mesh.h"
 #include "GL\glew.h"
 
@@ -16,6 +17,7 @@
 #include "shader.hpp"
 #include "Application.h"
 #include "MeshBuilder.h"
+#include "AssetCache.h"
 #include "KeyboardController.h"
 #include "LoadTGA.h"
 #include "MouseController.h"
@@ -53,32 +55,16 @@ void Scene03::Init()
 	//m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Texture.fragmentshader");
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
 	glUseProgram(m_programID);
+	UniformBlocks::GetInstance()->BindProgram(m_programID);
 
-	// Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
+	// Get a handle for our "model" uniform
+	m_parameters[U_MODEL] = glGetUniformLocation(m_programID, "model");
 	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
 	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
 	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
 	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
 
-	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT], m_parameters[U_MATERIAL_DIFFUSE], m_parameters[U_MATERIAL_SPECULAR], m_parameters[U_MATERIAL_SHININESS]);
+	Mesh::SetTextureLoc(m_parameters[U_COLOR_TEXTURE_ENABLED]);
 
 	// Initialise camera properties
 	//camera.Init(45.f, 45.f, 10.f);
@@ -110,22 +96,22 @@ void Scene03::Init()
 
 	//SKYBOX
 	meshList[GEO_LEFT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_LEFT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Left.tga");
+	meshList[GEO_LEFT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Left.tga");
 
 	meshList[GEO_RIGHT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_RIGHT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Right.tga");
+	meshList[GEO_RIGHT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Right.tga");
 
 	meshList[GEO_BACK] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BACK]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Back.tga");
+	meshList[GEO_BACK]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Back.tga");
 
 	meshList[GEO_FRONT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_FRONT]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Front.tga");
+	meshList[GEO_FRONT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Front.tga");
 
 	meshList[GEO_TOP] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_TOP]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Top.tga");
+	meshList[GEO_TOP]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Top.tga");
 
 	meshList[GEO_BOTTOM] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//AlvinSkybox//AlvinSkybox_Bottom.tga");
+	meshList[GEO_BOTTOM]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//AlvinSkybox//AlvinSkybox_Bottom.tga");
 	//SKYBOX
 
 	meshList[GEO_QUAD] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
@@ -133,20 +119,19 @@ void Scene03::Init()
 	meshList[GEO_CYLINDER] = MeshBuilder::GenerateCylinder("Cylinder", glm::vec3(1.f, 1.f, 1.f), 36, 1.f, 2.f);
 
 	meshList[GEO_GRASS] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
-	meshList[GEO_GRASS]->textureID = LoadTGA("Images//coast_sand_rocks_02 copy.tga");
+	meshList[GEO_GRASS]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga");
 
 	// 16 x 16 is the number of columns and rows for the text
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
-	meshList[GEO_TEXT]->textureID = LoadTGA("Images//Georgia.tga");
+	meshList[GEO_TEXT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//Georgia.tga");
+	textRenderer = new TextRenderer("Images//Georgia.tga", 16, 16);
 
 	meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_GUI]->textureID = LoadTGA("Images//blackblack.tga");
+	meshList[GEO_GUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//blackblack.tga");
 
-	meshList[GEO_BASKETBALL] = MeshBuilder::GenerateOBJMTL("Basketball", "Models//basketball.obj", "Models//basketball.mtl");
-	meshList[GEO_BASKETBALL]->textureID = LoadTGA("Images//basketball.tga");
+	meshList[GEO_BASKETBALL] = AssetCache::GetInstance()->AcquireOBJMTL("Basketball", "Models//basketball.obj", "Models//basketball.mtl", "Images//basketball.tga");
 
-	meshList[GEO_HOOP] = MeshBuilder::GenerateOBJMTL("hoop", "Models//hoop.obj", "Models//hoop.mtl");
-	meshList[GEO_HOOP]->textureID = LoadTGA("Images//hoop.tga");
+	meshList[GEO_HOOP] = AssetCache::GetInstance()->AcquireOBJMTL("hoop", "Models//hoop.obj", "Models//hoop.mtl", "Images//hoop.tga");
 
 	meshList[GEO_TORUS] = MeshBuilder::GenerateTorus("Torus", glm::vec3(1, 1, 1), 0.08, 1.1);
 
@@ -154,8 +139,6 @@ void Scene03::Init()
 	projectionStack.LoadMatrix(projection);
 
 
-	glUniform1i(m_parameters[U_NUMLIGHTS], NUM_LIGHTS);
-
 	light[0].position = glm::vec3(camera.position.x, camera.position.y, camera.position.z);
 	light[0].color = glm::vec3(1, 1, 0.5);
 	light[0].type = Light::LIGHT_POINT;
@@ -168,16 +151,6 @@ void Scene03::Init()
 	light[0].exponent = 3.f;
 	light[0].spotDirection = glm::vec3(0.f, 1.f, 0.f);
 
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], cosf(glm::radians<float>(light[0].cosCutoff)));
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], cosf(glm::radians<float>(light[0].cosInner)));
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-
 	enableLight = true;
 
 	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
@@ -333,6 +306,7 @@ void Scene03::Update(double dt)
 		glm::vec3 forward = glm::normalize(camera.target - camera.position);
 
 		newBall.pos = camera.position + forward * 2.0f; // spawn in front
+		newBall.prevPos = newBall.pos;
 
 		float throwForce = 25.f;     // adjust strength
 		float upwardForce = 14.f;    // small arc
@@ -349,8 +323,33 @@ void Scene03::Update(double dt)
 
 	mousePreviouslyDown = mouseCurrentlyDown;
 
+	float temp = 1.f / dt;
+	fps = glm::round(temp * 100.f) / 100.f;
+
+	// Move hoop left/right
+	hoopPosition.x += hoopDirection * hoopSpeed * static_cast<float>(dt);
+
+	// Update rim position to follow hoop
+	rimPosition = hoopPosition + glm::vec3(0.f, 6.37f, 3.2f);
+
+	// Reverse direction when reaching limit
+	if (hoopPosition.x > hoopLimit)
+	{
+		hoopPosition.x = hoopLimit;
+		hoopDirection = -1;
+	}
+	else if (hoopPosition.x < -hoopLimit)
+	{
+		hoopPosition.x = -hoopLimit;
+		hoopDirection = 1;
+	}
+}
+
+void Scene03::FixedUpdate(double dt)
+{
+	const float damping = PhysicsObject::GetDampingFactor(static_cast<float>(dt));
 	for (auto& ball : balls) {
-		ball.UpdatePhysics(dt);
+		ball.UpdatePhysics(dt, damping);
 		if (ball.pos.y <= 0.4f)
 		{
 			ball.pos.y = 0.4f;
@@ -392,22 +391,23 @@ void Scene03::Update(double dt)
 		float boardMaxY = hoopPosition.y + 8.5f;
 		float boardZ = hoopPosition.z + 2.3f;
 
-		// Check collision
-		if (ball.pos.x >= boardMinX &&
-			ball.pos.x <= boardMaxX &&
-			ball.pos.y >= boardMinY &&
-			ball.pos.y <= boardMaxY)
+		// Check collision along the whole step, so a fast throw cannot cross the board between two steps
+		glm::vec3 boardMin(boardMinX, boardMinY, boardZ);
+		glm::vec3 boardMax(boardMaxX, boardMaxY, boardZ);
+		float toi;
+		glm::vec3 normal;
+		if (SweepSphere2AABB(ball.prevPos, ball.pos, ballRadius, boardMin, boardMax, toi, normal))
 		{
-			// Check crossing from either side
-			if (abs(ball.pos.z - boardZ) <= ballRadius)
-			{
-				float direction = (ball.pos.z > boardZ) ? 1.f : -1.f;
-
-				ball.pos.z = boardZ + direction * ballRadius;
-
-				ball.vel.z = -ball.vel.z * 0.4f;
-			}
-
+			// Keep 40% of the speed into the board, bounced back
+			float into = glm::dot(ball.vel, normal);
+			if (into < 0.f)
+				ball.vel -= normal * (into * 1.4f);
+
+			// Rest against the board where it hit, then move on for what is left of the step
+			glm::vec3 contact = ball.prevPos + (ball.pos - ball.prevPos) * toi;
+			ball.impactPos = glm::clamp(contact, boardMin, boardMax) + normal * (ballRadius + SWEEP_SKIN);
+			ball.impactAlpha = toi;
+			ball.pos = ball.impactPos + ball.vel * (static_cast<float>(dt) * (1.f - toi));
 		}
 
 		glm::vec3 toBall = ball.pos - rimPosition;
@@ -443,27 +443,6 @@ void Scene03::Update(double dt)
 			}
 		}
 	}
-
-	float temp = 1.f / dt;
-	fps = glm::round(temp * 100.f) / 100.f;
-
-	// Move hoop left/right
-	hoopPosition.x += hoopDirection * hoopSpeed * static_cast<float>(dt);
-
-	// Update rim position to follow hoop
-	rimPosition = hoopPosition + glm::vec3(0.f, 6.37f, 3.2f);
-
-	// Reverse direction when reaching limit
-	if (hoopPosition.x > hoopLimit)
-	{
-		hoopPosition.x = hoopLimit;
-		hoopDirection = -1;
-	}
-	else if (hoopPosition.x < -hoopLimit)
-	{
-		hoopPosition.x = -hoopLimit;
-		hoopDirection = 1;
-	}
 }
 
 void Scene03::RenderSkybox() {
@@ -563,16 +542,11 @@ void Scene03::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(
-			glm::mat4(1.f),
-			glm::vec3(i * 1.f, 0, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	// Centred on the origin like the old one-quad-per-character layout
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, -0.5f, -0.4f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
@@ -612,13 +586,10 @@ void Scene03::RenderTextOnScreen(Mesh* mesh, std::string
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(glm::mat4(1.f), glm::vec3(0.5f + i * 0.6f, 0.4f, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, 0.f, 0.f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -652,24 +623,7 @@ void Scene03::Render()
 	// Load identity matrix into the model stack
 	modelStack.LoadIdentity();
 
-	if (light[0].type == Light::LIGHT_DIRECTIONAL)
-	{
-		glm::vec3 lightDir(light[0].position.x, light[0].position.y, light[0].position.z);
-		glm::vec3 lightDirection_cameraspace = viewStack.Top() * glm::vec4(lightDir, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightDirection_cameraspace));
-	}
-	else if (light[0].type == Light::LIGHT_SPOT)
-	{
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-		glm::vec3 spotDirection_cameraspace = viewStack.Top() * glm::vec4(light[0].spotDirection, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, glm::value_ptr(spotDirection_cameraspace));
-	}
-	else {
-		// Calculate the light position in camera space
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-	}
+	UniformBlocks::GetInstance()->SetLights(light, NUM_LIGHTS, viewStack.Top());
 
 	// Render objects
 	//RenderMesh(meshList[GEO_AXES], false);
@@ -702,8 +656,9 @@ void Scene03::Render()
 
 	for (auto& ball : balls)
 	{
+		glm::vec3 pos = ball.GetInterpolatedPos(interpolation);
 		modelStack.PushMatrix();
-		modelStack.Translate(ball.pos.x, ball.pos.y, ball.pos.z);
+		modelStack.Translate(pos.x, pos.y, pos.z);
 		modelStack.Scale(0.008f, 0.008f, 0.008f);
 		RenderMesh(meshList[GEO_BASKETBALL], false);
 		modelStack.PopMatrix();
@@ -762,22 +717,14 @@ void Scene03::Render()
 
 void Scene03::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	glm::mat4 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, glm::value_ptr(modelView));
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
 
 	if (enableLight) {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = glm::inverseTranspose(modelView);
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
-
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
+		glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(viewStack.Top() * modelStack.Top()));
+		glUniformMatrix3fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+		UniformBlocks::GetInstance()->SetMaterial(mesh->material);
 	}
 	else {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
@@ -804,9 +751,10 @@ void Scene03::Exit()
 	{
 		if (meshList[i])
 		{
-			delete meshList[i];
+			AssetCache::GetInstance()->ReleaseMesh(meshList[i]);
 		}
 	}
+	delete textRenderer;
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 	glDeleteProgram(m_programID);
 }
@@ -850,7 +798,6 @@ void Scene03::HandleKeyPress(double dt)
 			light[0].power = 1.f;
 		else
 			light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -864,8 +811,6 @@ void Scene03::HandleKeyPress(double dt)
 		else {
 			light[0].type = Light::LIGHT_POINT;
 		}
-
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	};
 
 	// Calculate forward and right vectors based on camera orientation
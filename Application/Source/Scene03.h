@@ -5,6 +5,7 @@
 
 #include "Scene.h"
 #include "Mesh.h"
+#include "TextRenderer.h"
 #include "AltAzCamera.h"
 #include "MatrixStack.h"
 #include "Light.h"
@@ -50,25 +51,8 @@ public:
 
 	enum UNIFORM_TYPE
 	{
-		U_MVP = 0,
-		U_MODELVIEW,
+		U_MODEL = 0,
 		U_MODELVIEW_INVERSE_TRANSPOSE,
-		U_MATERIAL_AMBIENT,
-		U_MATERIAL_DIFFUSE,
-		U_MATERIAL_SPECULAR,
-		U_MATERIAL_SHININESS,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
 		U_COLOR_TEXTURE,
 		U_LIGHTENABLED,
@@ -89,6 +73,7 @@ public:
 
 	virtual void Init();
 	virtual void Update(double dt);
+	virtual void FixedUpdate(double dt);
 	virtual void Render();
 	virtual void Exit();
 
@@ -110,6 +95,7 @@ private:
 
 	unsigned m_vertexArrayID;
 	Mesh* meshList[NUM_GEOMETRY];
+	TextRenderer* textRenderer;
 
 	unsigned m_programID;
 	unsigned m_parameters[U_TOTAL];
@@ -1,4 +1,5 @@
 #include "Scene04.h"
+#include "UniformBlocks.h"
 #include "Mesh.h"
 #include "GL\glew.h"
 //kyler
@@ -14,6 +15,7 @@
 #include "shader.hpp"
 #include "Application.h"
 #include "MeshBuilder.h"
+#include "AssetCache.h"
 #include "KeyboardController.h"
 #include "LoadTGA.h"
 #include "MouseController.h"
@@ -53,32 +55,18 @@ void Scene04::Init()
 	//m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Texture.fragmentshader");
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
 	glUseProgram(m_programID);
+	UniformBlocks::GetInstance()->BindProgram(m_programID);
 
-	// Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
+	// Get a handle for our "model" uniform
+	m_parameters[U_MODEL] = glGetUniformLocation(m_programID, "model");
 	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
 	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
 	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
 	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
 
-	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT], m_parameters[U_MATERIAL_DIFFUSE], m_parameters[U_MATERIAL_SPECULAR], m_parameters[U_MATERIAL_SHININESS]);
+	Mesh::SetTextureLoc(m_parameters[U_COLOR_TEXTURE_ENABLED]);
+	m_parameters[U_INSTANCED] = glGetUniformLocation(m_programID, "instanced");
+	Mesh::SetInstancedLoc(m_parameters[U_INSTANCED]);
 
 	// Initialise camera properties
 	//camera.Init(45.f, 45.f, 10.f);
@@ -111,22 +99,22 @@ void Scene04::Init()
 
 	//skybox
 	meshList[GEO_LEFT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_LEFT]->textureID = LoadTGA("Images//redleft copy.tga");
+	meshList[GEO_LEFT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redleft copy.tga");
 
 	meshList[GEO_RIGHT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_RIGHT]->textureID = LoadTGA("Images//redright copy.tga");
+	meshList[GEO_RIGHT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redright copy.tga");
 
 	meshList[GEO_BACK] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BACK]->textureID = LoadTGA("Images//redback copy.tga");
+	meshList[GEO_BACK]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redback copy.tga");
 
 	meshList[GEO_FRONT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_FRONT]->textureID = LoadTGA("Images//redfront copy.tga");
+	meshList[GEO_FRONT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redfront copy.tga");
 
 	meshList[GEO_TOP] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_TOP]->textureID = LoadTGA("Images//redtop copy.tga");
+	meshList[GEO_TOP]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redtop copy.tga");
 
 	meshList[GEO_BOTTOM] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
-	meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//redbottom copy.tga");
+	meshList[GEO_BOTTOM]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redbottom copy.tga");
 
 	
 	//shapes
@@ -135,21 +123,20 @@ void Scene04::Init()
 	meshList[GEO_CUBE] = MeshBuilder::GenerateCube("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
 	//ground
 	meshList[GEO_GRASS] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
-	meshList[GEO_GRASS]->textureID = LoadTGA("Images//coast_sand_rocks_02 copy.tga");
+	meshList[GEO_GRASS]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga");
 
 	// 16 x 16 is the number of columns and rows for the text
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
-	meshList[GEO_TEXT]->textureID = LoadTGA("Images//Georgia.tga");
+	meshList[GEO_TEXT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//Georgia.tga");
+	textRenderer = new TextRenderer("Images//Georgia.tga", 16, 16);
 
 	meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_GUI]->textureID = LoadTGA("Images//blackblack.tga");
+	meshList[GEO_GUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//blackblack.tga");
 
 	glm::mat4 projection = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 1000.0f);
 	projectionStack.LoadMatrix(projection);
 
 
-	glUniform1i(m_parameters[U_NUMLIGHTS], NUM_LIGHTS);
-
 	light[0].position = glm::vec3(camera.position.x, camera.position.y, camera.position.z);
 	light[0].color = glm::vec3(1, 1, 0.5);
 	light[0].type = Light::LIGHT_POINT;
@@ -162,16 +149,6 @@ void Scene04::Init()
 	light[0].exponent = 3.f;
 	light[0].spotDirection = glm::vec3(0.f, 1.f, 0.f);
 
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], cosf(glm::radians<float>(light[0].cosCutoff)));
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], cosf(glm::radians<float>(light[0].cosInner)));
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-
 	enableLight = true;
 
 	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
@@ -181,11 +158,18 @@ void Scene04::Init()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	//ball innit
+	// Layers of ball_row x ball_row, 5 apart so no two start touching
+	ballWorld.Clear();
 	for (int i = 0; i < ball_num; i++) {
 		ball[i].mass = 2;
 		ball[i].bounciness = 1;
-		ball[i].pos.y = 10;
-		ball[i].pos.x = 2*i;
+		ball[i].pos.x = (i % ball_row) * 5.f - floor_space * 0.5f + 2.5f;
+		ball[i].pos.z = (i / ball_row % ball_row) * 5.f - floor_space * 0.5f + 2.5f;
+		ball[i].pos.y = 10 + (i / (ball_row * ball_row)) * 5.f;
+		ball[i].prevPos = ball[i].pos;
+		ballHandles[i] = ballWorld.Add(ball[i]);
+		// gravity as a constant acceleration, what AddForce(gravity) every step gave
+		ballWorld.SetAcceleration(ballHandles[i], glm::vec3(0, gravity / ball[i].mass, 0));
 	}
 	player.mass = 0;
 	player.bounciness = 1;
@@ -208,8 +192,6 @@ void Scene04::Update(double dt)
 	
 	//std::cout << player.pos.x<< " " <<player.pos.z << std::endl;
 	//std::cout << ball[0].pos.x << " " << ball[0].pos.z << std::endl;
-	//physics
-	balls_update(dt);
 	//handle inputs
 	HandleMouseInput();
 	HandleKeyPress(dt);
@@ -228,18 +210,25 @@ void Scene04::Update(double dt)
 
 }
 
+void Scene04::FixedUpdate(double dt)
+{
+	//physics
+	balls_update(dt);
+}
+
 void Scene04::balls_update(double dt) {
 	float br = ball_radius * 1.5;
 
-	for (int i = 0; i < ball_num; i++) {
-		
-		//collisions
-		// ball against ball
-		for (int j = i + 1; j < ball_num; j++) {
-			if (OverlapCircle2Circle(ball[i], br/2, ball[j], br, cd)) {
-				ResolveCollisionBall(cd);
-			}
+	//collisions
+	// ball against ball; the pair test reaches br/2 + br between centres, so boxes reaching half of that catch every hit
+	const std::vector<SweepAndPrune::Pair>& pairs = ballSweep.Update(ball, ball_num, glm::vec3(br * 0.75f));
+	for (const SweepAndPrune::Pair& pair : pairs) {
+		if (OverlapCircle2Circle(ball[pair.a], br/2, ball[pair.b], br, cd)) {
+			ResolveCollisionBall(cd);
 		}
+	}
+
+	for (int i = 0; i < ball_num; i++) {
 		//ball agaisnt player test
 		if (OverlapCircle2Circle(ball[i], br, player, br, cd)) {
 			ResolveCollisionBall(cd);
@@ -247,16 +236,18 @@ void Scene04::balls_update(double dt) {
 		//ball against floor
 		if (OverlapCircle2AABB(ball[i], br , floor, glm::vec3 (floor_space, floor_height, floor_space),cd)) {
 			ResolveCollision(cd);
-			std::cout << "ball collide with floor" << std::endl;
 		}
 		
 	}
+	// the collisions above moved ball[], so the world steps on from there
 	for (int i = 0; i < ball_num; i++) {
-		//gravity 
-		ball[i].AddForce(glm::vec3(0, gravity, 0));
-
-		//resolve collision
-		ball[i].UpdatePhysics(dt);
+		ballWorld.SetPosition(ballHandles[i], ball[i].pos);
+		ballWorld.SetVelocity(ballHandles[i], ball[i].vel);
+	}
+	ballWorld.Step(static_cast<float>(dt));
+	for (int i = 0; i < ball_num; i++) {
+		ball[i].BeginStep();
+		ballWorld.CopyTo(ballHandles[i], ball[i]);
 	}
 	player.AddForce(glm::vec3(0, gravity, 0));
 	player.UpdatePhysics(dt);
@@ -267,6 +258,11 @@ void Scene04::Render()
 {
 	// Clear color buffer every frame
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	Mesh::trianglesDrawn = 0;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	lodPixelScale = projectionStack.Top()[1][1] * viewport[3] * 0.5f;
 
 	// Load view matrix stack and set it with camera position, target position and up direction
 	viewStack.LoadIdentity();
@@ -279,24 +275,7 @@ void Scene04::Render()
 	// Load identity matrix into the model stack
 	modelStack.LoadIdentity();
 
-	if (light[0].type == Light::LIGHT_DIRECTIONAL)
-	{
-		glm::vec3 lightDir(light[0].position.x, light[0].position.y, light[0].position.z);
-		glm::vec3 lightDirection_cameraspace = viewStack.Top() * glm::vec4(lightDir, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightDirection_cameraspace));
-	}
-	else if (light[0].type == Light::LIGHT_SPOT)
-	{
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-		glm::vec3 spotDirection_cameraspace = viewStack.Top() * glm::vec4(light[0].spotDirection, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, glm::value_ptr(spotDirection_cameraspace));
-	}
-	else {
-		// Calculate the light position in camera space
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-	}
+	UniformBlocks::GetInstance()->SetLights(light, NUM_LIGHTS, viewStack.Top());
 
 	// Render objects
 	//RenderMesh(meshList[GEO_AXES], false);
@@ -319,23 +298,29 @@ void Scene04::Render()
 	modelStack.PushMatrix();
 	{
 		// spacing chosen to match the previous manual placement (50 units)
-		const float start = -250.f;
-		const float end = 250.f;
-		const float step = 50.f;
-		for (float x = start; x <= end; x += step)
+		// the tiles never move, so their matrices are built once and drawn in one call
+		if (grassTiles.empty())
 		{
-			for (float z = start; z <= end; z += step)
+			const float start = -250.f;
+			const float end = 250.f;
+			const float step = 50.f;
+			for (float x = start; x <= end; x += step)
 			{
-				modelStack.PushMatrix();
-				modelStack.Translate(x, 0.f, z);
-				modelStack.Scale(5.f, 1.f, 5.f);
-				// keep original rotations so the tile faces the same way as before
-				modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
-				modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
-				RenderMesh(meshList[GEO_GRASS], true);
-				modelStack.PopMatrix();
+				for (float z = start; z <= end; z += step)
+				{
+					modelStack.PushMatrix();
+					modelStack.LoadIdentity();
+					modelStack.Translate(x, 0.f, z);
+					modelStack.Scale(5.f, 1.f, 5.f);
+					// keep original rotations so the tile faces the same way as before
+					modelStack.Rotate(90.f, 0.f, 0.f, 1.f);
+					modelStack.Rotate(90.f, 0.f, 1.f, 0.f);
+					grassTiles.push_back(modelStack.Top());
+					modelStack.PopMatrix();
+				}
 			}
 		}
+		RenderMeshInstanced(meshList[GEO_GRASS], grassTiles, true);
 		// keep the ambient material tweak from original code
 		meshList[GEO_GRASS]->material.kAmbient = glm::vec3(0.3f, 0.3f, 0.3f);
 	}
@@ -343,15 +328,19 @@ void Scene04::Render()
 
 	balls_render();
 	walls_render();
+
+	std::string triangles = "Triangles:" + std::to_string(Mesh::trianglesDrawn);
+	RenderTextOnScreen(meshList[GEO_TEXT], triangles, glm::vec3(1, 1, 1), 25, 5, 570);
 }
 
 void Scene04::balls_render() {
 	for (int i = 0; i < ball_num; i++) {
 		modelStack.PushMatrix();
-		modelStack.Translate(ball[i].pos.x, ball[i].pos.y,ball[i].pos.z);
+		glm::vec3 pos = ball[i].GetInterpolatedPos(interpolation);
+		modelStack.Translate(pos.x, pos.y, pos.z);
 		modelStack.Scale((ball_radius),(ball_radius),(ball_radius));
 		modelStack.Rotate(0 , 1.f, 1.f, 1.f);
-		RenderMesh(meshList[GEO_SPHERE], true);
+		RenderMeshLod(meshList[GEO_SPHERE], ballLods[i], true);
 		modelStack.PopMatrix();
 	}
 }
@@ -477,16 +466,11 @@ void Scene04::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(
-			glm::mat4(1.f),
-			glm::vec3(i * 1.f, 0, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	// Centred on the origin like the old one-quad-per-character layout
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, -0.5f, -0.4f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
@@ -526,13 +510,10 @@ void Scene04::RenderTextOnScreen(Mesh* mesh, std::string
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(glm::mat4(1.f), glm::vec3(0.5f + i * 0.6f, 0.4f, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, 0.f, 0.f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -550,22 +531,36 @@ void Scene04::RenderTextOnScreen(Mesh* mesh, std::string
 
 void Scene04::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	glm::mat4 MVP, modelView, modelView_inverse_transpose;
+	SetMeshUniforms(mesh, enableLight);
+	mesh->Render();   // only once
+}
 
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, glm::value_ptr(modelView));
+// Draws one copy of mesh per model matrix, placed relative to modelStack.Top()
+void Scene04::RenderMeshInstanced(Mesh* mesh, const std::vector<glm::mat4>& models, bool enableLight)
+{
+	if (models.empty())
+		return;
+	SetMeshUniforms(mesh, enableLight);
+	mesh->RenderInstanced(&models[0], static_cast<unsigned>(models.size()));
+}
+
+void Scene04::RenderMeshLod(Mesh* mesh, LodState& lod, bool enableLight)
+{
+	lod.level[0] = mesh->SelectLod(modelStack.Top(), camera.position, lodPixelScale, lod.level[0]);
+	SetMeshUniforms(mesh, enableLight);
+	mesh->RenderLod(lod.level[0]);
+}
+
+void Scene04::SetMeshUniforms(Mesh* mesh, bool enableLight)
+{
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
 
 	if (enableLight) {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = glm::inverseTranspose(modelView);
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
-
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
+		glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(viewStack.Top() * modelStack.Top()));
+		glUniformMatrix3fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+		UniformBlocks::GetInstance()->SetMaterial(mesh->material);
 	}
 	else {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
@@ -580,8 +575,6 @@ void Scene04::RenderMesh(Mesh* mesh, bool enableLight)
 	else {
 		glUniform1i(m_parameters[U_COLOR_TEXTURE_ENABLED], 0);
 	}
-
-	mesh->Render();   // only once
 }
 
 
@@ -592,9 +585,10 @@ void Scene04::Exit()
 	{
 		if (meshList[i])
 		{
-			delete meshList[i];
+			AssetCache::GetInstance()->ReleaseMesh(meshList[i]);
 		}
 	}
+	delete textRenderer;
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 	glDeleteProgram(m_programID);
 }
@@ -637,7 +631,6 @@ void Scene04::HandleKeyPress(double dt)
 			light[0].power = 1.f;
 		else
 			light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -651,8 +644,6 @@ void Scene04::HandleKeyPress(double dt)
 		else {
 			light[0].type = Light::LIGHT_POINT;
 		}
-
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	};
 
 	// Calculate forward and right vectors based on camera orientation
@@ -2,9 +2,12 @@
 #define SCENE_04_H
 //kyler
 #include "CollisionDetection.h"
+#include "SweepAndPrune.h"
+#include "PhysicsWorld.h"
 
 #include "Scene.h"
 #include "Mesh.h"
+#include "TextRenderer.h"
 #include "AltAzCamera.h"
 #include "MatrixStack.h"
 #include "Light.h"
@@ -52,25 +55,8 @@ public:
 
 	enum UNIFORM_TYPE
 	{
-		U_MVP = 0,
-		U_MODELVIEW,
+		U_MODEL = 0,
 		U_MODELVIEW_INVERSE_TRANSPOSE,
-		U_MATERIAL_AMBIENT,
-		U_MATERIAL_DIFFUSE,
-		U_MATERIAL_SPECULAR,
-		U_MATERIAL_SHININESS,
-		U_LIGHT0_TYPE,
-		U_LIGHT0_POSITION,
-		U_LIGHT0_COLOR,
-		U_LIGHT0_POWER,
-		U_LIGHT0_KC,
-		U_LIGHT0_KL,
-		U_LIGHT0_KQ,
-		U_LIGHT0_SPOTDIRECTION,
-		U_LIGHT0_COSCUTOFF,
-		U_LIGHT0_COSINNER,
-		U_LIGHT0_EXPONENT,
-		U_NUMLIGHTS,
 		U_COLOR_TEXTURE_ENABLED,
 		U_COLOR_TEXTURE,
 		U_LIGHTENABLED,
@@ -82,6 +68,7 @@ public:
 		U_FOG_START,
 		U_FOG_END,
 		U_FOG_COLOR,
+		U_INSTANCED,
 
 		U_TOTAL,
 	};
@@ -91,15 +78,21 @@ public:
 
 	virtual void Init();
 	virtual void Update(double dt);
+	virtual void FixedUpdate(double dt);
 	virtual void Render();
 	virtual void Exit();
 
 private:
 	void HandleKeyPress(double dt);
 	void RenderMesh(Mesh* mesh, bool enableLight);
+	void RenderMeshInstanced(Mesh* mesh, const std::vector<glm::mat4>& models, bool enableLight);
+	// RenderMesh at the detail level the placement's screen size calls for
+	void RenderMeshLod(Mesh* mesh, LodState& lod, bool enableLight);
+	void SetMeshUniforms(Mesh* mesh, bool enableLight);
 
 	unsigned m_vertexArrayID;
 	Mesh* meshList[NUM_GEOMETRY];
+	TextRenderer* textRenderer;
 
 	unsigned m_programID;
 	unsigned m_parameters[U_TOTAL];
@@ -125,6 +118,9 @@ private:
 
 	glm::vec3 change;
 
+	// Model matrices of the ground tiles, drawn with one instanced call
+	std::vector<glm::mat4> grassTiles;
+
 	// Mouse control
 	float mouseSensitivity = 0.1f;
 	bool firstMouse = true;
@@ -134,11 +130,22 @@ private:
 	float moveSpeed = 5.0f;
 	//additional
 	// idk
-	static const int  ball_num = 10;
+	// Spawned in layers of ball_row x ball_row; SweepAndPrune keeps the pair
+	// search near linear, the limit is one draw per ball
+	static const int  ball_num = 1000;
+	static const int  ball_row = 10;
 	//objects
 	// physics objects
 	//circle
 	PhysicsObject ball[ball_num];
+	LodState ballLods[ball_num];
+	// Integrates the balls; ball[] keeps what the collision tests read and write
+	PhysicsWorld ballWorld;
+	PhysicsWorld::Handle ballHandles[ball_num];
+	// Ball pairs close enough to touch, found without testing every pair
+	SweepAndPrune ballSweep;
+	// projection[1][1] times half the viewport height, for SelectLod
+	float lodPixelScale = 0.f;
 	PhysicsObject player;//test
 	//AABB
 	PhysicsObject floor;
@@ -152,7 +159,8 @@ private:
 	//size
 	float ball_radius = 2;
 
-	float floor_space = 10;
+	// wide enough for a layer of the pit
+	float floor_space = ball_row * 5.f;
 	float floor_height = 0.25;
 	//functions
 
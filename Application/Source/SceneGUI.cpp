@@ -1,4 +1,5 @@
 #include "SceneGUI.h"
+#include "UniformBlocks.h"
 #include "Mesh.h"
 #include "GL\glew.h"
 
@@ -14,6 +15,7 @@
 #include "shader.hpp"
 #include "Application.h"
 #include "MeshBuilder.h"
+#include "AssetCache.h"
 #include "KeyboardController.h"
 #include "LoadTGA.h"
 #include "MouseController.h"
@@ -49,32 +51,16 @@ void SceneGUI::Init()
 	//m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Texture.fragmentshader");
 	m_programID = LoadShaders("Shader//Texture.vertexshader", "Shader//Text.fragmentshader");
 	glUseProgram(m_programID);
+	UniformBlocks::GetInstance()->BindProgram(m_programID);
 
-	// Get a handle for our "MVP" uniform
-	m_parameters[U_MVP] = glGetUniformLocation(m_programID, "MVP");
-	m_parameters[U_MODELVIEW] = glGetUniformLocation(m_programID, "MV");
+	// Get a handle for our "model" uniform
+	m_parameters[U_MODEL] = glGetUniformLocation(m_programID, "model");
 	m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE] = glGetUniformLocation(m_programID, "MV_inverse_transpose");
-	m_parameters[U_MATERIAL_AMBIENT] = glGetUniformLocation(m_programID, "material.kAmbient");
-	m_parameters[U_MATERIAL_DIFFUSE] = glGetUniformLocation(m_programID, "material.kDiffuse");
-	m_parameters[U_MATERIAL_SPECULAR] = glGetUniformLocation(m_programID, "material.kSpecular");
-	m_parameters[U_MATERIAL_SHININESS] = glGetUniformLocation(m_programID, "material.kShininess");
-	m_parameters[U_LIGHT0_TYPE] = glGetUniformLocation(m_programID, "lights[0].type");
-	m_parameters[U_LIGHT0_POSITION] = glGetUniformLocation(m_programID, "lights[0].position_cameraspace");
-	m_parameters[U_LIGHT0_COLOR] = glGetUniformLocation(m_programID, "lights[0].color");
-	m_parameters[U_LIGHT0_POWER] = glGetUniformLocation(m_programID, "lights[0].power");
-	m_parameters[U_LIGHT0_KC] = glGetUniformLocation(m_programID, "lights[0].kC");
-	m_parameters[U_LIGHT0_KL] = glGetUniformLocation(m_programID, "lights[0].kL");
-	m_parameters[U_LIGHT0_KQ] = glGetUniformLocation(m_programID, "lights[0].kQ");
-	m_parameters[U_LIGHT0_SPOTDIRECTION] = glGetUniformLocation(m_programID, "lights[0].spotDirection");
-	m_parameters[U_LIGHT0_COSCUTOFF] = glGetUniformLocation(m_programID, "lights[0].cosCutoff");
-	m_parameters[U_LIGHT0_COSINNER] = glGetUniformLocation(m_programID, "lights[0].cosInner");
-	m_parameters[U_LIGHT0_EXPONENT] = glGetUniformLocation(m_programID, "lights[0].exponent");
 	m_parameters[U_COLOR_TEXTURE_ENABLED] = glGetUniformLocation(m_programID, "colorTextureEnabled");
 	m_parameters[U_COLOR_TEXTURE] = glGetUniformLocation(m_programID, "colorTexture");
 	m_parameters[U_LIGHTENABLED] = glGetUniformLocation(m_programID, "lightEnabled");
-	m_parameters[U_NUMLIGHTS] = glGetUniformLocation(m_programID, "numLights");
 
-	Mesh::SetMaterialLoc(m_parameters[U_MATERIAL_AMBIENT], m_parameters[U_MATERIAL_DIFFUSE], m_parameters[U_MATERIAL_SPECULAR], m_parameters[U_MATERIAL_SHININESS]);
+	Mesh::SetTextureLoc(m_parameters[U_COLOR_TEXTURE_ENABLED]);
 
 	// Initialise camera properties
 	//camera.Init(45.f, 45.f, 10.f);
@@ -98,38 +84,38 @@ void SceneGUI::Init()
 	meshList[GEO_LEFT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_LEFT]->textureID = LoadTGA("Images//blackblack.tga");
 	//meshList[GEO_LEFT]->textureID = LoadTGA("Images//whitesky//whiteskyleft.tga");
-	meshList[GEO_LEFT]->textureID = LoadTGA("Images//redleft copy.tga");
+	meshList[GEO_LEFT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redleft copy.tga");
 	//meshList[GEO_LEFT]->textureID = LoadTGA("Images//left.tga");
 
 	meshList[GEO_RIGHT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_RIGHT]->textureID = LoadTGA("Images//blackblack.tga");
 	//meshList[GEO_RIGHT]->textureID = LoadTGA("Images//whitesky//whiteskyright.tga");
-	meshList[GEO_RIGHT]->textureID = LoadTGA("Images//redright copy.tga");
+	meshList[GEO_RIGHT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redright copy.tga");
 	//meshList[GEO_RIGHT]->textureID = LoadTGA("Images//right.tga");
 
 	meshList[GEO_BACK] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_BACK]->textureID = LoadTGA("Images//blackblack.tga");
 	//meshList[GEO_BACK]->textureID = LoadTGA("Images//whitesky//whiteskyback.tga");
-	meshList[GEO_BACK]->textureID = LoadTGA("Images//redback copy.tga");
+	meshList[GEO_BACK]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redback copy.tga");
 	//meshList[GEO_BACK]->textureID = LoadTGA("Images//back.tga");
 
 	meshList[GEO_FRONT] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_FRONT]->textureID = LoadTGA("Images//blackblack.tga");
 	//meshList[GEO_FRONT]->textureID = LoadTGA("Images//whitesky//whiteskyfront.tga");
-	meshList[GEO_FRONT]->textureID = LoadTGA("Images//redfront copy.tga");
+	meshList[GEO_FRONT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redfront copy.tga");
 	//meshList[GEO_FRONT]->textureID = LoadTGA("Images//front.tga");
 
 	meshList[GEO_TOP] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//saharatop.tga");
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//top.tga");
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//whitesky//whiteskytop.tga");
-	meshList[GEO_TOP]->textureID = LoadTGA("Images//redtop copy.tga");
+	meshList[GEO_TOP]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redtop copy.tga");
 	//meshList[GEO_TOP]->textureID = LoadTGA("Images//bigblackmoon.tga");
 
 	meshList[GEO_BOTTOM] = MeshBuilder::GenerateQuad("Plane", glm::vec3(1.f, 1.f, 1.f), 100.f);
 	//meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//blackblack.tga");
 	//meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//whitesky//whiteskybottom.tga");
-	meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//redbottom copy.tga");
+	meshList[GEO_BOTTOM]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//redbottom copy.tga");
 	//meshList[GEO_BOTTOM]->textureID = LoadTGA("Images//bottom.tga");
 
 	//meshList[GEO_QUAD]->textureID = LoadTGA("Images//NYP.tga");
@@ -138,48 +124,43 @@ void SceneGUI::Init()
 	meshList[GEO_CYLINDER] = MeshBuilder::GenerateCylinder("Cylinder", glm::vec3(1.f, 1.f, 1.f), 36, 1.f, 2.f);
 
 	meshList[GEO_GRASS] = MeshBuilder::GenerateQuad("Quad", glm::vec3(1.f, 1.f, 1.f), 10.f);
-	meshList[GEO_GRASS]->textureID = LoadTGA("Images//coast_sand_rocks_02 copy.tga");
+	meshList[GEO_GRASS]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//coast_sand_rocks_02 copy.tga");
 
 	//meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
 	//meshList[GEO_GUI]->textureID = LoadTGA("Images//color.tga");
 
 	// 16 x 16 is the number of columns and rows for the text
 	meshList[GEO_TEXT] = MeshBuilder::GenerateText("text", 16, 16);
-	meshList[GEO_TEXT]->textureID = LoadTGA("Images//Georgia.tga");
+	meshList[GEO_TEXT]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//Georgia.tga");
+	textRenderer = new TextRenderer("Images//Georgia.tga", 16, 16);
 
 	meshList[GEO_GUI] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_GUI]->textureID = LoadTGA("Images//wiu main menu version1.tga");
+	meshList[GEO_GUI]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//wiu main menu version1.tga");
 
-	meshList[GEO_EYEBALL] = MeshBuilder::GenerateOBJMTL("eyeballmtl", "Models//eyeball.obj", "Models//eyeball.mtl");
-	meshList[GEO_EYEBALL]->textureID = LoadTGA("Images//Eye_D.tga");
+	meshList[GEO_EYEBALL] = AssetCache::GetInstance()->AcquireOBJMTL("eyeballmtl", "Models//eyeball.obj", "Models//eyeball.mtl", "Images//Eye_D.tga");
 
-	meshList[GEO_PINETREE] = MeshBuilder::GenerateOBJMTL("tower", "Models//DeadTree_LoPoly.obj", "Models//DeadTree_LoPoly.mtl");
-	meshList[GEO_PINETREE]->textureID = LoadTGA("Images//DeadTree_LoPoly_DeadTree_Diffuse copy.tga");
+	meshList[GEO_PINETREE] = AssetCache::GetInstance()->AcquireOBJMTL("tower", "Models//DeadTree_LoPoly.obj", "Models//DeadTree_LoPoly.mtl", "Images//DeadTree_LoPoly_DeadTree_Diffuse copy.tga");
 
 	//meshList[GEO_PEWPEW] = MeshBuilder::GenerateOBJMTL("tower", "Models//low-poly_geissele_urg-i_14.5.obj", "Models//low-poly_geissele_urg-i_14.5.mtl");
 
-	meshList[GEO_ABANDONEDHOUSE] = MeshBuilder::GenerateOBJMTL("abandonedhse", "Models//abandoned_house.obj", "Models//abandoned_house.mtl");
-	meshList[GEO_ABANDONEDHOUSE]->textureID = LoadTGA("Images//abandonedhouseBaseColor.tga");
+	meshList[GEO_ABANDONEDHOUSE] = AssetCache::GetInstance()->AcquireOBJMTL("abandonedhse", "Models//abandoned_house.obj", "Models//abandoned_house.mtl", "Images//abandonedhouseBaseColor.tga");
 
-	meshList[GEO_SHADOW] = MeshBuilder::GenerateOBJMTL("shadow", "Models//swamp_monster.obj", "Models//swamp_monster.mtl");
-	meshList[GEO_SHADOW]->textureID = LoadTGA("Images//FOREST_MONSTER_V1_mat_diffuse.tga");
+	meshList[GEO_SHADOW] = AssetCache::GetInstance()->AcquireOBJMTL("shadow", "Models//swamp_monster.obj", "Models//swamp_monster.mtl", "");
 
-	meshList[GEO_FLASHLIGHT] = MeshBuilder::GenerateOBJMTL("flashlight", "Models//low_poly_flashlight.obj", "Models//low_poly_flashlight.mtl");
+	meshList[GEO_FLASHLIGHT] = AssetCache::GetInstance()->AcquireOBJMTL("flashlight", "Models//low_poly_flashlight.obj", "Models//low_poly_flashlight.mtl", "");
 
 	meshList[GEO_NOTE] = MeshBuilder::GenerateQuad("GUI", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[GEO_NOTE]->textureID = LoadTGA("Images//note.tga");
+	meshList[GEO_NOTE]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//note.tga");
 
-	meshList[GEO_SPARKLING_STAR] = MeshBuilder::GenerateOBJMTL("sparklingstar", "Models//sparkling_star.obj", "Models//sparkling_star.mtl");
+	meshList[GEO_SPARKLING_STAR] = AssetCache::GetInstance()->AcquireOBJMTL("sparklingstar", "Models//sparkling_star.obj", "Models//sparkling_star.mtl", "");
 
 	meshList[BUMPERCAR_LOADINGSCREEN] = MeshBuilder::GenerateQuad("loadingscreen", glm::vec3(1.f, 1.f, 1.f), 1.f);
-	meshList[BUMPERCAR_LOADINGSCREEN]->textureID = LoadTGA("Images//loadingscreen.tga");
+	meshList[BUMPERCAR_LOADINGSCREEN]->textureID = AssetCache::GetInstance()->AcquireTexture("Images//loadingscreen.tga");
 
 	glm::mat4 projection = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 1000.0f);
 	projectionStack.LoadMatrix(projection);
 
 
-	glUniform1i(m_parameters[U_NUMLIGHTS], NUM_LIGHTS);
-
 	light[0].position = glm::vec3(camera.position.x, camera.position.y, camera.position.z);
 	light[0].color = glm::vec3(1, 0, 0);
 	light[0].type = Light::LIGHT_DIRECTIONAL;
@@ -192,16 +173,6 @@ void SceneGUI::Init()
 	light[0].exponent = 3.f;
 	light[0].spotDirection = glm::vec3(0.f, 1.f, 0.f);
 
-	glUniform3fv(m_parameters[U_LIGHT0_COLOR], 1, &light[0].color.r);
-	glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
-	glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
-	glUniform1f(m_parameters[U_LIGHT0_KC], light[0].kC);
-	glUniform1f(m_parameters[U_LIGHT0_KL], light[0].kL);
-	glUniform1f(m_parameters[U_LIGHT0_KQ], light[0].kQ);
-	glUniform1f(m_parameters[U_LIGHT0_COSCUTOFF], cosf(glm::radians<float>(light[0].cosCutoff)));
-	glUniform1f(m_parameters[U_LIGHT0_COSINNER], cosf(glm::radians<float>(light[0].cosInner)));
-	glUniform1f(m_parameters[U_LIGHT0_EXPONENT], light[0].exponent);
-
 	enableLight = true;
 
 	m_parameters[U_TEXT_ENABLED] = glGetUniformLocation(m_programID, "textEnabled");
@@ -349,16 +320,11 @@ void SceneGUI::RenderText(Mesh* mesh, std::string text, glm::vec3 color)
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(
-			glm::mat4(1.f),
-			glm::vec3(i * 1.f, 0, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	// Centred on the origin like the old one-quad-per-character layout
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, -0.5f, -0.4f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glUniform1i(m_parameters[U_TEXT_ENABLED], 0);
@@ -398,13 +364,10 @@ void SceneGUI::RenderTextOnScreen(Mesh* mesh, std::string
 	glBindTexture(GL_TEXTURE_2D, mesh->textureID);
 	glUniform1i(m_parameters[U_COLOR_TEXTURE], 0);
 
-	for (unsigned i = 0; i < text.length(); ++i)
-	{
-		glm::mat4 characterSpacing = glm::translate(glm::mat4(1.f), glm::vec3(0.5f + i * 0.6f, 0.4f, 0));
-		glm::mat4 MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top() * characterSpacing;
-		glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-		mesh->Render((unsigned)text[i] * 6, 6);
-	}
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
+	textRenderer->Add(text, glm::vec3(1.f, 1.f, 1.f), 1.f, 0.f, 0.f);
+	textRenderer->Draw();
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -434,24 +397,7 @@ void SceneGUI::Render()
 	// Load identity matrix into the model stack
 	modelStack.LoadIdentity();
 
-	if (light[0].type == Light::LIGHT_DIRECTIONAL)
-	{
-		glm::vec3 lightDir(light[0].position.x, light[0].position.y, light[0].position.z);
-		glm::vec3 lightDirection_cameraspace = viewStack.Top() * glm::vec4(lightDir, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightDirection_cameraspace));
-	}
-	else if (light[0].type == Light::LIGHT_SPOT)
-	{
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-		glm::vec3 spotDirection_cameraspace = viewStack.Top() * glm::vec4(light[0].spotDirection, 0);
-		glUniform3fv(m_parameters[U_LIGHT0_SPOTDIRECTION], 1, glm::value_ptr(spotDirection_cameraspace));
-	}
-	else {
-		// Calculate the light position in camera space
-		glm::vec3 lightPosition_cameraspace = viewStack.Top() * glm::vec4(light[0].position, 1);
-		glUniform3fv(m_parameters[U_LIGHT0_POSITION], 1, glm::value_ptr(lightPosition_cameraspace));
-	}
+	UniformBlocks::GetInstance()->SetLights(light, NUM_LIGHTS, viewStack.Top());
 
 	// Render objects
 	//RenderMesh(meshList[GEO_AXES], false);
@@ -521,22 +467,14 @@ void SceneGUI::Render()
 
 void SceneGUI::RenderMesh(Mesh* mesh, bool enableLight)
 {
-	glm::mat4 MVP, modelView, modelView_inverse_transpose;
-
-	MVP = projectionStack.Top() * viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MVP], 1, GL_FALSE, glm::value_ptr(MVP));
-	modelView = viewStack.Top() * modelStack.Top();
-	glUniformMatrix4fv(m_parameters[U_MODELVIEW], 1, GL_FALSE, glm::value_ptr(modelView));
+	UniformBlocks::GetInstance()->SetCamera(viewStack.Top(), projectionStack.Top());
+	glUniformMatrix4fv(m_parameters[U_MODEL], 1, GL_FALSE, glm::value_ptr(modelStack.Top()));
 
 	if (enableLight) {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 1);
-		modelView_inverse_transpose = glm::inverseTranspose(modelView);
-		glUniformMatrix4fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
-
-		glUniform3fv(m_parameters[U_MATERIAL_AMBIENT], 1, &mesh->material.kAmbient.r);
-		glUniform3fv(m_parameters[U_MATERIAL_DIFFUSE], 1, &mesh->material.kDiffuse.r);
-		glUniform3fv(m_parameters[U_MATERIAL_SPECULAR], 1, &mesh->material.kSpecular.r);
-		glUniform1f(m_parameters[U_MATERIAL_SHININESS], mesh->material.kShininess);
+		glm::mat3 modelView_inverse_transpose = glm::inverseTranspose(glm::mat3(viewStack.Top() * modelStack.Top()));
+		glUniformMatrix3fv(m_parameters[U_MODELVIEW_INVERSE_TRANSPOSE], 1, GL_FALSE, glm::value_ptr(modelView_inverse_transpose));
+		UniformBlocks::GetInstance()->SetMaterial(mesh->material);
 	}
 	else {
 		glUniform1i(m_parameters[U_LIGHTENABLED], 0);
@@ -563,9 +501,10 @@ void SceneGUI::Exit()
 	{
 		if (meshList[i])
 		{
-			delete meshList[i];
+			AssetCache::GetInstance()->ReleaseMesh(meshList[i]);
 		}
 	}
+	delete textRenderer;
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 	glDeleteProgram(m_programID);
 }
@@ -609,7 +548,6 @@ void SceneGUI::HandleKeyPress(double dt)
 			light[0].power = 1.f;
 		else
 			light[0].power = 0.1f;
-		glUniform1f(m_parameters[U_LIGHT0_POWER], light[0].power);
 	}
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_TAB))
@@ -623,8 +561,6 @@ void SceneGUI::HandleKeyPress(double dt)
 		else {
 			light[0].type = Light::LIGHT_POINT;
 		}
-
-		glUniform1i(m_parameters[U_LIGHT0_TYPE], light[0].type);
 	};
 
 	if (KeyboardController::GetInstance()->IsKeyPressed(GLFW_KEY_1))
@@ -0,0 +1,269 @@
+#include "SpatialHash.h"
+#include "CollisionDetection.h"
+#include "timer.h"
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <iostream>
+
+SpatialHash::SpatialHash(float cellSize)
+	: cellSize(cellSize)
+	, inverseCellSize(1.f / cellSize)
+	, bucketMask(0)
+	, built(false)
+	, stamp(0)
+	, tested(0)
+{
+}
+
+void SpatialHash::Clear()
+{
+	boxes.clear();
+	oversized.clear();
+	built = false;
+}
+
+unsigned SpatialHash::Insert(const glm::vec3& min, const glm::vec3& max)
+{
+	Box box;
+	box.min = min;
+	box.max = max;
+	box.cellMin = CellOf(min);
+	box.cellMax = CellOf(max);
+
+	unsigned handle = static_cast<unsigned>(boxes.size());
+	glm::ivec3 span = box.cellMax - box.cellMin + glm::ivec3(1);
+	if (static_cast<long long>(span.x) * span.y * span.z > MAX_CELLS)
+	{
+		// An empty cell range keeps it out of the buckets
+		oversized.push_back(handle);
+		box.cellMax.x = box.cellMin.x - 1;
+	}
+	boxes.push_back(box);
+	built = false;
+	return handle;
+}
+
+unsigned SpatialHash::Insert(const PhysicsObject& obj)
+{
+	glm::vec3 halfSize(obj.sizeX * 0.5f, obj.sizeY * 0.5f, obj.sizeZ * 0.5f);
+	return Insert(obj.pos - halfSize, obj.pos + halfSize);
+}
+
+glm::ivec3 SpatialHash::CellOf(const glm::vec3& point) const
+{
+	return glm::ivec3(glm::floor(point * inverseCellSize));
+}
+
+unsigned SpatialHash::Bucket(int x, int y, int z) const
+{
+	return (static_cast<unsigned>(x) * 73856093u ^ static_cast<unsigned>(y) * 19349663u ^ static_cast<unsigned>(z) * 83492791u) & bucketMask;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Sort the handles into buckets: count the cells hashed to each bucket, turn
+the counts into start offsets, then drop every handle in place. Twice as
+many buckets as entries keeps unrelated cells from sharing most of them.
+*/
+/******************************************************************************/
+void SpatialHash::Build()
+{
+	unsigned entryCount = 0;
+	for (const Box& box : boxes)
+	{
+		glm::ivec3 span = glm::max(box.cellMax - box.cellMin + glm::ivec3(1), glm::ivec3(0));
+		entryCount += span.x * span.y * span.z;
+	}
+
+	unsigned bucketCount = 64;
+	while (bucketCount < entryCount * 2)
+		bucketCount *= 2;
+	bucketMask = bucketCount - 1;
+
+	bucketStart.assign(bucketCount + 1, 0);
+	for (const Box& box : boxes)
+		for (int x = box.cellMin.x; x <= box.cellMax.x; ++x)
+			for (int y = box.cellMin.y; y <= box.cellMax.y; ++y)
+				for (int z = box.cellMin.z; z <= box.cellMax.z; ++z)
+					++bucketStart[Bucket(x, y, z) + 1];
+	for (unsigned b = 1; b <= bucketCount; ++b)
+		bucketStart[b] += bucketStart[b - 1];
+
+	// Filling advances each start to the next bucket's, so shift them back after
+	entries.resize(entryCount);
+	for (unsigned handle = 0; handle < boxes.size(); ++handle)
+	{
+		const Box& box = boxes[handle];
+		for (int x = box.cellMin.x; x <= box.cellMax.x; ++x)
+			for (int y = box.cellMin.y; y <= box.cellMax.y; ++y)
+				for (int z = box.cellMin.z; z <= box.cellMax.z; ++z)
+					entries[bucketStart[Bucket(x, y, z)]++] = handle;
+	}
+	for (unsigned b = bucketCount; b > 0; --b)
+		bucketStart[b] = bucketStart[b - 1];
+	bucketStart[0] = 0;
+
+	stamps.assign(boxes.size(), 0);
+	stamp = 0;
+	built = true;
+}
+
+void SpatialHash::Test(unsigned handle, const glm::vec3& min, const glm::vec3& max, std::vector<unsigned>& out)
+{
+	if (stamps[handle] == stamp)
+		return;
+	stamps[handle] = stamp;
+	++tested;
+
+	// OverlapAABB2AABB leaves out z, so the boxes are compared here
+	const Box& box = boxes[handle];
+	if (min.x <= box.max.x && max.x >= box.min.x &&
+		min.y <= box.max.y && max.y >= box.min.y &&
+		min.z <= box.max.z && max.z >= box.min.z)
+		out.push_back(handle);
+}
+
+void SpatialHash::Query(const glm::vec3& min, const glm::vec3& max, std::vector<unsigned>& out)
+{
+	if (!built)
+		Build();
+	if (++stamp == 0)
+	{
+		std::fill(stamps.begin(), stamps.end(), 0);
+		stamp = 1;
+	}
+
+	glm::ivec3 cellMin = CellOf(min);
+	glm::ivec3 cellMax = CellOf(max);
+	glm::ivec3 span = cellMax - cellMin + glm::ivec3(1);
+	if (static_cast<long long>(span.x) * span.y * span.z > MAX_CELLS)
+	{
+		// Walking that many cells costs more than checking every box
+		for (unsigned handle = 0; handle < boxes.size(); ++handle)
+			Test(handle, min, max, out);
+		return;
+	}
+
+	for (int x = cellMin.x; x <= cellMax.x; ++x)
+		for (int y = cellMin.y; y <= cellMax.y; ++y)
+			for (int z = cellMin.z; z <= cellMax.z; ++z)
+			{
+				unsigned bucket = Bucket(x, y, z);
+				for (unsigned i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i)
+					Test(entries[i], min, max, out);
+			}
+
+	for (unsigned handle : oversized)
+		Test(handle, min, max, out);
+}
+
+void SpatialHash::Query(const PhysicsObject& obj, std::vector<unsigned>& out)
+{
+	glm::vec3 halfSize(obj.sizeX * 0.5f, obj.sizeY * 0.5f, obj.sizeZ * 0.5f);
+	Query(obj.pos - halfSize, obj.pos + halfSize, out);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Scatter projectiles balls flying in random directions and targets boxes
+over a 400 x 50 x 400 field, step the balls, and test them against the
+targets by checking every pair and then through a SpatialHash rebuilt
+each frame. Reports the pairs given to OverlapSphere2AABB, the overlaps
+found and the time per frame.
+
+\param projectiles - number of balls
+\param targets - number of boxes
+
+\return 0 if both passes found the same overlaps, 1 otherwise
+*/
+/******************************************************************************/
+int RunBroadPhaseBenchmark(unsigned projectiles, unsigned targets)
+{
+	const unsigned frames = 10;
+	const float dt = 1.f / 60.f;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> field(-200.f, 200.f);
+	std::uniform_real_distribution<float> height(0.f, 50.f);
+	std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+	std::vector<PhysicsObject> balls(projectiles);
+	for (PhysicsObject& ball : balls)
+	{
+		ball.sizeX = ball.sizeY = ball.sizeZ = 0.3f;
+		ball.pos = glm::vec3(field(random), height(random), field(random));
+		ball.vel = glm::vec3(direction(random), direction(random), direction(random)) * 100.f;
+	}
+	std::vector<PhysicsObject> boxes;
+	for (unsigned i = 0; i < targets; ++i)
+		boxes.push_back(PhysicsObject(2.f, 5.f, 2.f, glm::vec3(field(random), height(random), field(random)), 0.f, 1.f));
+
+	SpatialHash grid(5.f);
+	std::vector<unsigned> candidates;
+	StopWatch timer;
+	grid.ResetStats();
+
+	unsigned hits[2] = { 0, 0 };
+	for (int hashed = 0; hashed < 2; ++hashed)
+	{
+		std::vector<PhysicsObject> moving = balls;
+		unsigned pairs = 0;
+		timer.startTimer();
+		for (unsigned frame = 0; frame < frames; ++frame)
+		{
+			for (PhysicsObject& ball : moving)
+				ball.UpdatePhysics(dt);
+
+			if (hashed)
+			{
+				grid.Clear();
+				for (const PhysicsObject& box : boxes)
+					grid.Insert(box);
+			}
+
+			for (PhysicsObject& ball : moving)
+			{
+				CollisionData cd;
+				if (hashed)
+				{
+					candidates.clear();
+					grid.Query(ball, candidates);
+					for (unsigned handle : candidates)
+					{
+						++pairs;
+						if (OverlapSphere2AABB(ball, boxes[handle], cd))
+							++hits[hashed];
+					}
+				}
+				else
+				{
+					for (PhysicsObject& box : boxes)
+					{
+						++pairs;
+						if (OverlapSphere2AABB(ball, box, cd))
+							++hits[hashed];
+					}
+				}
+			}
+		}
+		double time = timer.getElapsedTime();
+
+		std::cout << (hashed ? "Spatial hash: " : "All pairs: ")
+			<< pairs / frames << " pairs tested, ";
+		if (hashed)
+			std::cout << grid.GetTestedCount() / frames << " bounds compared, ";
+		std::cout
+			<< hits[hashed] << " overlaps, "
+			<< time * 1000.0 / frames << " ms per frame\n";
+	}
+
+	if (hits[0] != hits[1])
+	{
+		std::cout << "FAIL: the spatial hash found " << hits[1] << " overlaps, all pairs found " << hits[0] << "\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include "PhysicsObject.h"
+
+/******************************************************************************/
+/*!
+		Class SpatialHash:
+\brief	Uniform-grid broad phase. Each frame the caller Clear()s it,
+		Insert()s the boxes to collide against and then Query()s with the
+		moving objects; only boxes sharing a cell and overlapping the query
+		box come back, so the narrow phase runs on likely pairs alone.
+
+		Cells are hashed into a flat bucket table sized from the entry
+		count, and the table is rebuilt with a counting sort on the first
+		query after an insert. Boxes covering more than MAX_CELLS cells are
+		kept in a list every query checks instead of being spread out.
+
+		Query returns the handles Insert gave out, numbered from 0 in
+		insertion order, so callers can insert several kinds of object and
+		tell them apart by range.
+*/
+/******************************************************************************/
+class SpatialHash
+{
+public:
+	static const unsigned MAX_CELLS = 64;
+
+	// cellSize should be around the size of the larger objects inserted
+	explicit SpatialHash(float cellSize);
+
+	void Clear();
+	// Register a box; returns its handle
+	unsigned Insert(const glm::vec3& min, const glm::vec3& max);
+	// Register obj as the box pos +- size / 2, as the Overlap functions treat it
+	unsigned Insert(const PhysicsObject& obj);
+
+	// Append the handles of every box overlapping [min, max], each once
+	void Query(const glm::vec3& min, const glm::vec3& max, std::vector<unsigned>& out);
+	void Query(const PhysicsObject& obj, std::vector<unsigned>& out);
+
+	unsigned GetCount() const { return static_cast<unsigned>(boxes.size()); }
+	// Boxes whose bounds Query compared since ResetStats
+	unsigned GetTestedCount() const { return tested; }
+	void ResetStats() { tested = 0; }
+
+private:
+	struct Box
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		glm::ivec3 cellMin;
+		glm::ivec3 cellMax;
+	};
+
+	glm::ivec3 CellOf(const glm::vec3& point) const;
+	unsigned Bucket(int x, int y, int z) const;
+	void Build();
+	void Test(unsigned handle, const glm::vec3& min, const glm::vec3& max, std::vector<unsigned>& out);
+
+	float cellSize;
+	float inverseCellSize;
+
+	std::vector<Box> boxes;
+	std::vector<unsigned> oversized;	// handles checked by every query
+	std::vector<unsigned> bucketStart;	// entries of bucket b are [bucketStart[b], bucketStart[b + 1])
+	std::vector<unsigned> entries;		// handles, grouped by bucket
+	unsigned bucketMask;
+	bool built;
+
+	// Query stamps each handle it returns so boxes in several cells come back once
+	std::vector<unsigned> stamps;
+	unsigned stamp;
+	unsigned tested;
+};
+
+// Time projectiles against targets, each against all and through a SpatialHash,
+// and report the pairs given to the narrow phase per frame; non-zero if the
+// two find different overlaps
+int RunBroadPhaseBenchmark(unsigned projectiles, unsigned targets);
@@ -0,0 +1,295 @@
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include "StaticBatch.h"
+#include "Mesh.h"
+#include "GL\glew.h"
+#include <GLFW/glfw3.h>
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\matrix_inverse.hpp>
+#include "Vertex.h"
+#include "MeshBuilder.h"
+#include "UniformBlocks.h"
+#include "DrawBenchmark.h"
+#include "timer.h"
+
+// Meshes keep no CPU copy of their data, so baking reads it back. The copy
+// target leaves the VAO's element buffer binding alone
+template<typename T>
+static void ReadBuffer(GLuint buffer, std::vector<T>& out)
+{
+	GLint size = 0;
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+	out.resize(size / sizeof(T));
+	if (!out.empty())
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, out.size() * sizeof(T), &out[0]);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+static bool SameMaterial(const Material& a, const Material& b)
+{
+	return a.kAmbient == b.kAmbient && a.kDiffuse == b.kDiffuse &&
+		a.kSpecular == b.kSpecular && a.kShininess == b.kShininess;
+}
+
+StaticBatch::StaticBatch()
+	: built(false)
+{
+}
+
+StaticBatch::~StaticBatch()
+{
+	Clear();
+}
+
+bool StaticBatch::Add(Mesh* mesh, const glm::mat4& model, bool lightEnabled)
+{
+	if (!mesh || mesh->mode != Mesh::DRAW_TRIANGLES)
+		return false;
+
+	Prop prop;
+	prop.mesh = mesh;
+	prop.model = model;
+	prop.lightEnabled = lightEnabled;
+	prop.material = mesh->material;
+	props.push_back(prop);
+	built = false;
+	return true;
+}
+
+void StaticBatch::Clear()
+{
+	for (Batch& batch : batches)
+	{
+		// The textures belong to the source meshes
+		batch.mesh->textureID = 0;
+		delete batch.mesh;
+	}
+	batches.clear();
+	props.clear();
+	built = false;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Merge the props into world-space meshes, one per distinct texture, material
+and lighting flag. Each material range of a source mesh goes to the batch of
+its own material and texture. Normals are moved by the inverse transpose, and
+mirroring transforms get their triangles flipped back to counter-clockwise.
+
+\return true when the batches are ready, false while a source is streaming
+*/
+/******************************************************************************/
+bool StaticBatch::Build()
+{
+	if (built)
+		return true;
+	for (const Prop& prop : props)
+	{
+		if (prop.mesh->indexSize == 0)
+			return false;
+	}
+
+	struct Source
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned> indices;
+	};
+	struct Bucket
+	{
+		GLuint texture;
+		bool lightEnabled;
+		Material material;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned> indices;
+	};
+
+	std::map<Mesh*, Source> sources;	// props often share a mesh
+	std::vector<Bucket> buckets;
+	std::vector<unsigned> remap;
+	std::vector<Vertex> world;
+
+	for (const Prop& prop : props)
+	{
+		Source& source = sources[prop.mesh];
+		if (source.indices.empty())
+		{
+			ReadBuffer(prop.mesh->vertexBuffer, source.vertices);
+			ReadBuffer(prop.mesh->indexBuffer, source.indices);
+			source.indices.resize(prop.mesh->indexSize);
+		}
+
+		glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(prop.model));
+		bool mirrored = glm::determinant(glm::mat3(prop.model)) < 0.f;
+		world.resize(source.vertices.size());
+		for (unsigned i = 0; i < source.vertices.size(); ++i)
+		{
+			world[i] = source.vertices[i];
+			if (prop.mesh->primitive != nullptr)
+				world[i].color = prop.mesh->color; // shared primitives are coloured when drawn
+			world[i].pos = glm::vec3(prop.model * glm::vec4(source.vertices[i].pos, 1.f));
+			glm::vec3 normal = normalMatrix * source.vertices[i].normal;
+			if (glm::dot(normal, normal) > 0.f)
+				world[i].normal = glm::normalize(normal);
+		}
+
+		// One run per material range, or the whole mesh with its own material
+		unsigned runCount = prop.mesh->materialRanges.empty() ? 1 : static_cast<unsigned>(prop.mesh->materialRanges.size());
+		for (unsigned run = 0; run < runCount; ++run)
+		{
+			unsigned offset = 0;
+			unsigned count = static_cast<unsigned>(source.indices.size());
+			GLuint texture = prop.mesh->textureID;
+			const Material* material = &prop.material;
+			if (!prop.mesh->materialRanges.empty())
+			{
+				const MaterialRange& range = prop.mesh->materialRanges[run];
+				offset = range.offset;
+				count = range.count;
+				material = &prop.mesh->materials[range.material];
+				if (material->textureID > 0)
+					texture = material->textureID;
+			}
+
+			Bucket* bucket = nullptr;
+			for (Bucket& candidate : buckets)
+			{
+				if (candidate.texture == texture && candidate.lightEnabled == prop.lightEnabled &&
+					SameMaterial(candidate.material, *material))
+				{
+					bucket = &candidate;
+					break;
+				}
+			}
+			if (!bucket)
+			{
+				buckets.push_back(Bucket());
+				bucket = &buckets.back();
+				bucket->texture = texture;
+				bucket->lightEnabled = prop.lightEnabled;
+				bucket->material = *material;
+				bucket->material.texturePath.clear();
+			}
+
+			// Copy only the vertices this run uses, each once
+			remap.assign(world.size(), ~0u);
+			for (unsigned i = offset; i + 2 < offset + count; i += 3)
+			{
+				unsigned triangle[3] = { source.indices[i], source.indices[i + 1], source.indices[i + 2] };
+				if (mirrored)
+					std::swap(triangle[1], triangle[2]);
+				for (unsigned corner : triangle)
+				{
+					if (remap[corner] == ~0u)
+					{
+						remap[corner] = static_cast<unsigned>(bucket->vertices.size());
+						bucket->vertices.push_back(world[corner]);
+					}
+					bucket->indices.push_back(remap[corner]);
+				}
+			}
+		}
+	}
+
+	for (const Bucket& bucket : buckets)
+	{
+		if (bucket.indices.empty())
+			continue;
+
+		Mesh* mesh = new Mesh("static batch");
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, bucket.vertices.size() * sizeof(Vertex), &bucket.vertices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, bucket.indices.size() * sizeof(GLuint), &bucket.indices[0], GL_STATIC_DRAW);
+		mesh->indexSize = bucket.indices.size();
+		mesh->mode = Mesh::DRAW_TRIANGLES;
+		mesh->ComputeBounds(&bucket.vertices[0], &bucket.indices[0], mesh->indexSize);
+		mesh->material = bucket.material;
+		mesh->textureID = bucket.texture;
+
+		Batch batch;
+		batch.mesh = mesh;
+		batch.lightEnabled = bucket.lightEnabled;
+		batches.push_back(batch);
+	}
+
+	built = true;
+	return true;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Scatter props copies of a hemisphere and a cube, alternating, and draw them one
+call each and then as baked batches, reporting the draw calls and frame
+time of each. Needs a current GL context.
+
+\param props - number of props
+*/
+/******************************************************************************/
+void RunStaticBatchBenchmark(unsigned props)
+{
+	const float spacing = 6.f;
+
+	DrawBenchmark benchmark;
+	glUniform1i(benchmark.GetUniform("lightEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("textEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("colorTextureEnabled"), 0);
+	GLint locationModel = benchmark.GetUniform("model");
+
+	Mesh* meshes[2] = {
+		// Spheres are triangle strips, which cannot be merged
+		MeshBuilder::GenerateHemisphere("Hemisphere", glm::vec3(0.8f, 0.3f, 0.3f), 16, 32, 1.f),
+		MeshBuilder::GenerateCube("Cube", glm::vec3(0.3f, 0.3f, 0.8f), 1.5f),
+	};
+	meshes[1]->material.kAmbient = glm::vec3(0.5f, 0.5f, 0.5f);
+
+	unsigned side = 1;
+	while (side * side < props)
+		++side;
+	float half = (side - 1) * spacing * 0.5f;
+
+	StaticBatch batch;
+	std::vector<glm::mat4> models;
+	for (unsigned i = 0; i < props; ++i)
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3((i % side) * spacing - half, 0.f, (i / side) * spacing - half));
+		model = glm::rotate(model, glm::radians(i * 37.f), glm::vec3(0.f, 1.f, 0.f));
+		models.push_back(model);
+		batch.Add(meshes[i % 2], model, false);
+	}
+
+	StopWatch timer;
+	timer.startTimer();
+	batch.Build();
+	std::cout << "Baked " << props << " props into " << batch.GetBatches().size()
+		<< " batches in " << timer.getElapsedTime() * 1000.0 << " ms\n";
+
+	GLint width = 800, height = 600;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.f), (float)width / (float)height, 0.1f, 5000.f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.f, half, half * 2.f + 10.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	UniformBlocks::GetInstance()->SetCamera(view, projection);
+	const glm::mat4 identity(1.f);
+
+	benchmark.Run("One draw per prop: ", "draw calls", [&]() {
+		for (unsigned i = 0; i < props; ++i)
+		{
+			glUniformMatrix4fv(locationModel, 1, GL_FALSE, &models[i][0][0]);
+			meshes[i % 2]->Render();
+		}
+		return props;
+	});
+	benchmark.Run("Baked: ", "draw calls", [&]() {
+		glUniformMatrix4fv(locationModel, 1, GL_FALSE, &identity[0][0]);
+		for (const StaticBatch::Batch& b : batch.GetBatches())
+			b.mesh->Render();
+		return static_cast<unsigned>(batch.GetBatches().size());
+	});
+
+	batch.Clear();
+	delete meshes[0];
+	delete meshes[1];
+}
@@ -0,0 +1,65 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include <vector>
+#include <glm\glm.hpp>
+#include "Material.h"
+
+class Mesh;
+
+/******************************************************************************/
+/*!
+		Class StaticBatch:
+\brief	Bakes props that never move into a few world-space meshes. Scenes
+		Add() each (mesh, transform) pair from Init(); Build() then reads
+		the source buffers back, transforms the vertices once and merges
+		every index run that shares a texture, material and lighting flag
+		into one mesh, so the whole set draws in a handful of calls.
+
+		Meshes may still be streaming when they are added; Build() returns
+		false and bakes nothing until every one of them is resident. The
+		baked meshes borrow the source textures, so the scene must keep its
+		meshes alive for as long as the batch.
+*/
+/******************************************************************************/
+class StaticBatch
+{
+public:
+	struct Batch
+	{
+		Mesh* mesh;			// world-space geometry; draw with an identity model
+		bool lightEnabled;
+	};
+
+	StaticBatch();
+	~StaticBatch();
+
+	// Record a prop drawn with mesh->material as it is now. Only triangle meshes can be merged
+	bool Add(Mesh* mesh, const glm::mat4& model, bool lightEnabled);
+	// Bake everything added, once all of it is resident; true when the batches are ready
+	bool Build();
+	// Delete the batches and forget every prop
+	void Clear();
+
+	bool IsBuilt() const { return built; }
+	const std::vector<Batch>& GetBatches() const { return batches; }
+	unsigned GetPropCount() const { return static_cast<unsigned>(props.size()); }
+
+private:
+	struct Prop
+	{
+		Mesh* mesh;
+		glm::mat4 model;
+		bool lightEnabled;
+		Material material;	// snapshot, as scenes retune mesh->material per draw
+	};
+
+	std::vector<Prop> props;
+	std::vector<Batch> batches;
+	bool built;
+};
+
+// Time props copies of two meshes drawn one call each against the baked batches
+void RunStaticBatchBenchmark(unsigned props);
+
+#endif
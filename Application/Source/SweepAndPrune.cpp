@@ -0,0 +1,242 @@
+#include "SweepAndPrune.h"
+#include "timer.h"
+#include <algorithm>
+#include <random>
+#include <iostream>
+#include <cmath>
+
+// How much more spread another axis needs before the sweep moves to it
+static const float SAP_AXIS_SWITCH = 1.2f;
+
+SweepAndPrune::SweepAndPrune()
+	: axis(0)
+	, ordered(false)
+	, shifts(0)
+	, tested(0)
+{
+}
+
+// Keep the order of the objects still there and append the new ones
+void SweepAndPrune::Resize(unsigned count)
+{
+	if (entries.size() == count)
+		return;
+
+	entries.erase(std::remove_if(entries.begin(), entries.end(),
+		[count](const Entry& entry) { return entry.index >= count; }), entries.end());
+	for (unsigned index = static_cast<unsigned>(entries.size()); index < count; ++index)
+	{
+		Entry entry;
+		entry.index = index;
+		entries.push_back(entry);
+		ordered = false;
+	}
+}
+
+const std::vector<SweepAndPrune::Pair>& SweepAndPrune::Update(const PhysicsObject* objects, unsigned count, const glm::vec3& halfExtent)
+{
+	Resize(count);
+	for (Entry& entry : entries)
+	{
+		const glm::vec3& pos = objects[entry.index].pos;
+		entry.min = pos - halfExtent;
+		entry.max = pos + halfExtent;
+	}
+	Sweep();
+	return pairs;
+}
+
+const std::vector<SweepAndPrune::Pair>& SweepAndPrune::Update(const PhysicsObject* objects, unsigned count)
+{
+	Resize(count);
+	for (Entry& entry : entries)
+	{
+		const PhysicsObject& obj = objects[entry.index];
+		glm::vec3 halfSize(obj.sizeX * 0.5f, obj.sizeY * 0.5f, obj.sizeZ * 0.5f);
+		entry.min = obj.pos - halfSize;
+		entry.max = obj.pos + halfSize;
+	}
+	Sweep();
+	return pairs;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Pick the axis, bring the kept order up to date and collect the pairs. The
+variance of the box centres decides the axis: the wider the objects are
+spread along it, the fewer intervals overlap. Sorting is by insertion, as
+last step's order is close to right, unless objects were added or the
+axis changed; the sweep then walks forward from each entry until the
+intervals stop overlapping.
+*/
+/******************************************************************************/
+void SweepAndPrune::Sweep()
+{
+	unsigned count = static_cast<unsigned>(entries.size());
+	shifts = 0;
+	tested = 0;
+	pairs.clear();
+	if (count < 2)
+		return;
+
+	glm::vec3 sum(0.f), sumSquared(0.f);
+	for (const Entry& entry : entries)
+	{
+		glm::vec3 center = (entry.min + entry.max) * 0.5f;
+		sum += center;
+		sumSquared += center * center;
+	}
+	glm::vec3 variance = sumSquared / float(count) - (sum / float(count)) * (sum / float(count));
+	int widest = variance.x >= variance.y ? (variance.x >= variance.z ? 0 : 2) : (variance.y >= variance.z ? 1 : 2);
+	if (variance[widest] > variance[axis] * SAP_AXIS_SWITCH)
+	{
+		axis = widest;
+		ordered = false;
+	}
+
+	// Unordered entries are far from their places, and insertion would take O(n^2)
+	if (!ordered)
+	{
+		int sortAxis = axis;
+		std::sort(entries.begin(), entries.end(),
+			[sortAxis](const Entry& a, const Entry& b) { return a.min[sortAxis] < b.min[sortAxis]; });
+		ordered = true;
+	}
+	for (unsigned i = 1; i < count; ++i)
+	{
+		if (entries[i - 1].min[axis] <= entries[i].min[axis])
+			continue;
+		Entry entry = entries[i];
+		unsigned j = i;
+		for (; j > 0 && entries[j - 1].min[axis] > entry.min[axis]; --j)
+			entries[j] = entries[j - 1];
+		shifts += i - j;
+		entries[j] = entry;
+	}
+
+	const int u = (axis + 1) % 3;
+	const int v = (axis + 2) % 3;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const Entry& a = entries[i];
+		for (unsigned j = i + 1; j < count && entries[j].min[axis] <= a.max[axis]; ++j)
+		{
+			const Entry& b = entries[j];
+			++tested;
+			if (a.min[u] <= b.max[u] && a.max[u] >= b.min[u] &&
+				a.min[v] <= b.max[v] && a.max[v] >= b.min[v])
+			{
+				Pair pair;
+				pair.a = std::min(a.index, b.index);
+				pair.b = std::max(a.index, b.index);
+				pairs.push_back(pair);
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Drop n balls into a pit sized to keep the same density for every n and
+step them under gravity, bouncing off the pit walls. Their pairs are found
+by checking every one and then by SweepAndPrune; both use the same box
+test, so the pair counts must match. Reports the broad phase time per step
+against a 144 FPS frame. Balls are not pushed apart, which keeps the two
+passes on identical states.
+
+\param maxBalls - largest n
+
+\return number of n where the pair counts differed
+*/
+/******************************************************************************/
+int RunSweepAndPruneBenchmark(unsigned maxBalls)
+{
+	const unsigned frames = 30;
+	const float dt = 1.f / 144.f;
+	const float radius = 1.f;
+	const float gravity = -10.f;
+	const glm::vec3 halfExtent(radius);
+
+	std::cout << "Frame budget at 144 FPS: " << 1000.0 / 144.0 << " ms\n";
+
+	int failures = 0;
+	StopWatch timer;
+	for (unsigned n = std::min(250u, maxBalls); n > 0; n = std::min(n * 2, maxBalls))
+	{
+		float side = 4.f * std::sqrt(float(n)) * radius;
+		std::mt19937 random(n);
+		std::uniform_real_distribution<float> across(-side * 0.5f, side * 0.5f);
+		std::uniform_real_distribution<float> height(radius, 20.f);
+		std::uniform_real_distribution<float> speed(-5.f, 5.f);
+
+		std::vector<PhysicsObject> start(n);
+		for (PhysicsObject& ball : start)
+		{
+			ball.mass = 2.f;
+			ball.pos = glm::vec3(across(random), height(random), across(random));
+			ball.vel = glm::vec3(speed(random), speed(random), speed(random));
+		}
+
+		double time[2] = { 0.0, 0.0 };
+		unsigned found[2] = { 0, 0 };
+		SweepAndPrune sweep;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			std::vector<PhysicsObject> balls = start;
+			for (unsigned frame = 0; frame < frames; ++frame)
+			{
+				for (PhysicsObject& ball : balls)
+				{
+					ball.AddForce(glm::vec3(0.f, gravity * ball.mass, 0.f));
+					ball.UpdatePhysics(dt);
+					for (int k = 0; k < 3; ++k)
+					{
+						float low = k == 1 ? radius : -side * 0.5f;
+						float high = k == 1 ? 1000.f : side * 0.5f;
+						if ((ball.pos[k] < low && ball.vel[k] < 0.f) || (ball.pos[k] > high && ball.vel[k] > 0.f))
+							ball.vel[k] = -ball.vel[k];
+					}
+				}
+
+				timer.startTimer();
+				if (pass == 0)
+				{
+					unsigned pairs = 0;
+					for (unsigned i = 0; i < n; ++i)
+					{
+						for (unsigned j = i + 1; j < n; ++j)
+						{
+							glm::vec3 minA = balls[i].pos - halfExtent, maxA = balls[i].pos + halfExtent;
+							glm::vec3 minB = balls[j].pos - halfExtent, maxB = balls[j].pos + halfExtent;
+							if (glm::all(glm::lessThanEqual(minA, maxB)) && glm::all(glm::greaterThanEqual(maxA, minB)))
+								++pairs;
+						}
+					}
+					found[pass] += pairs;
+				}
+				else
+				{
+					found[pass] += static_cast<unsigned>(sweep.Update(&balls[0], n, halfExtent).size());
+				}
+				time[pass] += timer.getElapsedTime();
+			}
+		}
+
+		std::cout << n << " balls: all pairs " << time[0] * 1000.0 / frames << " ms, "
+			<< "sweep and prune " << time[1] * 1000.0 / frames << " ms per step ("
+			<< found[0] / frames << " / " << found[1] / frames << " pairs, "
+			<< sweep.GetShiftCount() << " shifts in the last step)\n";
+		if (found[0] != found[1])
+		{
+			std::cout << "FAIL: sweep and prune found " << found[1] << " pairs over " << frames
+				<< " steps, all pairs found " << found[0] << "\n";
+			++failures;
+		}
+
+		if (n == maxBalls)
+			break;
+	}
+	return failures;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+#include "PhysicsObject.h"
+
+/******************************************************************************/
+/*!
+		Class SweepAndPrune:
+\brief	Sort-and-sweep broad phase for a scene's array of PhysicsObjects.
+		Each Update() projects the boxes onto the axis the objects are
+		spread along most, sorts them by their start on it and sweeps the
+		list once. Only boxes whose intervals overlap are compared on the
+		other two axes, and the pairs that overlap on all three come back.
+
+		The sorted order is kept between updates. Objects move little per
+		step, so the list is nearly sorted already and an insertion sort
+		puts it right in close to linear time. The axis is only changed
+		when another one is clearly better, as every switch, like adding
+		objects, costs a full sort.
+
+		One instance serves one array. It may change length between
+		updates; pairs refer to objects by their index in it.
+*/
+/******************************************************************************/
+class SweepAndPrune
+{
+public:
+	struct Pair
+	{
+		unsigned a;		// lower index
+		unsigned b;
+	};
+
+	SweepAndPrune();
+
+	// Pairs of objects whose boxes pos +- halfExtent overlap
+	const std::vector<Pair>& Update(const PhysicsObject* objects, unsigned count, const glm::vec3& halfExtent);
+	// As above, with each object's box pos +- size / 2
+	const std::vector<Pair>& Update(const PhysicsObject* objects, unsigned count);
+
+	const std::vector<Pair>& GetPairs() const { return pairs; }
+	int GetAxis() const { return axis; }
+	// Places the insertion sort moved entries by in the last Update
+	unsigned GetShiftCount() const { return shifts; }
+	// Interval overlaps the sweep checked on the other axes in the last Update
+	unsigned GetTestedCount() const { return tested; }
+
+private:
+	struct Entry
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		unsigned index;
+	};
+
+	void Resize(unsigned count);
+	void Sweep();
+
+	std::vector<Entry> entries;	// sorted by min[axis], kept between updates
+	std::vector<Pair> pairs;
+	int axis;
+	bool ordered;		// entries sorted on axis as of the last update
+	unsigned shifts;
+	unsigned tested;
+};
+
+// Step n balls in a pit, finding their pairs by testing all of them and by
+// SweepAndPrune, for n doubling from 250 up to maxBalls; non-zero if the two
+// find different pairs
+int RunSweepAndPruneBenchmark(unsigned maxBalls);
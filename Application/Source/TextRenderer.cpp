@@ -0,0 +1,284 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include "TextRenderer.h"
+#include <glm\gtc\matrix_transform.hpp>
+#include "LoadTGA.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+#include "AssetCache.h"
+#include "UniformBlocks.h"
+#include "DrawBenchmark.h"
+
+/******************************************************************************/
+/*!
+\brief
+Create the vertex buffer and measure the glyphs of the atlas
+
+\param font_path - TGA atlas the GenerateText mesh is textured with
+\param numRow - glyph rows in the atlas
+\param numCol - glyph columns in the atlas
+*/
+/******************************************************************************/
+TextRenderer::TextRenderer(const std::string& font_path, unsigned numRow, unsigned numCol)
+	: numRow(numRow)
+	, numCol(numCol)
+	, bufferCapacity(0)
+{
+	glGenVertexArrays(1, &vertexArray);
+	glGenBuffers(1, &vertexBuffer);
+
+	// Same layout as Mesh, so the Texture.vertexshader programs read it as is
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(glm::vec3));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(glm::vec3) + sizeof(glm::vec3) + sizeof(glm::vec3)));
+	glBindVertexArray(0);
+
+	MeasureGlyphs(font_path);
+}
+
+TextRenderer::~TextRenderer()
+{
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Find the inked columns of every glyph cell. A glyph is inked where its alpha
+(or, for 24-bit atlases, its brightest channel) is above a small threshold;
+cells with no ink, like the space, only move the pen.
+
+\param font_path - TGA atlas; read raw, as cooked atlases are compressed
+*/
+/******************************************************************************/
+void TextRenderer::MeasureGlyphs(const std::string& font_path)
+{
+	// Fixed-width fallback: the whole cell, 0.6 apart as RenderTextOnScreen had it
+	for (unsigned c = 0; c < 256; ++c)
+	{
+		glyphs[c].left = 0.f;
+		glyphs[c].right = 1.f;
+		glyphs[c].advance = 0.6f;
+	}
+
+	TGAImage image;
+	if (!DecodeTGA(font_path.c_str(), image, false) || image.bytesPerPixel < 3)
+		return;
+
+	const unsigned cellWidth = image.width / numCol;
+	const unsigned cellHeight = image.height / numRow;
+	const unsigned bpp = image.bytesPerPixel;
+	const GLubyte threshold = 32;
+	const float gap = 0.08f;		// between inked columns of neighbouring glyphs
+	const float spaceAdvance = 0.3f;
+
+	for (unsigned c = 0; c < 256 && c < numRow * numCol; ++c)
+	{
+		unsigned row = c / numCol;
+		unsigned col = c % numCol;
+		// TGA rows run bottom-up, like the texture coordinates
+		unsigned y0 = (numRow - 1 - row) * cellHeight;
+		unsigned x0 = col * cellWidth;
+
+		unsigned minX = cellWidth;
+		unsigned maxX = 0;
+		for (unsigned y = y0; y < y0 + cellHeight; ++y)
+		{
+			const GLubyte* pixel = &image.data[(static_cast<size_t>(y) * image.width + x0) * bpp];
+			for (unsigned x = 0; x < cellWidth; ++x, pixel += bpp)
+			{
+				GLubyte ink = bpp == 4 ? pixel[3] : std::max(pixel[0], std::max(pixel[1], pixel[2]));
+				if (ink > threshold)
+				{
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+				}
+			}
+		}
+
+		if (minX > maxX)
+		{
+			glyphs[c].left = glyphs[c].right = 0.f;
+			glyphs[c].advance = spaceAdvance;
+			continue;
+		}
+		glyphs[c].left = static_cast<float>(minX) / cellWidth;
+		glyphs[c].right = static_cast<float>(maxX + 1) / cellWidth;
+		glyphs[c].advance = glyphs[c].right - glyphs[c].left + gap;
+	}
+}
+
+void TextRenderer::Add(const std::string& text, const glm::vec3& color, float size, float x, float y)
+{
+	Add(text.c_str(), color, size, x, y);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Append one quad per inked glyph of text. Quads are cropped to the glyph's
+ink, so proportional glyphs never overlap their neighbours.
+
+\param text - string to draw, one atlas cell per byte
+\param color - glyph colour, multiplied with textColor by the shader
+\param size - glyph height
+\param x - left edge of the first glyph
+\param y - bottom of the text line
+*/
+/******************************************************************************/
+void TextRenderer::Add(const char* text, const glm::vec3& color, float size, float x, float y)
+{
+	const float cellU = 1.f / numCol;
+	const float cellV = 1.f / numRow;
+	// The cell sits slightly below the line, as the old 0.4 offset placed it
+	const float bottom = y - 0.1f * size;
+	const float top = bottom + size;
+
+	Vertex v;
+	v.color = color;
+	v.normal = glm::vec3(0, 0, 1);
+
+	float pen = x;
+	for (const char* it = text; *it; ++it)
+	{
+		unsigned c = static_cast<unsigned char>(*it);
+		const Glyph& glyph = glyphs[c];
+		if (glyph.right > glyph.left)
+		{
+			unsigned row = c / numCol;
+			unsigned col = c % numCol;
+			float left = pen;
+			float right = pen + (glyph.right - glyph.left) * size;
+			float u0 = (col + glyph.left) * cellU;
+			float u1 = (col + glyph.right) * cellU;
+			float v0 = (numRow - 1 - row) * cellV;
+			float v1 = (numRow - row) * cellV;
+
+			// Same winding as the GenerateText quads
+			v.pos = glm::vec3(right, top, 0.f); v.texCoord = glm::vec2(u1, v1); vertices.push_back(v);
+			v.pos = glm::vec3(left, top, 0.f); v.texCoord = glm::vec2(u0, v1); vertices.push_back(v);
+			v.pos = glm::vec3(left, bottom, 0.f); v.texCoord = glm::vec2(u0, v0); vertices.push_back(v);
+			v.pos = glm::vec3(right, top, 0.f); v.texCoord = glm::vec2(u1, v1); vertices.push_back(v);
+			v.pos = glm::vec3(left, bottom, 0.f); v.texCoord = glm::vec2(u0, v0); vertices.push_back(v);
+			v.pos = glm::vec3(right, bottom, 0.f); v.texCoord = glm::vec2(u1, v0); vertices.push_back(v);
+		}
+		pen += glyph.advance * size;
+	}
+}
+
+float TextRenderer::GetWidth(const char* text, float size) const
+{
+	float width = 0.f;
+	for (const char* it = text; *it; ++it)
+		width += glyphs[static_cast<unsigned char>(*it)].advance * size;
+	return width;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw every quad queued since the last Draw in one call. The buffer is
+orphaned first so the upload never waits on the previous frame's draw, and
+only grows, so steady HUD text stops reallocating after the first frame.
+*/
+/******************************************************************************/
+void TextRenderer::Draw()
+{
+	if (vertices.empty())
+		return;
+
+	unsigned count = static_cast<unsigned>(vertices.size());
+	if (count > bufferCapacity)
+		bufferCapacity = count;
+
+	glBindVertexArray(vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Vertex), &vertices[0]);
+	glDrawArrays(GL_TRIANGLES, 0, count);
+
+	vertices.clear();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Draw lines of HUD text totalling chars characters, first the way the scenes
+did (one uniform upload and one draw per character) and then through a
+TextRenderer, and report the frame time of each. Needs a current GL context.
+
+\param chars - characters per frame
+*/
+/******************************************************************************/
+void RunTextBenchmark(unsigned chars)
+{
+	const unsigned lineLength = 60;
+	const float size = 12.f;
+	const char* font_path = "Images//Georgia.tga";
+
+	DrawBenchmark benchmark;
+	glUniform1i(benchmark.GetUniform("lightEnabled"), 0);
+	glUniform1i(benchmark.GetUniform("textEnabled"), 1);
+	glUniform3f(benchmark.GetUniform("textColor"), 1.f, 1.f, 1.f);
+	glUniform1i(benchmark.GetUniform("colorTextureEnabled"), 1);
+	glUniform1i(benchmark.GetUniform("colorTexture"), 0);
+	GLint locationModel = benchmark.GetUniform("model");
+	const glm::mat4 identity(1.f);
+
+	Mesh* font = MeshBuilder::GenerateText("text", 16, 16);
+	font->textureID = AssetCache::GetInstance()->AcquireTexture(font_path);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, font->textureID);
+	TextRenderer text(font_path, 16, 16);
+
+	std::vector<std::string> lines;
+	for (unsigned written = 0; written < chars; written += lineLength)
+	{
+		char line[lineLength + 1];
+		snprintf(line, sizeof(line), "Line %04u FPS:60.00 CPU:1.25ms Draws:42 Culled:17/96 ........", (unsigned)lines.size());
+		line[std::min(lineLength, chars - written)] = '\0';
+		lines.push_back(line);
+	}
+
+	UniformBlocks::GetInstance()->SetCamera(glm::mat4(1.f), glm::ortho(0.f, 800.f, 0.f, 600.f, -100.f, 100.f));
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	benchmark.Run("One draw per character: ", "draw calls", [&]() {
+		for (unsigned i = 0; i < lines.size(); ++i)
+		{
+			float y = 590.f - (i % 50) * size;
+			const std::string& line = lines[i];
+			for (unsigned c = 0; c < line.length(); ++c)
+			{
+				glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(5.f, y, 0.f));
+				model = glm::scale(model, glm::vec3(size, size, size));
+				model = glm::translate(model, glm::vec3(0.5f + c * 0.6f, 0.4f, 0.f));
+				glUniformMatrix4fv(locationModel, 1, GL_FALSE, &model[0][0]);
+				font->Render((unsigned)line[c] * 6, 6);
+			}
+		}
+		return chars;
+	});
+	benchmark.Run("TextRenderer: ", "draw calls", [&]() {
+		for (unsigned i = 0; i < lines.size(); ++i)
+			text.Add(lines[i], glm::vec3(1.f, 1.f, 1.f), size, 5.f, 590.f - (i % 50) * size);
+		glUniformMatrix4fv(locationModel, 1, GL_FALSE, &identity[0][0]);
+		text.Draw();
+		return 1u;
+	});
+
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	delete font; // releases the texture too
+}
@@ -0,0 +1,65 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "Vertex.h"
+
+/******************************************************************************/
+/*!
+		Class TextRenderer:
+\brief	Lays out strings as glyph quads from a GenerateText-style font atlas
+		and draws everything added since the last Draw with one call from a
+		single dynamic vertex buffer.
+
+		Glyph widths are measured from the atlas once, so text is spaced
+		proportionally; without a readable atlas file every glyph gets the
+		old fixed 0.6 advance. The glyph colour goes in the vertex colour,
+		so strings of different colours still share one draw.
+
+		Binding the atlas texture and setting the text uniforms is left to
+		the caller, as with Mesh::Render.
+*/
+/******************************************************************************/
+class TextRenderer
+{
+public:
+	TextRenderer(const std::string& font_path, unsigned numRow, unsigned numCol);
+	~TextRenderer();
+
+	// Queue text with its lower-left corner at (x, y); size is the glyph height
+	void Add(const char* text, const glm::vec3& color, float size, float x, float y);
+	void Add(const std::string& text, const glm::vec3& color, float size, float x, float y);
+	// Upload and draw everything queued, then clear the queue
+	void Draw();
+
+	float GetWidth(const char* text, float size) const;
+	unsigned GetQueuedCount() const { return static_cast<unsigned>(vertices.size() / 6); }
+
+private:
+	struct Glyph
+	{
+		float left;		// ink columns, as a fraction of the cell width
+		float right;
+		float advance;	// pen movement, in glyph heights
+	};
+
+	void MeasureGlyphs(const std::string& font_path);
+
+	unsigned numRow;
+	unsigned numCol;
+	Glyph glyphs[256];
+
+	GLuint vertexArray;
+	GLuint vertexBuffer;
+	unsigned bufferCapacity;		// vertices the buffer has room for
+	std::vector<Vertex> vertices;	// 6 per glyph, in the order they are drawn
+};
+
+// Time chars characters of HUD text per frame, drawn one character per call
+// and then with a single TextRenderer draw
+void RunTextBenchmark(unsigned chars);
+
+#endif
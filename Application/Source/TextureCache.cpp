@@ -0,0 +1,603 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "TextureCache.h"
+#include "timer.h"
+
+// DDS layout: "DDS ", header, then every mip level from largest to smallest.
+// Rows are stored bottom-up like the TGAs they come from, which is the order
+// GL expects, so other DDS viewers show cooked files upside down.
+static const char DDS_MAGIC[4] = { 'D', 'D', 'S', ' ' };
+static const unsigned DDSD_CAPS = 0x1;
+static const unsigned DDSD_HEIGHT = 0x2;
+static const unsigned DDSD_WIDTH = 0x4;
+static const unsigned DDSD_PIXELFORMAT = 0x1000;
+static const unsigned DDSD_MIPMAPCOUNT = 0x20000;
+static const unsigned DDSD_LINEARSIZE = 0x80000;
+static const unsigned DDPF_FOURCC = 0x4;
+static const unsigned DDSCAPS_COMPLEX = 0x8;
+static const unsigned DDSCAPS_TEXTURE = 0x1000;
+static const unsigned DDSCAPS_MIPMAP = 0x400000;
+
+struct DDSPixelFormat
+{
+	unsigned size;
+	unsigned flags;
+	char fourCC[4];
+	unsigned rgbBitCount;
+	unsigned rBitMask;
+	unsigned gBitMask;
+	unsigned bBitMask;
+	unsigned aBitMask;
+};
+
+struct DDSHeader
+{
+	unsigned size;
+	unsigned flags;
+	unsigned height;
+	unsigned width;
+	unsigned pitchOrLinearSize;
+	unsigned depth;
+	unsigned mipMapCount;
+	unsigned reserved1[11];	// [0], [1]: write time of the source TGA
+	DDSPixelFormat pixelFormat;
+	unsigned caps;
+	unsigned caps2;
+	unsigned caps3;
+	unsigned caps4;
+	unsigned reserved2;
+};
+
+// RGBA pixel used while cooking
+struct Texel
+{
+	GLubyte r, g, b, a;
+};
+
+CookedTexture::CookedTexture()
+	: levels(nullptr)
+	, format(0)
+	, width(0)
+	, height(0)
+	, levelCount(0)
+{
+}
+
+/******************************************************************************/
+/*!
+\brief
+Map a cooked texture and check that it is still up to date
+
+\param dds_path - cooked file
+\param tga_path - TGA it was cooked from
+
+\return true if the file is valid and newer than the TGA it came from
+*/
+/******************************************************************************/
+bool CookedTexture::Open(const char* dds_path, const char* tga_path)
+{
+	Close();
+	if (!file.Open(dds_path))
+		return false;
+
+	const char* data = file.Data();
+	DDSHeader header;
+	if (file.Size() < sizeof(DDS_MAGIC) + sizeof(header) || memcmp(data, DDS_MAGIC, sizeof(DDS_MAGIC)) != 0)
+	{
+		Close();
+		return false;
+	}
+	memcpy(&header, data + sizeof(DDS_MAGIC), sizeof(header));
+
+	unsigned long long writeTime = (static_cast<unsigned long long>(header.reserved1[1]) << 32) | header.reserved1[0];
+	if (header.size != sizeof(DDSHeader) ||
+		!(header.pixelFormat.flags & DDPF_FOURCC) ||
+		writeTime != GetFileWriteTime(tga_path) ||
+		header.width == 0 || header.height == 0 || header.mipMapCount == 0)
+	{
+		Close();
+		return false;
+	}
+
+	if (memcmp(header.pixelFormat.fourCC, "DXT1", 4) == 0)
+		format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if (memcmp(header.pixelFormat.fourCC, "DXT5", 4) == 0)
+		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	else
+	{
+		Close();
+		return false;
+	}
+
+	width = header.width;
+	height = header.height;
+	levelCount = header.mipMapCount;
+	levels = reinterpret_cast<const GLubyte*>(data + sizeof(DDS_MAGIC) + sizeof(header));
+
+	// Truncated file?
+	size_t levelBytes = 0;
+	for (unsigned level = 0; level < levelCount; ++level)
+		levelBytes += GetCompressedLevelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+	if (levelBytes > file.Size() - sizeof(DDS_MAGIC) - sizeof(header))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void CookedTexture::Close()
+{
+	file.Close();
+	levels = nullptr;
+	format = 0;
+	width = height = levelCount = 0;
+}
+
+/******************************************************************************/
+/*!
+\brief
+Find one mip level in the mapped file
+
+\param level - mip level, 0 is the largest
+\param out_width - width of the level in pixels
+\param out_height - height of the level in pixels
+\param out_size - bytes of compressed data
+
+\return Pointer to the level's blocks
+*/
+/******************************************************************************/
+const GLubyte* CookedTexture::Level(unsigned level, unsigned& out_width, unsigned& out_height, unsigned& out_size) const
+{
+	const GLubyte* data = levels;
+	for (unsigned i = 0; i < level; ++i)
+		data += GetCompressedLevelSize(format, std::max(width >> i, 1u), std::max(height >> i, 1u));
+
+	out_width = std::max(width >> level, 1u);
+	out_height = std::max(height >> level, 1u);
+	out_size = GetCompressedLevelSize(format, out_width, out_height);
+	return data;
+}
+
+void CookedTexture::GetImage(TGAImage& out_image) const
+{
+	unsigned levelWidth, levelHeight, levelSize;
+	const GLubyte* last = Level(levelCount - 1, levelWidth, levelHeight, levelSize);
+
+	out_image.width = width;
+	out_image.height = height;
+	out_image.bytesPerPixel = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 3 : 4;
+	out_image.compressedFormat = format;
+	out_image.levelCount = levelCount;
+	out_image.data.assign(levels, last + levelSize);
+}
+
+// Replace the extension of a TGA path with .dds
+std::string GetCookedTexturePath(const std::string& tga_path)
+{
+	size_t dot = tga_path.find_last_of('.');
+	size_t slash = tga_path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return tga_path + ".dds";
+	return tga_path.substr(0, dot) + ".dds";
+}
+
+unsigned GetCompressedLevelSize(GLenum format, unsigned width, unsigned height)
+{
+	unsigned blockBytes = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+	return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+static unsigned short PackRGB565(const float color[3])
+{
+	unsigned r = static_cast<unsigned>(std::min(std::max(color[0], 0.f), 255.f) * 31.f / 255.f + 0.5f);
+	unsigned g = static_cast<unsigned>(std::min(std::max(color[1], 0.f), 255.f) * 63.f / 255.f + 0.5f);
+	unsigned b = static_cast<unsigned>(std::min(std::max(color[2], 0.f), 255.f) * 31.f / 255.f + 0.5f);
+	return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(unsigned short packed, float color[3])
+{
+	color[0] = static_cast<float>(((packed >> 11) & 31) * 255 / 31);
+	color[1] = static_cast<float>(((packed >> 5) & 63) * 255 / 63);
+	color[2] = static_cast<float>((packed & 31) * 255 / 31);
+}
+
+// Quantize two end points to RGB565 and give each texel its closest of the
+// four palette colours. Returns the squared error of the block
+static float FitColorEndPoints(const Texel block[16], const float end0[3], const float end1[3],
+	unsigned short& out_color0, unsigned short& out_color1, unsigned& out_indices)
+{
+	out_color0 = PackRGB565(end0);
+	out_color1 = PackRGB565(end1);
+
+	// color0 > color1 selects the four-colour mode
+	if (out_color0 < out_color1)
+		std::swap(out_color0, out_color1);
+
+	float palette[4][3];
+	UnpackRGB565(out_color0, palette[0]);
+	UnpackRGB565(out_color1, palette[1]);
+	for (unsigned c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+		palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+	}
+
+	// Equal end points mean three-colour mode, where only index 0 is safe
+	unsigned paletteSize = out_color0 != out_color1 ? 4 : 1;
+	float totalError = 0.f;
+	out_indices = 0;
+	for (unsigned i = 0; i < 16; ++i)
+	{
+		unsigned best = 0;
+		float bestError = 1e30f;
+		for (unsigned p = 0; p < paletteSize; ++p)
+		{
+			float dr = block[i].r - palette[p][0], dg = block[i].g - palette[p][1], db = block[i].b - palette[p][2];
+			float error = dr * dr + dg * dg + db * db;
+			if (error < bestError)
+			{
+				bestError = error;
+				best = p;
+			}
+		}
+		out_indices |= best << (2 * i);
+		totalError += bestError;
+	}
+	return totalError;
+}
+
+// BC1 colour block: two RGB565 end points along the block's principal axis
+// and a 2-bit index per texel into the four colours between them
+static void EncodeColorBlock(const Texel block[16], GLubyte* out)
+{
+	float mean[3] = { 0.f, 0.f, 0.f };
+	for (unsigned i = 0; i < 16; ++i)
+	{
+		mean[0] += block[i].r;
+		mean[1] += block[i].g;
+		mean[2] += block[i].b;
+	}
+	for (unsigned c = 0; c < 3; ++c)
+		mean[c] /= 16.f;
+
+	float covariance[6] = {};	// rr, rg, rb, gg, gb, bb
+	for (unsigned i = 0; i < 16; ++i)
+	{
+		float r = block[i].r - mean[0], g = block[i].g - mean[1], b = block[i].b - mean[2];
+		covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+		covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+	}
+
+	// Power iteration for the principal axis
+	float axis[3] = { 1.f, 1.f, 1.f };
+	for (unsigned iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+		};
+		float length = std::max(std::max(fabsf(next[0]), fabsf(next[1])), fabsf(next[2]));
+		if (length < 1e-6f)
+			break;
+		for (unsigned c = 0; c < 3; ++c)
+			axis[c] = next[c] / length;
+	}
+
+	float minT = 0.f, maxT = 0.f;
+	for (unsigned i = 0; i < 16; ++i)
+	{
+		float t = (block[i].r - mean[0]) * axis[0] + (block[i].g - mean[1]) * axis[1] + (block[i].b - mean[2]) * axis[2];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	float axisLengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	if (axisLengthSq > 0.f)
+	{
+		minT /= axisLengthSq;
+		maxT /= axisLengthSq;
+	}
+
+	float end0[3], end1[3];
+	for (unsigned c = 0; c < 3; ++c)
+	{
+		end0[c] = mean[c] + axis[c] * maxT;
+		end1[c] = mean[c] + axis[c] * minT;
+	}
+	unsigned short color0, color1;
+	unsigned indices;
+	float error = FitColorEndPoints(block, end0, end1, color0, color1, indices);
+
+	// One least-squares pass: move the end points to best fit the texels
+	// given the indices they were assigned, keep it if the error drops
+	float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };	// share of color0 per index
+	float aa = 0.f, ab = 0.f, bb = 0.f, ax[3] = {}, bx[3] = {};
+	for (unsigned i = 0; i < 16 && color0 != color1; ++i)
+	{
+		float alpha = weights[(indices >> (2 * i)) & 3], beta = 1.f - alpha;
+		const float texel[3] = { (float)block[i].r, (float)block[i].g, (float)block[i].b };
+		aa += alpha * alpha; ab += alpha * beta; bb += beta * beta;
+		for (unsigned c = 0; c < 3; ++c)
+		{
+			ax[c] += alpha * texel[c];
+			bx[c] += beta * texel[c];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	if (color0 != color1 && fabsf(determinant) > 1e-6f)
+	{
+		float refined0[3], refined1[3];
+		for (unsigned c = 0; c < 3; ++c)
+		{
+			refined0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			refined1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+		unsigned short refinedColor0, refinedColor1;
+		unsigned refinedIndices;
+		float refinedError = FitColorEndPoints(block, refined0, refined1, refinedColor0, refinedColor1, refinedIndices);
+		if (refinedError < error)
+		{
+			color0 = refinedColor0;
+			color1 = refinedColor1;
+			indices = refinedIndices;
+		}
+	}
+
+	out[0] = static_cast<GLubyte>(color0 & 0xFF);
+	out[1] = static_cast<GLubyte>(color0 >> 8);
+	out[2] = static_cast<GLubyte>(color1 & 0xFF);
+	out[3] = static_cast<GLubyte>(color1 >> 8);
+	for (unsigned b = 0; b < 4; ++b)
+		out[4 + b] = static_cast<GLubyte>(indices >> (8 * b));
+}
+
+// BC3 alpha block: two 8-bit end points and a 3-bit index per texel into the
+// eight values between them
+static void EncodeAlphaBlock(const Texel block[16], GLubyte* out)
+{
+	GLubyte alpha0 = 0, alpha1 = 255;
+	for (unsigned i = 0; i < 16; ++i)
+	{
+		alpha0 = std::max(alpha0, block[i].a);
+		alpha1 = std::min(alpha1, block[i].a);
+	}
+
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1)
+	{
+		float palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (unsigned p = 1; p < 7; ++p)
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7.f;
+
+		for (unsigned i = 0; i < 16; ++i)
+		{
+			unsigned best = 0;
+			float bestError = 1e30f;
+			for (unsigned p = 0; p < 8; ++p)
+			{
+				float error = fabsf(block[i].a - palette[p]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+			indices |= static_cast<unsigned long long>(best) << (3 * i);
+		}
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+	for (unsigned b = 0; b < 6; ++b)
+		out[2 + b] = static_cast<GLubyte>(indices >> (8 * b));
+}
+
+// Compress one mip level; texels past the right or top edge repeat the edge
+static void EncodeLevel(const std::vector<Texel>& texels, unsigned width, unsigned height, GLenum format, std::vector<GLubyte>& out_data)
+{
+	Texel block[16];
+	for (unsigned by = 0; by < height; by += 4)
+	{
+		for (unsigned bx = 0; bx < width; bx += 4)
+		{
+			for (unsigned y = 0; y < 4; ++y)
+			{
+				for (unsigned x = 0; x < 4; ++x)
+				{
+					unsigned sx = std::min(bx + x, width - 1);
+					unsigned sy = std::min(by + y, height - 1);
+					block[y * 4 + x] = texels[sy * width + sx];
+				}
+			}
+
+			size_t offset = out_data.size();
+			if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+			{
+				out_data.resize(offset + 8);
+				EncodeColorBlock(block, &out_data[offset]);
+			}
+			else
+			{
+				out_data.resize(offset + 16);
+				EncodeAlphaBlock(block, &out_data[offset]);
+				EncodeColorBlock(block, &out_data[offset + 8]);
+			}
+		}
+	}
+}
+
+// 2x2 box filter; an odd last row or column folds into its neighbour
+static void Downsample(const std::vector<Texel>& src, unsigned width, unsigned height, std::vector<Texel>& dst)
+{
+	unsigned dstWidth = std::max(width / 2, 1u);
+	unsigned dstHeight = std::max(height / 2, 1u);
+	dst.resize(static_cast<size_t>(dstWidth) * dstHeight);
+	for (unsigned y = 0; y < dstHeight; ++y)
+	{
+		for (unsigned x = 0; x < dstWidth; ++x)
+		{
+			unsigned x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			unsigned y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+			const Texel& a = src[y0 * width + x0];
+			const Texel& b = src[y0 * width + x1];
+			const Texel& c = src[y1 * width + x0];
+			const Texel& d = src[y1 * width + x1];
+			Texel& t = dst[y * dstWidth + x];
+			t.r = static_cast<GLubyte>((a.r + b.r + c.r + d.r + 2) / 4);
+			t.g = static_cast<GLubyte>((a.g + b.g + c.g + d.g + 2) / 4);
+			t.b = static_cast<GLubyte>((a.b + b.b + c.b + d.b + 2) / 4);
+			t.a = static_cast<GLubyte>((a.a + b.a + c.a + d.a + 2) / 4);
+		}
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Cook a TGA into a .dds next to it: box-filtered mips, compressed to BC1, or
+BC3 when the image has alpha other than 255
+
+\param tga_path - TGA file
+
+\return true if the cooked file was written
+*/
+/******************************************************************************/
+bool CookTGA(const char* tga_path)
+{
+	TGAImage image;
+	if (!DecodeTGA(tga_path, image, false))
+		return false;
+
+	// BGR(A) -> RGBA
+	std::vector<Texel> texels(static_cast<size_t>(image.width) * image.height);
+	bool opaque = true;
+	for (size_t i = 0; i < texels.size(); ++i)
+	{
+		const GLubyte* pixel = &image.data[i * image.bytesPerPixel];
+		texels[i].r = pixel[2];
+		texels[i].g = pixel[1];
+		texels[i].b = pixel[0];
+		texels[i].a = image.bytesPerPixel == 4 ? pixel[3] : 255;
+		opaque = opaque && texels[i].a == 255;
+	}
+	GLenum format = opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	std::vector<GLubyte> blocks;
+	unsigned width = image.width, height = image.height, levelCount = 1;
+	std::vector<Texel> smaller;
+	while (true)
+	{
+		EncodeLevel(texels, width, height, format, blocks);
+		if (width == 1 && height == 1)
+			break;
+		Downsample(texels, width, height, smaller);
+		texels.swap(smaller);
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+		++levelCount;
+	}
+
+	DDSHeader header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = image.height;
+	header.width = image.width;
+	header.pitchOrLinearSize = GetCompressedLevelSize(format, image.width, image.height);
+	header.mipMapCount = levelCount;
+	unsigned long long writeTime = GetFileWriteTime(tga_path);
+	header.reserved1[0] = static_cast<unsigned>(writeTime & 0xFFFFFFFF);
+	header.reserved1[1] = static_cast<unsigned>(writeTime >> 32);
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = DDPF_FOURCC;
+	memcpy(header.pixelFormat.fourCC, opaque ? "DXT1" : "DXT5", 4);
+	header.caps = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+
+	std::string dds_path = GetCookedTexturePath(tga_path);
+	std::ofstream out(dds_path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		std::cout << "Impossible to write " << dds_path << "\n";
+		return false;
+	}
+	out.write(DDS_MAGIC, sizeof(DDS_MAGIC));
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(&blocks[0]), blocks.size());
+	return out.good();
+}
+
+/******************************************************************************/
+/*!
+\brief
+Offline entry point: cook every TGA given on the command line, or found in
+a folder given on the command line, and report the GPU memory and load time
+of the TGA against the cooked file.
+
+\param argc - number of paths
+\param argv - TGA files or folders
+
+\return Number of files that failed to cook
+*/
+/******************************************************************************/
+int RunTextureCooker(int argc, char* argv[])
+{
+	std::vector<std::string> files;
+	for (int i = 0; i < argc; ++i)
+	{
+		std::string path = argv[i];
+		if (path.size() > 4 && _stricmp(path.c_str() + path.size() - 4, ".tga") == 0)
+			files.push_back(path);
+		else
+			CollectTGAFiles(path, files);
+	}
+
+	int failures = 0;
+	double totalTGABytes = 0.0, totalCookedBytes = 0.0;
+	StopWatch timer;
+	for (const std::string& path : files)
+	{
+		if (!CookTGA(path.c_str()))
+		{
+			std::cout << "Failed to cook " << path << "\n";
+			++failures;
+			continue;
+		}
+
+		timer.startTimer();
+		TGAImage image;
+		DecodeTGA(path.c_str(), image, false);
+		double tgaTime = timer.getElapsedTime();
+
+		CookedTexture cooked;
+		TGAImage cookedImage;
+		if (!cooked.Open(GetCookedTexturePath(path).c_str(), path.c_str()))
+		{
+			std::cout << "Failed to reload cooked " << path << "\n";
+			++failures;
+			continue;
+		}
+		cooked.GetImage(cookedImage);
+		double cookedTime = timer.getElapsedTime();
+
+		// Uncompressed textures are padded to 4 bytes a texel by most drivers,
+		// plus a third again for the mips glGenerateMipmap builds
+		double tgaBytes = image.width * image.height * 4.0 * 4.0 / 3.0;
+		double cookedBytes = static_cast<double>(cookedImage.data.size());
+		totalTGABytes += tgaBytes;
+		totalCookedBytes += cookedBytes;
+		std::cout << path << ": " << (cooked.Format() == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? "BC1" : "BC3") << ", "
+			<< tgaBytes / 1024.0 << " KB -> " << cookedBytes / 1024.0 << " KB, "
+			<< "TGA load " << tgaTime * 1000.0 << " ms, cooked load " << cookedTime * 1000.0 << " ms\n";
+	}
+	if (totalCookedBytes > 0.0)
+		std::cout << "GPU memory " << totalTGABytes / (1024.0 * 1024.0) << " MB -> " << totalCookedBytes / (1024.0 * 1024.0) << " MB\n";
+	return failures;
+}
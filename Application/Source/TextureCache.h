@@ -0,0 +1,53 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <string>
+#include <GL\glew.h>
+#include "MappedFile.h"
+#include "LoadTGA.h"
+
+/******************************************************************************/
+/*!
+		Class CookedTexture:
+\brief	Read-only view of a cooked .dds file: a BC1 (opaque) or BC3 (alpha)
+		block-compressed image with its full mip chain, made from a TGA.
+		The file is memory-mapped, so Level() can be handed to
+		glCompressedTexImage2D directly.
+*/
+/******************************************************************************/
+class CookedTexture
+{
+public:
+	CookedTexture();
+
+	bool Open(const char* dds_path, const char* tga_path);
+	void Close();
+
+	GLenum Format() const { return format; }
+	unsigned Width() const { return width; }
+	unsigned Height() const { return height; }
+	unsigned LevelCount() const { return levelCount; }
+	const GLubyte* Level(unsigned level, unsigned& out_width, unsigned& out_height, unsigned& out_size) const;
+
+	// Copy every level into image, for uploading later with UploadTGA
+	void GetImage(TGAImage& out_image) const;
+
+private:
+	MappedFile file;
+	const GLubyte* levels;
+	GLenum format;
+	unsigned width;
+	unsigned height;
+	unsigned levelCount;
+};
+
+std::string GetCookedTexturePath(const std::string& tga_path);
+
+// Bytes of one mip level in a block-compressed format
+unsigned GetCompressedLevelSize(GLenum format, unsigned width, unsigned height);
+
+bool CookTGA(const char* tga_path);
+
+int RunTextureCooker(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstring>
+#include "UniformBlocks.h"
+
+UniformBlocks* UniformBlocks::m_instance = nullptr;
+
+static const char* BLOCK_NAMES[] = { "CameraBlock", "LightBlock", "MaterialBlock" };
+
+UniformBlocks::UniformBlocks(void)
+	: cameraValid(false)
+	, lightsValid(false)
+	, materialValid(false)
+	, uploads(0)
+{
+	const GLsizeiptr sizes[] = { sizeof(CameraBlock), sizeof(LightBlock), sizeof(MaterialBlock) };
+	glGenBuffers(3, buffers);
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffers[i]);
+		glBufferData(GL_UNIFORM_BUFFER, sizes[i], NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, i, buffers[i]);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	memset(&camera, 0, sizeof(camera));
+	memset(&lights, 0, sizeof(lights));
+	memset(&material, 0, sizeof(material));
+}
+
+UniformBlocks::~UniformBlocks(void)
+{
+	glDeleteBuffers(3, buffers);
+}
+
+UniformBlocks* UniformBlocks::GetInstance(void)
+{
+	if (m_instance == nullptr) {
+		m_instance = new UniformBlocks();
+	}
+
+	return m_instance;
+}
+
+void UniformBlocks::DestroyInstance(void)
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+/******************************************************************************/
+/*!
+\brief
+Attach every block the program declares to its shared binding point.
+Blocks a program does not use are skipped.
+
+\param programID - linked program
+*/
+/******************************************************************************/
+void UniformBlocks::BindProgram(GLuint programID)
+{
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		GLuint index = glGetUniformBlockIndex(programID, BLOCK_NAMES[i]);
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(programID, index, i);
+	}
+}
+
+template<typename T>
+void UniformBlocks::Upload(GLuint buffer, T& cached, const T& data, bool& valid)
+{
+	if (valid && memcmp(&cached, &data, sizeof(T)) == 0)
+		return;
+
+	cached = data;
+	valid = true;
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	++uploads;
+}
+
+void UniformBlocks::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+{
+	CameraBlock data;
+	data.view = view;
+	data.projection = projection;
+	Upload(buffers[BINDING_CAMERA], camera, data, cameraValid);
+}
+
+/******************************************************************************/
+/*!
+\brief
+Upload the scene's lights for one view. Directional lights keep their
+position as a direction; spot cut-off angles are given in degrees.
+
+\param lights - the scene's light array
+\param count - number of lights, at most MAX_LIGHTS
+\param view - view matrix the light positions are moved by
+*/
+/******************************************************************************/
+void UniformBlocks::SetLights(const Light* lights, unsigned count, const glm::mat4& view)
+{
+	LightBlock data;
+	memset(&data, 0, sizeof(data));
+	data.numLights = count < MAX_LIGHTS ? count : MAX_LIGHTS;
+	for (int i = 0; i < data.numLights; ++i)
+	{
+		const Light& light = lights[i];
+		LightData& out = data.lights[i];
+		float w = light.type == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f;
+		out.position_cameraspace = glm::vec3(view * glm::vec4(light.position, w));
+		out.power = light.power;
+		out.color = light.color;
+		out.kC = light.kC;
+		out.spotDirection = glm::vec3(view * glm::vec4(light.spotDirection, 0.f));
+		out.kL = light.kL;
+		out.type = light.type;
+		out.kQ = light.kQ;
+		out.cosCutoff = cosf(glm::radians<float>(light.cosCutoff));
+		out.cosInner = cosf(glm::radians<float>(light.cosInner));
+		out.exponent = light.exponent;
+	}
+	Upload(buffers[BINDING_LIGHTS], this->lights, data, lightsValid);
+}
+
+void UniformBlocks::SetMaterial(const Material& material)
+{
+	SetMaterial(material.kAmbient, material.kDiffuse, material.kSpecular, material.kShininess);
+}
+
+void UniformBlocks::SetMaterial(const glm::vec3& kAmbient, const glm::vec3& kDiffuse, const glm::vec3& kSpecular, float kShininess)
+{
+	MaterialBlock data;
+	memset(&data, 0, sizeof(data));
+	data.kAmbient = kAmbient;
+	data.kShininess = kShininess;
+	data.kDiffuse = kDiffuse;
+	data.kSpecular = kSpecular;
+	Upload(buffers[BINDING_MATERIAL], material, data, materialValid);
+}
@@ -0,0 +1,107 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "Light.h"
+#include "Material.h"
+
+/******************************************************************************/
+/*!
+		Class UniformBlocks:
+\brief	Owns the std140 uniform buffers that every Texture.vertexshader
+		program reads: CameraBlock (view, projection), LightBlock (lights in
+		camera space) and MaterialBlock. They sit on fixed binding points,
+		so switching programs or scenes never re-uploads them, and each
+		Set* call skips the upload when nothing changed.
+*/
+/******************************************************************************/
+class UniformBlocks
+{
+public:
+	enum BINDING_POINT
+	{
+		BINDING_CAMERA = 0,
+		BINDING_LIGHTS,
+		BINDING_MATERIAL,
+	};
+
+	// Must match MAX_LIGHTS in the fragment shaders
+	static const unsigned MAX_LIGHTS = 8;
+
+	static UniformBlocks* GetInstance(void);
+	static void DestroyInstance(void);
+
+	// Point a program's blocks at the shared buffers; call once after LoadShaders
+	void BindProgram(GLuint programID);
+
+	void SetCamera(const glm::mat4& view, const glm::mat4& projection);
+	// Positions and directions are moved into the camera space of view
+	void SetLights(const Light* lights, unsigned count, const glm::mat4& view);
+	void SetMaterial(const Material& material);
+	void SetMaterial(const glm::vec3& kAmbient, const glm::vec3& kDiffuse, const glm::vec3& kSpecular, float kShininess);
+
+	// glBufferSubData calls made, for the render statistics
+	unsigned GetUploadCount(void) const { return uploads; }
+
+private:
+	UniformBlocks(void);
+	~UniformBlocks(void);
+
+	// std140 mirrors of the GLSL blocks; every vec3 is followed by a float
+	// so it fills its 16-byte slot
+	struct LightData
+	{
+		glm::vec3 position_cameraspace;
+		float power;
+		glm::vec3 color;
+		float kC;
+		glm::vec3 spotDirection;
+		float kL;
+		int type;
+		float kQ;
+		float cosCutoff;
+		float cosInner;
+		float exponent;
+		float padding[3];
+	};
+
+	struct LightBlock
+	{
+		LightData lights[MAX_LIGHTS];
+		int numLights;
+		float padding[3];
+	};
+
+	struct MaterialBlock
+	{
+		glm::vec3 kAmbient;
+		float kShininess;
+		glm::vec3 kDiffuse;
+		float padding0;
+		glm::vec3 kSpecular;
+		float padding1;
+	};
+
+	struct CameraBlock
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+	};
+
+	template<typename T>
+	void Upload(GLuint buffer, T& cached, const T& data, bool& valid);
+
+	static UniformBlocks* m_instance;
+
+	GLuint buffers[3];
+	CameraBlock camera;
+	LightBlock lights;
+	MaterialBlock material;
+	bool cameraValid;
+	bool lightsValid;
+	bool materialValid;
+	unsigned uploads;
+};
+
+#endif
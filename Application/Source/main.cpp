@@ -1,11 +1,136 @@
-
-
+#include <cstring>
+#include <cstdlib>
 #include "Application.h"
+#include "MeshCache.h"
+#include "LoadOBJ.h"
+#include "LoadTGA.h"
+#include "TextureCache.h"
+#include "Mesh.h"
+#include "MeshBuilder.h"
+#include "TextRenderer.h"
+#include "StaticBatch.h"
+#include "RenderQueue.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+#include "PhysicsWorld.h"
+#include "CollisionDetection.h"
 
-int main( void )
+int main(int argc, char* argv[])
 {
+	// "-cook a.obj b.obj ..." cooks .mesh files offline instead of running the game
+	if (argc > 1 && strcmp(argv[1], "-cook") == 0)
+		return RunMeshCooker(argc - 2, argv + 2);
+
+	// "-cooktex Images" compresses every TGA in a folder to a mipped .dds
+	if (argc > 1 && strcmp(argv[1], "-cooktex") == 0)
+		return RunTextureCooker(argc - 2, argv + 2);
+
+	// "-objbench Models" times every OBJ in a folder with the old getline/sscanf_s loader and the mapped parser,
+	// then with 1, 2, 4... parse threads; exits non-zero if any two loads differ
+	if (argc > 2 && strcmp(argv[1], "-objbench") == 0)
+		return RunOBJLoadBenchmark(argv[2]) == 0 ? 0 : 1;
+
+	// "-vbocheck Models" compares IndexVBO with the old std::map version; exits non-zero on any difference
+	if (argc > 2 && strcmp(argv[1], "-vbocheck") == 0)
+		return RunIndexVBOChecks(argv[2]) == 0 ? 0 : 1;
+
+	// "-ccdcheck" runs the high-velocity swept collision cases; exits non-zero if any fail
+	if (argc > 1 && strcmp(argv[1], "-ccdcheck") == 0)
+		return RunSweptCollisionChecks() == 0 ? 0 : 1;
+
+	// "-broadbench [projectiles] [targets]" tests projectiles against targets pair by pair and through the spatial hash;
+	// exits non-zero if the two find different overlaps
+	if (argc > 1 && strcmp(argv[1], "-broadbench") == 0)
+		return RunBroadPhaseBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 10000, argc > 3 ? strtoul(argv[3], NULL, 10) : 1000);
+
+	// "-sapbench [balls]" finds ball pit pairs by testing all of them and by sweep and prune, doubling n up to balls;
+	// exits non-zero if the two find different pairs
+	if (argc > 1 && strcmp(argv[1], "-sapbench") == 0)
+		return RunSweepAndPruneBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 5000) == 0 ? 0 : 1;
+
+	// "-physbench [bodies]" steps bodies one PhysicsObject at a time and as a SIMD PhysicsWorld
+	if (argc > 1 && strcmp(argv[1], "-physbench") == 0)
+	{
+		RunPhysicsWorldBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 100000);
+		return 0;
+	}
+
 	Application app;
 	app.Init();
+
+	// "-tgabench Images" times LoadTGA over every TGA in a folder
+	if (argc > 2 && strcmp(argv[1], "-tgabench") == 0)
+	{
+		RunTGABenchmark(argv[2]);
+		app.Exit();
+		return 0;
+	}
+
+	// "-mipbench ground.tga" compares ground tile frame times with and without mipmaps
+	if (argc > 2 && strcmp(argv[1], "-mipbench") == 0)
+	{
+		RunMipBenchmark(argv[2]);
+		app.Exit();
+		return 0;
+	}
+
+	// "-instbench [tiles]" compares one draw call per ground tile with a single instanced draw
+	if (argc > 1 && strcmp(argv[1], "-instbench") == 0)
+	{
+		RunInstancingBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 10000);
+		app.Exit();
+		return 0;
+	}
+
+	// "-textbench [chars]" compares one draw call per HUD character with one batched text draw
+	if (argc > 1 && strcmp(argv[1], "-textbench") == 0)
+	{
+		RunTextBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 5000);
+		app.Exit();
+		return 0;
+	}
+
+	// "-staticbench [props]" compares one draw call per static prop with the baked batches
+	if (argc > 1 && strcmp(argv[1], "-staticbench") == 0)
+	{
+		RunStaticBatchBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 2000);
+		app.Exit();
+		return 0;
+	}
+
+	// "-splitbench [props]" compares one view with two, building the draw list per view and once
+	if (argc > 1 && strcmp(argv[1], "-splitbench") == 0)
+	{
+		RunSplitScreenBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 5000);
+		app.Exit();
+		return 0;
+	}
+
+	// "-lodbench [copies]" draws a row of detailed spheres at full detail and at their selected levels
+	if (argc > 1 && strcmp(argv[1], "-lodbench") == 0)
+	{
+		RunLodBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 200);
+		app.Exit();
+		return 0;
+	}
+
+	// "-primbench [meshes]" builds spheres at the old fixed tessellation, the adaptive one and through the cache
+	if (argc > 1 && strcmp(argv[1], "-primbench") == 0)
+	{
+		RunPrimitiveCacheBenchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 100);
+		app.Exit();
+		return 0;
+	}
+
+	// "-step hz substeps" runs scene physics hz times a second, catching up at most substeps times a frame
+	if (argc > 3 && strcmp(argv[1], "-step") == 0)
+	{
+		double hz = strtod(argv[2], NULL);
+		unsigned substeps = strtoul(argv[3], NULL, 10);
+		if (hz > 0.0 && substeps > 0)
+			app.SetFixedStep(1.0 / hz, substeps);
+	}
+
 	app.Run();
 	app.Exit();
-}
\ No newline at end of file
+}